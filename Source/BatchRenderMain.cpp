@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    BatchRenderMain.cpp
+    Created: 18 Oct 2026 9:34:52pm
+    Author:  David Matthew Welch
+
+    Entry point of the BatchRender console app (BatchRender/BatchRender.jucer).
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "BatchRenderer.h"
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: BatchRender <sweep.json>" << std::endl;
+        return 1;
+    }
+
+    const juce::File specificationFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[1]);
+    juce::String error;
+
+    const auto specification = BatchRenderer::Specification::fromFile(specificationFile, error);
+
+    if (!specification.has_value())
+    {
+        std::cerr << error.toRawUTF8() << std::endl;
+        return 1;
+    }
+
+    const auto summary = BatchRenderer::run(*specification, error);
+
+    if (error.isNotEmpty())
+        std::cerr << error.toRawUTF8() << std::endl;
+
+    std::cout << "Rendered " << summary.numRendered << " files (" << summary.numFailed << " failed), "
+              << summary.audioSeconds << " s of audio in " << summary.wallSeconds << " s: "
+              << summary.getRealtimeMultiple() << "x real time" << std::endl
+              << "Manifest: " << summary.manifest.getFullPathName().toRawUTF8() << std::endl;
+
+    return summary.numFailed == 0 && error.isEmpty() ? 0 : 1;
+}
@@ -0,0 +1,294 @@
+/*
+  ==============================================================================
+
+    BatchRenderer.cpp
+    Created: 18 Oct 2026 9:34:52pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "BatchRenderer.h"
+
+namespace
+{
+    /**
+     * Reads a list of numbers no smaller than minimum, or a single number, from a
+     * JSON property. Leaves the list as it was if the property is missing.
+     */
+    template <typename ValueType>
+    bool readList(const juce::var& json, const juce::Identifier& name, std::vector<ValueType>& list,
+                  ValueType minimum, juce::String& error)
+    {
+        const juce::var property = json.getProperty(name, juce::var());
+
+        if (property.isVoid())
+            return true;
+
+        std::vector<ValueType> values;
+
+        if (const auto* array = property.getArray())
+        {
+            for (const auto& value : *array)
+                values.push_back(static_cast<ValueType>((double)value));
+        }
+        else
+        {
+            values.push_back(static_cast<ValueType>((double)property));
+        }
+
+        for (const auto value : values)
+        {
+            if (value < minimum)
+            {
+                error = "\"" + name.toString() + "\" must be at least " + juce::String(minimum);
+                return false;
+            }
+        }
+
+        if (values.empty())
+        {
+            error = "\"" + name.toString() + "\" must not be empty";
+            return false;
+        }
+
+        list = std::move(values);
+        return true;
+    }
+}
+
+//==============================================================================
+std::optional<BatchRenderer::Specification> BatchRenderer::Specification::fromFile(const juce::File& file, juce::String& error)
+{
+    const juce::var json = juce::JSON::parse(file);
+
+    if (!json.isObject())
+    {
+        error = "Can't read a sweep specification from " + file.getFullPathName();
+        return std::nullopt;
+    }
+
+    const juce::File directory = file.getParentDirectory();
+    Specification specification;
+
+    const juce::String sourcePath = json.getProperty("source", juce::var()).toString();
+
+    if (sourcePath.isEmpty())
+    {
+        error = "The specification has no \"source\"";
+        return std::nullopt;
+    }
+
+    specification.sourceFile = directory.getChildFile(sourcePath);
+    specification.outputDirectory = directory.getChildFile(json.getProperty("output", "renders").toString());
+    specification.sampleRate = (double)json.getProperty("sampleRate", specification.sampleRate);
+    specification.seconds = (double)json.getProperty("seconds", specification.seconds);
+    specification.numChannels = juce::jlimit(1, 2, (int)json.getProperty("channels", specification.numChannels));
+    specification.blockSize = juce::jmax(1, (int)json.getProperty("blockSize", specification.blockSize));
+    specification.seed = (juce::int64)json.getProperty("seed", specification.seed);
+    specification.numThreads = juce::jmax(0, (int)json.getProperty("threads", specification.numThreads));
+
+    if (specification.sampleRate <= 0.0 || specification.seconds <= 0.0)
+    {
+        error = "\"sampleRate\" and \"seconds\" must be positive";
+        return std::nullopt;
+    }
+
+    if (!readList(json, "grainSize", specification.grainSizes, 1, error)
+        || !readList(json, "grainOverlap", specification.grainOverlaps, 0, error)
+        || !readList(json, "grainSpacing", specification.grainSpacings, 0, error)
+        || !readList(json, "pitch", specification.pitches, std::numeric_limits<float>::lowest(), error))
+        return std::nullopt;
+
+    // Grains start size - overlap + spacing samples apart, which must be positive in every combination
+    const int shortestInterval = *std::min_element(specification.grainSizes.begin(), specification.grainSizes.end())
+                               - *std::max_element(specification.grainOverlaps.begin(), specification.grainOverlaps.end())
+                               + *std::min_element(specification.grainSpacings.begin(), specification.grainSpacings.end());
+
+    if (shortestInterval <= 0)
+    {
+        error = "Every \"grainOverlap\" must be less than every \"grainSize\" plus \"grainSpacing\", "
+                "so that grains start a positive number of samples apart";
+        return std::nullopt;
+    }
+
+    return specification;
+}
+
+//==============================================================================
+BatchRenderer::Summary BatchRenderer::run(const Specification& specification, juce::String& error)
+{
+    Summary summary;
+    const double startTime = juce::Time::getMillisecondCounterHiRes();
+
+    if (!specification.outputDirectory.isDirectory() && specification.outputDirectory.createDirectory().failed())
+    {
+        error = "Can't create " + specification.outputDirectory.getFullPathName();
+        return summary;
+    }
+
+    // Decode once; every render reads the same pooled buffer
+    juce::SharedResourcePointer<SamplePool> samplePool;
+    SourceBuffer::Ptr source = samplePool->getOrLoad(specification.sourceFile, specification.sampleRate);
+
+    if (source == nullptr || !source->waitUntilLoaded())
+    {
+        error = "Can't read " + specification.sourceFile.getFullPathName();
+        return summary;
+    }
+
+    std::vector<Combination> combinations;
+
+    for (const int grainSize : specification.grainSizes)
+        for (const int grainOverlap : specification.grainOverlaps)
+            for (const int grainSpacing : specification.grainSpacings)
+                for (const float pitch : specification.pitches)
+                    combinations.push_back({ (int)combinations.size(), grainSize, grainOverlap, grainSpacing, pitch });
+
+    std::vector<Render> renders(combinations.size());
+    std::atomic<int> numRemaining { (int)combinations.size() };
+    juce::WaitableEvent allFinished;
+
+    {
+        const int numThreads = specification.numThreads > 0 ? specification.numThreads
+                                                             : juce::SystemStats::getNumCpus();
+        juce::ThreadPool workers(numThreads);
+
+        for (size_t i = 0; i < combinations.size(); ++i)
+        {
+            workers.addJob([&, i]
+            {
+                renders[i] = renderCombination(specification, combinations[i], source);
+
+                if (numRemaining.fetch_sub(1) == 1)
+                    allFinished.signal();
+            });
+        }
+
+        if (!combinations.empty())
+            allFinished.wait();
+    }
+
+    for (const auto& render : renders)
+    {
+        if (render.succeeded)
+        {
+            ++summary.numRendered;
+            summary.audioSeconds += specification.seconds;
+        }
+        else
+        {
+            ++summary.numFailed;
+        }
+    }
+
+    summary.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    summary.manifest = specification.outputDirectory.getChildFile("manifest.json");
+
+    if (!writeManifest(specification, renders, summary, summary.manifest))
+        error = "Can't write " + summary.manifest.getFullPathName();
+
+    return summary;
+}
+
+BatchRenderer::Render BatchRenderer::renderCombination(const Specification& specification, const Combination& combination,
+                                                       const SourceBuffer::Ptr& source)
+{
+    Render render;
+    render.combination = combination;
+
+    const double startTime = juce::Time::getMillisecondCounterHiRes();
+    const int numChannels = specification.numChannels;
+    const int numSamples = juce::roundToInt(specification.seconds * specification.sampleRate);
+
+    GranSynth synth;
+    synth.setRandomSeed(specification.seed + combination.index);
+    synth.prepareToPlay(specification.sampleRate, specification.blockSize, numChannels);
+    synth.getGovernor().setEnabled(false);
+    synth.setGrainParameters(combination.grainSize, combination.grainOverlap, combination.grainSpacing);
+    synth.setPitchShift(combination.pitch);
+    synth.swapSource(source);
+
+    juce::AudioBuffer<float> output(numChannels, numSamples);
+    juce::MidiBuffer midiMessages;
+
+    for (int position = 0; position < numSamples; position += specification.blockSize)
+    {
+        const int blockLength = juce::jmin(specification.blockSize, numSamples - position);
+        juce::AudioBuffer<float> block(output.getArrayOfWritePointers(), numChannels, position, blockLength);
+
+        synth.processBlock(block, midiMessages);
+    }
+
+    synth.releaseResources();
+
+    render.peak = output.getMagnitude(0, numSamples);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        render.rms += output.getRMSLevel(channel, 0, numSamples) / (float)numChannels;
+
+    const juce::String name = juce::String(combination.index + 1).paddedLeft('0', 4)
+                            + "_" + specification.sourceFile.getFileNameWithoutExtension()
+                            + "_size" + juce::String(combination.grainSize)
+                            + "_overlap" + juce::String(combination.grainOverlap)
+                            + "_spacing" + juce::String(combination.grainSpacing)
+                            + "_pitch" + (combination.pitch >= 0.0f ? "+" : "") + juce::String(combination.pitch, 2)
+                            + ".wav";
+
+    render.file = specification.outputDirectory.getChildFile(name);
+    render.file.deleteFile();
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::OutputStream> stream(render.file.createOutputStream());
+
+    if (stream != nullptr)
+    {
+        std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(stream.get(), specification.sampleRate,
+                                                                                  (unsigned int)numChannels, 24, {}, 0));
+
+        if (writer != nullptr)
+        {
+            // The writer owns the stream from here on
+            stream.release();
+            render.succeeded = writer->writeFromAudioSampleBuffer(output, 0, numSamples);
+        }
+    }
+
+    render.renderMs = juce::Time::getMillisecondCounterHiRes() - startTime;
+    return render;
+}
+
+bool BatchRenderer::writeManifest(const Specification& specification, const std::vector<Render>& renders,
+                                  const Summary& summary, const juce::File& file)
+{
+    juce::Array<juce::var> entries;
+
+    for (const auto& render : renders)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("file", render.file.getFileName());
+        entry->setProperty("succeeded", render.succeeded);
+        entry->setProperty("grainSize", render.combination.grainSize);
+        entry->setProperty("grainOverlap", render.combination.grainOverlap);
+        entry->setProperty("grainSpacing", render.combination.grainSpacing);
+        entry->setProperty("pitch", render.combination.pitch);
+        entry->setProperty("seed", specification.seed + render.combination.index);
+        entry->setProperty("peak", render.peak);
+        entry->setProperty("rms", render.rms);
+        entry->setProperty("renderMs", render.renderMs);
+        entries.add(juce::var(entry));
+    }
+
+    auto* manifest = new juce::DynamicObject();
+    manifest->setProperty("source", specification.sourceFile.getFullPathName());
+    manifest->setProperty("sampleRate", specification.sampleRate);
+    manifest->setProperty("seconds", specification.seconds);
+    manifest->setProperty("channels", specification.numChannels);
+    manifest->setProperty("rendered", summary.numRendered);
+    manifest->setProperty("failed", summary.numFailed);
+    manifest->setProperty("wallSeconds", summary.wallSeconds);
+    manifest->setProperty("realtimeMultiple", summary.getRealtimeMultiple());
+    manifest->setProperty("renders", entries);
+
+    return file.replaceWithText(juce::JSON::toString(juce::var(manifest)));
+}
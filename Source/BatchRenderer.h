@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    BatchRenderer.h
+    Created: 18 Oct 2026 9:34:52pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GranSynth.h"
+
+/**
+ * Renders one source across a grid of grain parameters, for building variation
+ * libraries offline.
+ *
+ * The source is decoded once through the sample pool and shared read-only by
+ * every render. Each combination renders on its own GranSynth, and renders are
+ * spread across a thread pool with one thread per core by default. Each render
+ * writes one WAV file, and a manifest.json in the output directory lists every
+ * file with its parameters and levels.
+ *
+ * A sweep is described in JSON. Relative paths are resolved against the
+ * specification's own directory:
+ *
+ *     {
+ *         "source": "texture.wav",
+ *         "output": "renders",
+ *         "sampleRate": 48000,
+ *         "seconds": 10,
+ *         "channels": 2,
+ *         "seed": 1,
+ *         "threads": 0,
+ *         "grainSize": [256, 512, 1024],
+ *         "grainOverlap": [128, 256],
+ *         "grainSpacing": [0, 64],
+ *         "pitch": [-12, 0, 7]
+ *     }
+ *
+ * Pitch is in semitones. Any list may be omitted, which keeps the engine's
+ * default for that parameter. Grain sizes must be at least 1, and every overlap
+ * less than every size plus spacing, so grains always start samples apart.
+ */
+class BatchRenderer
+{
+public:
+    /** The parameter grid and render settings of a sweep. */
+    struct Specification
+    {
+        juce::File sourceFile;
+        juce::File outputDirectory;
+        double sampleRate = 48000.0;
+        double seconds = 10.0;
+        int numChannels = 2;
+        int blockSize = 512;
+        juce::int64 seed = 1;           // Each render is seeded with seed plus its index
+        int numThreads = 0;             // 0 for one per core
+
+        std::vector<int> grainSizes { 512 };
+        std::vector<int> grainOverlaps { 256 };
+        std::vector<int> grainSpacings { 0 };
+        std::vector<float> pitches { 0.0f };
+
+        /**
+         * Reads a specification from a JSON file.
+         *
+         * @param file   The JSON file.
+         * @param error  Set to a description of the problem if reading fails.
+         * @return       The specification, or std::nullopt if the file is invalid.
+         */
+        static std::optional<Specification> fromFile(const juce::File& file, juce::String& error);
+    };
+
+    /** The outcome of a sweep. */
+    struct Summary
+    {
+        int numRendered = 0;
+        int numFailed = 0;
+        double audioSeconds = 0.0;      // Total length of audio rendered
+        double wallSeconds = 0.0;       // Time the sweep took
+        juce::File manifest;
+
+        /** Audio rendered per second of wall-clock time. */
+        double getRealtimeMultiple() const { return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0; }
+    };
+
+    /**
+     * Runs a sweep and blocks until every render has finished.
+     *
+     * @param specification  The sweep to run.
+     * @param error          Set to a description of the problem if the sweep can't start.
+     * @return               What was rendered.
+     */
+    static Summary run(const Specification& specification, juce::String& error);
+
+private:
+    /** One point of the parameter grid. */
+    struct Combination
+    {
+        int index = 0;
+        int grainSize = 0;
+        int grainOverlap = 0;
+        int grainSpacing = 0;
+        float pitch = 0.0f;
+    };
+
+    /** What one render produced, for the manifest. */
+    struct Render
+    {
+        Combination combination;
+        juce::File file;
+        float peak = 0.0f;
+        float rms = 0.0f;
+        double renderMs = 0.0;
+        bool succeeded = false;
+    };
+
+    /**
+     * Renders one combination on its own engine and writes it to a file.
+     */
+    static Render renderCombination(const Specification& specification, const Combination& combination,
+                                    const SourceBuffer::Ptr& source);
+
+    /**
+     * Writes the manifest describing every render.
+     */
+    static bool writeManifest(const Specification& specification, const std::vector<Render>& renders,
+                              const Summary& summary, const juce::File& file);
+
+    BatchRenderer() = delete;
+};
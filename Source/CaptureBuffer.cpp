@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    CaptureBuffer.cpp
+    Created: 18 Oct 2026 11:02:37am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "CaptureBuffer.h"
+
+namespace
+{
+    void copySamples(float* destination, const float* source, int numSamples)
+    {
+        juce::FloatVectorOperations::copy(destination, source, numSamples);
+    }
+
+    void copySamples(float* destination, const double* source, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            destination[i] = static_cast<float>(source[i]);
+    }
+}
+
+void CaptureBuffer::prepare(int numChannels, int capacityInSamples)
+{
+    buffer.setSize(numChannels, capacityInSamples);
+    buffer.clear();
+    writePosition = 0;
+    numValidSamples = 0;
+    numSilentSamples = capacityInSamples;
+}
+
+template <typename SampleType>
+void CaptureBuffer::write(const juce::AudioBuffer<SampleType>& input)
+{
+    const int capacity = buffer.getNumSamples();
+
+    if (frozen || capacity == 0)
+        return;
+
+    // Only the most recent capacity samples of an oversized block can be kept
+    const int numInputSamples = input.getNumSamples();
+    const int numToWrite = juce::jmin(numInputSamples, capacity);
+    const int inputOffset = numInputSamples - numToWrite;
+
+    const int firstPart = juce::jmin(numToWrite, capacity - writePosition);
+    const int secondPart = numToWrite - firstPart;
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        float* destination = buffer.getWritePointer(channel);
+
+        if (input.getNumChannels() == 0)
+        {
+            juce::FloatVectorOperations::clear(destination + writePosition, firstPart);
+            juce::FloatVectorOperations::clear(destination, secondPart);
+            continue;
+        }
+
+        const SampleType* inputData = input.getReadPointer(juce::jmin(channel, input.getNumChannels() - 1), inputOffset);
+
+        copySamples(destination + writePosition, inputData, firstPart);
+        copySamples(destination, inputData + firstPart, secondPart);
+    }
+
+    // A block with any sound in it restarts the count, even if it ends quietly
+    if (input.getNumChannels() == 0 || input.getMagnitude(inputOffset, numToWrite) <= silenceThreshold)
+        numSilentSamples = juce::jmin(capacity, numSilentSamples + numToWrite);
+    else
+        numSilentSamples = 0;
+
+    writePosition = (writePosition + numToWrite) % capacity;
+    numValidSamples = juce::jmin(capacity, numValidSamples + numToWrite);
+}
+
+template void CaptureBuffer::write<float>(const juce::AudioBuffer<float>&);
+template void CaptureBuffer::write<double>(const juce::AudioBuffer<double>&);
+
+GrainSource CaptureBuffer::getSource() const
+{
+    return { buffer.getArrayOfReadPointers(), buffer.getNumChannels(), buffer.getNumSamples() };
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    CaptureBuffer.h
+    Created: 18 Oct 2026 11:02:37am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Grain.h"
+
+/**
+ * A preallocated circular buffer holding the most recent host input.
+ *
+ * The audio thread writes each block with at most two straight copies per
+ * channel, and grains read from it in place through getSource(), relying on
+ * GrainSource's wrap-around reads. While frozen, writes are skipped so the
+ * captured audio can be granulated indefinitely.
+ *
+ * The buffer also tracks how much silence has been written since the last
+ * sound, so the engine can tell when every grain would read silence.
+ */
+class CaptureBuffer
+{
+public:
+    static constexpr float silenceThreshold = 1.0e-6f;  // Input peaks at or below this count as silence (-120 dB)
+
+    /**
+     * Allocates the buffer. Must not be called while the audio thread is writing.
+     *
+     * @param numChannels        The number of channels to capture.
+     * @param capacityInSamples  The number of samples of history to keep.
+     */
+    void prepare(int numChannels, int capacityInSamples);
+
+    /**
+     * Appends a block of input to the buffer, unless it is frozen. If the input
+     * has fewer channels than the buffer, its last channel is repeated.
+     *
+     * @param input  The host input for this block.
+     *
+     * Instantiated for float and double input; double input is narrowed to float.
+     */
+    template <typename SampleType>
+    void write(const juce::AudioBuffer<SampleType>& input);
+
+    /**
+     * Stops or resumes writing.
+     */
+    void setFrozen(bool shouldBeFrozen) { frozen = shouldBeFrozen; }
+    bool isFrozen() const               { return frozen; }
+
+    /**
+     * Returns the index one past the most recently written sample.
+     */
+    int getWritePosition() const { return writePosition; }
+
+    /**
+     * Returns how many samples of valid history the buffer currently holds.
+     */
+    int getNumValidSamples() const { return numValidSamples; }
+
+    /**
+     * Returns true if nothing above the silence threshold is left anywhere in the buffer.
+     */
+    bool isSilent() const { return numSilentSamples >= buffer.getNumSamples(); }
+
+    /**
+     * Returns a wrap-aware view of the buffer for grains to read from.
+     */
+    GrainSource getSource() const;
+
+    /**
+     * Returns the memory held for the captured audio.
+     */
+    juce::int64 getSizeInBytes() const { return (juce::int64)buffer.getNumChannels() * buffer.getNumSamples() * (juce::int64)sizeof(float); }
+
+private:
+    juce::AudioBuffer<float> buffer;
+    int writePosition = 0;
+    int numValidSamples = 0;
+    int numSilentSamples = 0;   // Silence written since the last sound, up to the capacity
+    bool frozen = false;
+};
@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    CloudBaker.cpp
+    Created: 19 Oct 2026 12:41:17am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "CloudBaker.h"
+#include "GranSynth.h"
+
+//==============================================================================
+CloudBaker::CloudBaker()
+    : juce::Thread("Cloud baker")
+{
+}
+
+CloudBaker::~CloudBaker()
+{
+    cancel();
+}
+
+void CloudBaker::bake(Request request)
+{
+    stopThread(2000);
+
+    pending = std::move(request);
+    baking = true;
+
+    if (!startThread(juce::Thread::Priority::low))
+        baking = false;
+}
+
+void CloudBaker::cancel()
+{
+    stopThread(2000);
+    pending = {};
+
+    BakedCloud::Ptr cloud;
+
+    while (pop(cloud))
+        cloud = nullptr;
+}
+
+bool CloudBaker::pop(BakedCloud::Ptr& cloud) noexcept
+{
+    const auto scope = fifo.read(1);
+    BakedCloud::Ptr* slot = nullptr;
+
+    if (scope.blockSize1 > 0)
+        slot = &finished[(size_t)scope.startIndex1];
+    else if (scope.blockSize2 > 0)
+        slot = &finished[(size_t)scope.startIndex2];
+    else
+        return false;
+
+    // Moving leaves the slot empty without touching the count
+    cloud = std::move(*slot);
+    return true;
+}
+
+void CloudBaker::run()
+{
+    auto cloud = render(pending);
+
+    // The bake thread is the only producer. The request's source reference is
+    // dropped here, not on the audio thread.
+    pending.source = nullptr;
+
+    if (cloud != nullptr)
+    {
+        const auto scope = fifo.write(1);
+
+        if (scope.blockSize1 > 0)
+            finished[(size_t)scope.startIndex1] = std::move(cloud);
+        else if (scope.blockSize2 > 0)
+            finished[(size_t)scope.startIndex2] = std::move(cloud);
+        else
+            DBG("Cloud baker queue is full; the baked cloud was dropped.");
+    }
+
+    baking = false;
+}
+
+BakedCloud::Ptr CloudBaker::render(const Request& request)
+{
+    if (request.source == nullptr || request.numChannels <= 0 || request.configure == nullptr)
+        return nullptr;
+
+    // A bake may be asked for while the file is still decoding
+    while (!request.source->waitUntilLoaded(100))
+        if (threadShouldExit() || request.source->hasLoadFailed())
+            return nullptr;
+
+    const int loopLength = juce::roundToInt(request.seconds * request.sampleRate);
+    const int fadeLength = juce::jmin(juce::roundToInt(crossfadeSeconds * request.sampleRate), loopLength / 2);
+    const int warmUpLength = juce::roundToInt(warmUpSeconds * request.sampleRate);
+    const int totalLength = warmUpLength + loopLength + fadeLength;
+
+    if (loopLength <= 0)
+        return nullptr;
+
+    GranSynth synth;
+    synth.setRandomSeed(request.seed);
+    synth.prepareToPlay(request.sampleRate, request.blockSize, request.numChannels);
+    synth.getGovernor().setEnabled(false);
+    request.configure(synth);
+    synth.setPsolaNotePitch(request.notePitch);
+    synth.swapSource(request.source);
+
+    juce::AudioBuffer<float> rendered(request.numChannels, totalLength);
+    juce::MidiBuffer noMidi;
+
+    for (int position = 0; position < totalLength; position += request.blockSize)
+    {
+        if (threadShouldExit())
+            return nullptr;
+
+        const int blockLength = juce::jmin(request.blockSize, totalLength - position);
+        juce::AudioBuffer<float> block(rendered.getArrayOfWritePointers(), request.numChannels, position, blockLength);
+
+        synth.processBlock(block, noMidi);
+    }
+
+    BakedCloud::Ptr cloud = new BakedCloud();
+    cloud->parameterGeneration = request.parameterGeneration;
+    cloud->loop.setSize(request.numChannels, loopLength);
+
+    for (int channel = 0; channel < request.numChannels; ++channel)
+    {
+        const float* body = rendered.getReadPointer(channel, warmUpLength);
+        const float* overrun = rendered.getReadPointer(channel, warmUpLength + loopLength);
+        float* loop = cloud->loop.getWritePointer(channel);
+
+        juce::FloatVectorOperations::copy(loop, body, loopLength);
+
+        // The overrun carries on from the loop's last sample, so fading it out over the
+        // start makes the wrap continuous. The two are uncorrelated, hence equal power.
+        for (int i = 0; i < fadeLength; ++i)
+        {
+            const float angle = juce::MathConstants<float>::halfPi * (float)i / (float)fadeLength;
+            loop[i] = body[i] * std::sin(angle) + overrun[i] * std::cos(angle);
+        }
+    }
+
+    return cloud;
+}
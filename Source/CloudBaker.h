@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    CloudBaker.h
+    Created: 19 Oct 2026 12:41:17am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SourceBuffer.h"
+
+class GranSynth;
+
+/**
+ * A stretch of a grain cloud rendered ahead of time, whose end crossfades into
+ * its start so it can be looped without a seam.
+ */
+struct BakedCloud : public juce::ReferenceCountedObject
+{
+    using Ptr = juce::ReferenceCountedObjectPtr<BakedCloud>;
+
+    juce::AudioBuffer<float> loop;
+    juce::uint32 parameterGeneration = 0;   // The engine's parameter generation the cloud was baked at
+
+    juce::int64 getSizeInBytes() const { return (juce::int64)loop.getNumChannels() * loop.getNumSamples() * (juce::int64)sizeof(float); }
+};
+
+/**
+ * Renders a static grain cloud into a BakedCloud on a background thread.
+ *
+ * The cloud is rendered by a private engine set up like the live one, so while
+ * the parameters stay put the live engine can play the loop back instead of
+ * rendering hundreds of grains. The render starts with a warm-up, so the loop
+ * begins at full density, and runs a crossfade past the loop length, which is
+ * then mixed over the loop's start with an equal-power fade.
+ *
+ * Thread ownership: bake() and cancel() are for the message thread. Finished
+ * clouds are handed to the audio thread through a single-producer,
+ * single-consumer queue that the bake thread fills and pop() drains.
+ */
+class CloudBaker : private juce::Thread
+{
+public:
+    static constexpr double warmUpSeconds = 0.5;        // Rendered and discarded while the cloud fills in
+    static constexpr double crossfadeSeconds = 0.5;     // Longest seam fade, at most half the loop
+    static constexpr int capacity = 4;                  // Finished clouds waiting for the audio thread
+
+    /** Everything needed to render a cloud like the live engine's. */
+    struct Request
+    {
+        SourceBuffer::Ptr source;                   // The source to granulate
+        double sampleRate = 44100.0;
+        int blockSize = 512;
+        int numChannels = 2;
+        double seconds = 4.0;                       // Length of the loop
+        juce::int64 seed = 0;
+        juce::uint32 parameterGeneration = 0;       // Stamped onto the result
+        float notePitch = 1.0f;                     // Pitch of the last note, which retunes PSOLA clouds
+        std::function<void(GranSynth&)> configure;  // Applies the live parameters; called on the bake thread
+    };
+
+    /**
+     * Constructor for the CloudBaker class.
+     */
+    CloudBaker();
+
+    /**
+     * Destructor for the CloudBaker class. Abandons any bake in progress.
+     */
+    ~CloudBaker() override;
+
+    /**
+     * Starts baking a cloud, abandoning any bake already in progress.
+     *
+     * @param request  What to render.
+     */
+    void bake(Request request);
+
+    /**
+     * Abandons any bake in progress and drops finished clouds the audio thread
+     * hasn't taken. Call only while the audio thread is stopped, or from its
+     * owner's destructor.
+     */
+    void cancel();
+
+    /**
+     * Returns true while a bake is in progress. Safe to call from any thread.
+     */
+    bool isBaking() const noexcept { return baking.load(std::memory_order_relaxed); }
+
+    /**
+     * Takes the oldest finished cloud, if there is one. Called from the audio
+     * thread only.
+     *
+     * @param cloud  Receives the cloud. It must be null on entry, and the caller
+     *               must hand it to a release thread rather than drop it.
+     * @return       False if there was nothing finished.
+     */
+    bool pop(BakedCloud::Ptr& cloud) noexcept;
+
+private:
+    Request pending;                            // Set while the thread is stopped
+    std::atomic<bool> baking { false };
+
+    juce::AbstractFifo fifo { capacity };
+    std::array<BakedCloud::Ptr, capacity> finished;
+
+    void run() override;
+
+    /**
+     * Renders the request into a seamless loop, or returns nullptr if the bake was
+     * abandoned or there was nothing to render.
+     */
+    BakedCloud::Ptr render(const Request& request);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CloudBaker)
+};
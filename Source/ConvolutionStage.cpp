@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    ConvolutionStage.cpp
+    Created: 19 Oct 2026 12:14:05am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "ConvolutionStage.h"
+
+namespace
+{
+    constexpr double fadeSeconds = 0.05;    // Ramp time for enabling, disabling and mix changes
+
+    template <typename SampleType>
+    void copyToFloat(const SampleType* source, float* destination, int numSamples) noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            juce::FloatVectorOperations::copy(destination, source, numSamples);
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = static_cast<float>(source[i]);
+        }
+    }
+}
+
+//==============================================================================
+ConvolutionStage::ConvolutionStage()
+    : convolution(juce::dsp::Convolution::NonUniform { tailPartitionSize }, *loadQueue)
+{
+}
+
+void ConvolutionStage::prepare(double sampleRate, int maxBlockSize, int numChannels)
+{
+    currentSampleRate = sampleRate;
+    maxPieceSize = juce::jmax(1, maxBlockSize);
+    numWetChannels = juce::jlimit(0, maxChannels, numChannels);
+
+    wetBuffer.setSize(juce::jmax(1, numWetChannels), maxPieceSize);
+    gains.assign((size_t)maxPieceSize, 0.0f);
+
+    convolution.prepare({ sampleRate, (juce::uint32)maxPieceSize, (juce::uint32)juce::jmax(1, numWetChannels) });
+
+    wetGain.reset(sampleRate, fadeSeconds);
+    wetGain.setCurrentAndTargetValue(0.0f);
+    needsReset = false;
+}
+
+void ConvolutionStage::loadImpulseResponse(const juce::File& file)
+{
+    impulseFile = file;
+
+    // The length limit counts samples at the file's rate, which isn't known until it is read
+    constexpr double highestFileRate = 96000.0;
+    const auto maxSize = (size_t)(maxImpulseSeconds * highestFileRate);
+
+    // Decoded, trimmed, partitioned and transformed on the shared background thread
+    convolution.loadImpulseResponse(file, juce::dsp::Convolution::Stereo::yes, juce::dsp::Convolution::Trim::yes,
+                                    maxSize, juce::dsp::Convolution::Normalise::yes);
+    hasImpulse.store(true, std::memory_order_release);
+}
+
+double ConvolutionStage::getImpulseResponseSeconds() const
+{
+    return currentSampleRate > 0.0 ? impulseSize.load(std::memory_order_relaxed) / currentSampleRate : 0.0;
+}
+
+juce::int64 ConvolutionStage::getSizeInBytes() const
+{
+    // Each channel keeps the transformed IR and a delay line of transformed input,
+    // each about twice the IR length in complex values
+    return (juce::int64)impulseSize.load(std::memory_order_relaxed) * juce::jmax(1, numWetChannels)
+         * 8 * (juce::int64)sizeof(float)
+         + wetBuffer.getAllocatedBytes() + (juce::int64)(gains.size() * sizeof(float));
+}
+
+void ConvolutionStage::setParameters(bool enabled, float wetMix) noexcept
+{
+    isEnabled = enabled;
+    mix = juce::jlimit(0.0f, 1.0f, wetMix);
+}
+
+template <typename SampleType>
+void ConvolutionStage::process(juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    if (numWetChannels == 0)
+        return;
+
+    const bool convolving = isEnabled && hasImpulse.load(std::memory_order_acquire);
+    wetGain.setTargetValue(convolving ? mix : 0.0f);
+
+    // Fully dry: skip the convolver, and forget its tail so it doesn't reappear later
+    if (!wetGain.isSmoothing() && wetGain.getCurrentValue() == 0.0f)
+    {
+        needsReset = true;
+        return;
+    }
+
+    if (needsReset)
+    {
+        convolution.reset();
+        needsReset = false;
+    }
+
+    const int numChannels = juce::jmin(buffer.getNumChannels(), numWetChannels);
+    const int numSamples = buffer.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += maxPieceSize)
+    {
+        const int pieceSize = juce::jmin(maxPieceSize, numSamples - start);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            copyToFloat(buffer.getReadPointer(channel, start), wetBuffer.getWritePointer(channel), pieceSize);
+
+        juce::dsp::AudioBlock<float> block(wetBuffer.getArrayOfWritePointers(), (size_t)numChannels, (size_t)pieceSize);
+        convolution.process(juce::dsp::ProcessContextReplacing<float>(block));
+
+        for (int i = 0; i < pieceSize; ++i)
+            gains[(size_t)i] = wetGain.getNextValue();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            SampleType* out = buffer.getWritePointer(channel, start);
+            const float* wet = wetBuffer.getReadPointer(channel);
+
+            for (int i = 0; i < pieceSize; ++i)
+                out[i] += static_cast<SampleType>((wet[i] - static_cast<float>(out[i])) * gains[(size_t)i]);
+        }
+    }
+
+    impulseSize.store(convolution.getCurrentIRSize(), std::memory_order_relaxed);
+}
+
+template void ConvolutionStage::process<float>(juce::AudioBuffer<float>&) noexcept;
+template void ConvolutionStage::process<double>(juce::AudioBuffer<double>&) noexcept;
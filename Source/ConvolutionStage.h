@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    ConvolutionStage.h
+    Created: 19 Oct 2026 12:14:05am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * An optional convolution reverb after the grain engine, so a cloud can be
+ * given a room or a body without a separate plugin.
+ *
+ * Built on juce::dsp::Convolution with a non-uniform partition: the head of the
+ * impulse response runs in block-sized partitions with no added latency, and
+ * the tail in partitions of tailPartitionSize, so a long IR costs one spectral
+ * multiply-add per tail partition per block rather than one per block-sized
+ * partition. The frequency-domain delay lines are allocated when an IR is
+ * loaded, never on the audio thread.
+ *
+ * Impulse responses load on a background thread shared by every instance in
+ * the process; the new IR is swapped in at the start of a block once it is
+ * ready. Enabling, disabling and the wet mix are smoothed, and the convolver
+ * is skipped entirely once the stage has faded to dry.
+ *
+ * Thread ownership: process() and setParameters() are for the audio thread;
+ * everything else is for the message thread.
+ */
+class ConvolutionStage
+{
+public:
+    static constexpr int tailPartitionSize = 4096;      // Partition size after the zero-latency head
+    static constexpr int maxImpulseSeconds = 20;        // Longer IRs are truncated
+    static constexpr int maxChannels = 2;               // The convolver is mono or stereo; other channels stay dry
+
+    /**
+     * Constructor for the ConvolutionStage class.
+     */
+    ConvolutionStage();
+
+    /**
+     * Prepares the convolver and the wet buffer. Call before playback.
+     *
+     * @param sampleRate    The sample rate.
+     * @param maxBlockSize  The largest block process() will be given at once; bigger
+     *                      blocks are processed in pieces.
+     * @param numChannels   The number of output channels.
+     */
+    void prepare(double sampleRate, int maxBlockSize, int numChannels);
+
+    /**
+     * Starts loading an impulse response on the background thread. Silence at
+     * its end is trimmed and its level normalised. The previous IR keeps
+     * playing until the new one is ready.
+     *
+     * @param file  An audio file, mono or stereo.
+     */
+    void loadImpulseResponse(const juce::File& file);
+
+    /**
+     * Returns the file of the most recently requested impulse response, or an
+     * empty File if there is none.
+     */
+    const juce::File& getImpulseResponseFile() const noexcept { return impulseFile; }
+
+    /**
+     * Returns the length in seconds of the impulse response in use, or 0 if none
+     * has loaded yet.
+     */
+    double getImpulseResponseSeconds() const;
+
+    /**
+     * Returns a rough count of the bytes held by the convolver's partitions and
+     * delay lines for the impulse response in use.
+     */
+    juce::int64 getSizeInBytes() const;
+
+    /**
+     * Sets whether the stage is on and how much of the convolved signal to mix in.
+     *
+     * @param enabled  Whether to convolve.
+     * @param wetMix   0 for dry only, 1 for the convolved signal only.
+     */
+    void setParameters(bool enabled, float wetMix) noexcept;
+
+    /**
+     * Convolves a block in place and mixes it with the dry signal.
+     */
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+private:
+    juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue> loadQueue;     // Background IR loading, shared by every instance
+    juce::dsp::Convolution convolution;
+
+    juce::AudioBuffer<float> wetBuffer;         // The convolved copy of each piece of a block
+    std::vector<float> gains;                   // Per-sample wet gain, shared by every channel
+    juce::SmoothedValue<float> wetGain;         // Fades the stage in, out and between mixes
+
+    juce::File impulseFile;                     // Message thread only
+    double currentSampleRate = 0.0;
+    int maxPieceSize = 0;
+    int numWetChannels = 0;
+
+    std::atomic<bool> hasImpulse { false };     // Set once an IR has been requested
+    std::atomic<int> impulseSize { 0 };         // Length of the IR in use, published by the audio thread
+    bool isEnabled = false;                     // Audio thread only
+    float mix = 0.0f;                           // Audio thread only
+    bool needsReset = false;                    // Clear stale tails before fading back in
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionStage)
+};
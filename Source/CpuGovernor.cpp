@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    CpuGovernor.cpp
+    Created: 18 Oct 2026 3:15:48pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "CpuGovernor.h"
+
+void CpuGovernor::prepare(double newSampleRate, int samplesPerBlock)
+{
+    juce::ignoreUnused(samplesPerBlock);
+
+    sampleRate = newSampleRate;
+    smoothedLoad = 0.0f;
+    level = 0;
+    blocksOverBudget = 0;
+    blocksUnderRecovery = 0;
+    spawnsThisBlock = 0;
+    droppedSpawns = 0;
+    fadedGrains = 0;
+
+    publishedLoad = 0.0f;
+    publishedPeakLoad = 0.0f;
+    publishedLevel = 0;
+    publishedActiveGrains = 0;
+    publishedDroppedSpawns = 0;
+    publishedFadedGrains = 0;
+}
+
+void CpuGovernor::setSettings(const Settings& newSettings)
+{
+    settings = newSettings;
+    settings.ladderLength = juce::jlimit(0, maxLadderLength, settings.ladderLength);
+    level = juce::jmin(level, settings.ladderLength);
+}
+
+void CpuGovernor::setEnabled(bool shouldBeEnabled)
+{
+    enabled = shouldBeEnabled;
+
+    if (!enabled)
+        level = 0;
+}
+
+void CpuGovernor::beginBlock()
+{
+    blockStartTicks = juce::Time::getHighResolutionTicks();
+    spawnsThisBlock = 0;
+}
+
+void CpuGovernor::endBlock(int numSamples, int activeGrains)
+{
+    if (numSamples <= 0)
+        return;
+
+    // The deadline is the real time the block represents
+    const double elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks);
+    const float load = static_cast<float>(elapsed * sampleRate / numSamples);
+
+    smoothedLoad += settings.smoothing * (load - smoothedLoad);
+
+    if (enabled)
+    {
+        // Step down quickly when over budget, but only step back up after a sustained
+        // period of headroom so the texture doesn't flicker between levels
+        if (smoothedLoad > settings.targetLoad)
+        {
+            blocksUnderRecovery = 0;
+
+            if (++blocksOverBudget >= settings.blocksBeforeEscalating && level < settings.ladderLength)
+            {
+                ++level;
+                blocksOverBudget = 0;
+            }
+        }
+        else if (smoothedLoad < settings.recoveryLoad)
+        {
+            blocksOverBudget = 0;
+
+            if (++blocksUnderRecovery >= settings.blocksBeforeRecovering && level > 0)
+            {
+                --level;
+                blocksUnderRecovery = 0;
+            }
+        }
+        else
+        {
+            blocksOverBudget = 0;
+            blocksUnderRecovery = 0;
+        }
+    }
+
+    publishedLoad.store(smoothedLoad, std::memory_order_relaxed);
+    publishedPeakLoad.store(juce::jmax(load, publishedPeakLoad.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+    publishedLevel.store(level, std::memory_order_relaxed);
+    publishedActiveGrains.store(activeGrains, std::memory_order_relaxed);
+    publishedDroppedSpawns.store(droppedSpawns, std::memory_order_relaxed);
+    publishedFadedGrains.store(fadedGrains, std::memory_order_relaxed);
+}
+
+bool CpuGovernor::isStepActive(Step step) const
+{
+    for (int i = 0; i < level; ++i)
+        if (settings.ladder[(size_t)i] == step)
+            return true;
+
+    return false;
+}
+
+bool CpuGovernor::tryConsumeSpawn()
+{
+    if (isStepActive(Step::capSpawns) && spawnsThisBlock >= settings.spawnsPerBlockWhenCapped)
+    {
+        ++droppedSpawns;
+        return false;
+    }
+
+    ++spawnsThisBlock;
+    return true;
+}
+
+CpuGovernor::State CpuGovernor::getState() const
+{
+    State state;
+    state.load = publishedLoad.load(std::memory_order_relaxed);
+    state.peakLoad = publishedPeakLoad.load(std::memory_order_relaxed);
+    state.level = publishedLevel.load(std::memory_order_relaxed);
+    state.activeGrains = publishedActiveGrains.load(std::memory_order_relaxed);
+    state.droppedSpawns = publishedDroppedSpawns.load(std::memory_order_relaxed);
+    state.fadedGrains = publishedFadedGrains.load(std::memory_order_relaxed);
+    return state;
+}
@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    CpuGovernor.h
+    Created: 18 Oct 2026 3:15:48pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Watches how long each block takes to render against the time the block
+ * represents, and steps down a degradation ladder while the engine is over
+ * budget, so heavy patches thin out instead of dropping out.
+ *
+ * All methods except getState() must be called from the audio thread.
+ * getState() may be called from any thread.
+ */
+class CpuGovernor
+{
+public:
+    /** The ways the engine can shed load, in the order they are usually applied. */
+    enum class Step
+    {
+        reduceInterpolation,    // New grains use the next cheaper interpolator
+        capSpawns,              // Limit how many grains may start per block
+        fadeOldestGrains        // Fade out the oldest playing grains early
+    };
+
+    static constexpr int maxLadderLength = 3;
+
+    struct Settings
+    {
+        float targetLoad = 0.7f;            // Fraction of the block duration the engine may use
+        float recoveryLoad = 0.45f;         // Load below which the governor backs off a step
+        float smoothing = 0.25f;            // Weight of the newest measurement in the smoothed load
+        int blocksBeforeEscalating = 2;     // Consecutive blocks over budget before stepping down
+        int blocksBeforeRecovering = 40;    // Consecutive blocks under recoveryLoad before stepping back up
+        int spawnsPerBlockWhenCapped = 1;   // Grain starts allowed per block while capSpawns is active
+        int grainsFadedPerBlock = 4;        // Grains faded per block while fadeOldestGrains is active
+        int fadeLengthMs = 10;              // How long a shed grain takes to fade out
+
+        std::array<Step, maxLadderLength> ladder { Step::reduceInterpolation, Step::capSpawns, Step::fadeOldestGrains };
+        int ladderLength = maxLadderLength; // Only the first ladderLength steps are used
+    };
+
+    /** A snapshot of the governor for monitoring. */
+    struct State
+    {
+        float load = 0.0f;          // Smoothed render time as a fraction of the block duration
+        float peakLoad = 0.0f;      // Highest single-block load since the last reset
+        int level = 0;              // Number of ladder steps currently applied
+        int activeGrains = 0;
+        int droppedSpawns = 0;      // Grain starts refused since the last reset
+        int fadedGrains = 0;        // Grains faded early since the last reset
+    };
+
+    /**
+     * Prepares the governor for playback. Also resets its state.
+     *
+     * @param sampleRate       The current sample rate.
+     * @param samplesPerBlock  The maximum block size.
+     */
+    void prepare(double sampleRate, int samplesPerBlock);
+
+    /**
+     * Replaces the governor's settings. Call from the audio thread or before playback.
+     */
+    void setSettings(const Settings& newSettings);
+
+    /**
+     * Enables or disables the governor, e.g. when rendering offline. While disabled
+     * no steps are applied, but load is still measured.
+     */
+    void setEnabled(bool shouldBeEnabled);
+
+    /**
+     * Marks the start of a block's rendering.
+     */
+    void beginBlock();
+
+    /**
+     * Marks the end of a block's rendering and updates the degradation level.
+     *
+     * @param numSamples    The number of samples the block contained.
+     * @param activeGrains  The number of grains playing at the end of the block.
+     */
+    void endBlock(int numSamples, int activeGrains);
+
+    /**
+     * Returns true if the given step is currently applied.
+     */
+    bool isStepActive(Step step) const;
+
+    /**
+     * Asks to start a grain. Returns false if spawns are capped and this block's
+     * allowance is used up; the refusal is counted.
+     */
+    bool tryConsumeSpawn();
+
+    /**
+     * Counts grains that were faded early by the engine.
+     */
+    void addFadedGrains(int numGrains) { fadedGrains += numGrains; }
+
+    const Settings& getSettings() const { return settings; }
+
+    /**
+     * Returns the number of ladder steps currently applied. Audio thread only;
+     * other threads use getState().
+     */
+    int getLevel() const { return level; }
+
+    /**
+     * Returns a snapshot of the governor's state. Safe to call from any thread.
+     */
+    State getState() const;
+
+private:
+    Settings settings;
+    double sampleRate = 44100.0;
+    bool enabled = true;
+
+    juce::int64 blockStartTicks = 0;
+    float smoothedLoad = 0.0f;
+    int level = 0;
+    int blocksOverBudget = 0;
+    int blocksUnderRecovery = 0;
+    int spawnsThisBlock = 0;
+    int droppedSpawns = 0;
+    int fadedGrains = 0;
+
+    // Published copies of the state for other threads
+    std::atomic<float> publishedLoad { 0.0f };
+    std::atomic<float> publishedPeakLoad { 0.0f };
+    std::atomic<int> publishedLevel { 0 };
+    std::atomic<int> publishedActiveGrains { 0 };
+    std::atomic<int> publishedDroppedSpawns { 0 };
+    std::atomic<int> publishedFadedGrains { 0 };
+};
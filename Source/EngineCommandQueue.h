@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    EngineCommandQueue.h
+    Created: 18 Oct 2026 7:24:51pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SourceBuffer.h"
+#include "CpuGovernor.h"
+
+/**
+ * A message from the message thread to the audio engine.
+ */
+struct EngineCommand
+{
+    enum class Type
+    {
+        loadComplete,   // A file has been decoded; start granulating it
+        swapSource,     // Replace the source with another one, e.g. a recording
+        panic,          // Stop every grain at once
+        reconfigure,    // Apply new engine settings
+        evictGrainCache // Stop using the rendered grain cache so its memory can be freed
+    };
+
+    Type type = Type::panic;
+    SourceBuffer::Ptr source;               // For loadComplete and swapSource
+    CpuGovernor::Settings governorSettings; // For reconfigure
+};
+
+/**
+ * A single-producer/single-consumer queue of commands for the audio engine.
+ *
+ * The message thread pushes commands and the audio thread drains them at the
+ * top of each block. Neither side blocks or allocates. Commands carrying a
+ * source hold a reference to it, so the audio thread takes ownership without
+ * touching the reference count of anything it might have to free.
+ */
+class EngineCommandQueue
+{
+public:
+    static constexpr int capacity = 64;
+
+    /**
+     * Pushes a command onto the queue. Called from the message thread only.
+     *
+     * @param command  The command to push.
+     * @return         False if the queue was full and the command was dropped.
+     */
+    bool push(EngineCommand command)
+    {
+        const auto scope = fifo.write(1);
+
+        if (scope.blockSize1 > 0)
+            commands[(size_t)scope.startIndex1] = std::move(command);
+        else if (scope.blockSize2 > 0)
+            commands[(size_t)scope.startIndex2] = std::move(command);
+        else
+            return false;
+
+        return true;
+    }
+
+    /**
+     * Returns the next pending command without removing it, or nullptr if there is
+     * none. Called from the audio thread only.
+     */
+    EngineCommand* peek() noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(1, start1, size1, start2, size2);
+
+        if (size1 > 0)
+            return &commands[(size_t)start1];
+
+        return nullptr;
+    }
+
+    /**
+     * Removes the command returned by peek(). Any source it still holds must have
+     * been moved out first. Called from the audio thread only.
+     */
+    void pop() noexcept
+    {
+        fifo.finishedRead(1);
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<EngineCommand, capacity> commands;
+};
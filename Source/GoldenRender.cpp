@@ -0,0 +1,339 @@
+/*
+  ==============================================================================
+
+    GoldenRender.cpp
+    Created: 18 Oct 2026 7:46:39pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+// The processor and editor are compiled here rather than as files of their own,
+// so they see the same plugin definitions (name, MIDI, buses) as in the plugin
+#include "../JuceLibraryCode/JucePluginDefines.h"
+#include "GoldenRender.h"
+#include "PluginProcessor.cpp"
+#include "PluginEditor.cpp"
+
+//==============================================================================
+GoldenRender::Summary GoldenRender::run(const Options& options)
+{
+    Summary summary;
+
+    if (options.record && !options.goldenDirectory.isDirectory() && options.goldenDirectory.createDirectory().failed())
+    {
+        summary.failures.add("Can't create " + options.goldenDirectory.getFullPathName());
+        return summary;
+    }
+
+    const juce::File baselineFile = options.goldenDirectory.getChildFile("baseline.json");
+    juce::var baselines = options.record ? juce::var(new juce::DynamicObject()) : juce::JSON::parse(baselineFile);
+
+    const juce::TemporaryFile sourceFile(".wav");
+
+    if (!writeSource(sourceFile.getFile()))
+    {
+        summary.failures.add("Can't write the source to " + sourceFile.getFile().getFullPathName());
+        return summary;
+    }
+
+    for (const auto& testCase : getCases())
+    {
+        for (const double sampleRate : options.sampleRates)
+        {
+            for (const int blockSize : options.blockSizes)
+            {
+                const juce::String label = testCase.name + " at " + juce::String(juce::roundToInt(sampleRate)) + " Hz in "
+                                         + juce::String(blockSize) + "-sample blocks";
+
+                Render render = renderCase(testCase, sourceFile.getFile(), sampleRate, blockSize);
+
+                if (!render.loaded)
+                {
+                    summary.failures.add(label + ": the source didn't load");
+                    continue;
+                }
+
+                // Output doesn't change between runs, but timing does, so keep the fastest
+                for (int run = 1; run < options.timingRuns; ++run)
+                    render.microsecondsPerBlock = juce::jmin(render.microsecondsPerBlock,
+                                                             renderCase(testCase, sourceFile.getFile(), sampleRate, blockSize).microsecondsPerBlock);
+
+                ++summary.numRenders;
+
+                const juce::File goldenFile = getGoldenFile(options.goldenDirectory, testCase, sampleRate, blockSize);
+                const juce::String key = getBaselineKey(testCase, sampleRate, blockSize);
+
+                if (options.record)
+                {
+                    if (writeWav(goldenFile, render.output, sampleRate))
+                        ++summary.numRecorded;
+                    else
+                        summary.failures.add("Can't write " + goldenFile.getFullPathName());
+
+                    baselines.getDynamicObject()->setProperty(key, render.microsecondsPerBlock);
+                    continue;
+                }
+
+                juce::AudioBuffer<float> golden;
+
+                if (!readWav(goldenFile, golden))
+                {
+                    summary.failures.add(label + ": no golden at " + goldenFile.getFullPathName() + "; record one with --record");
+                }
+                else
+                {
+                    int worstSample = 0;
+                    const float difference = compare(render.output, golden, worstSample);
+
+                    if (difference < 0.0f)
+                        summary.failures.add(label + ": length or channels differ from the golden");
+                    else if (difference > options.tolerance)
+                        summary.failures.add(label + ": differs from the golden by " + juce::String(difference, 6)
+                                             + " at sample " + juce::String(worstSample));
+                }
+
+                const juce::var baseline = baselines.getProperty(key, juce::var());
+
+                if (baseline.isVoid())
+                {
+                    summary.failures.add(label + ": no CPU baseline in " + baselineFile.getFullPathName());
+                }
+                else if (render.microsecondsPerBlock > (double)baseline * (1.0 + options.cpuMargin))
+                {
+                    summary.failures.add(label + ": " + juce::String(render.microsecondsPerBlock, 2)
+                                         + " us per block, over the " + juce::String((double)baseline, 2)
+                                         + " us baseline by more than " + juce::String(options.cpuMargin * 100.0, 0) + "%");
+                }
+            }
+        }
+    }
+
+    if (options.record && !baselineFile.replaceWithText(juce::JSON::toString(baselines)))
+        summary.failures.add("Can't write " + baselineFile.getFullPathName());
+
+    return summary;
+}
+
+std::vector<GoldenRender::Case> GoldenRender::getCases()
+{
+    std::vector<Case> cases;
+
+    // The plugin's defaults, as a freshly inserted instance plays without notes
+    cases.push_back({ "continuous", 1, {}, {} });
+
+    // Notes landing mid-block, released one at a time and then all at once
+    cases.push_back({ "notes", 2,
+        { { "GRAIN_SIZE", 1024.0f }, { "GRAIN_OVERLAP", 512.0f }, { "GRAIN_SPACING", 128.0f } },
+        { { 0.2, 60, 0.8f }, { 0.55, 67, 1.0f }, { 1.0, 60, 0.0f }, { 1.3, 72, 0.6f }, { 1.7, 0, -1.0f } } });
+
+    // The window, interpolation and filter choices the defaults don't reach
+    cases.push_back({ "shaped", 3,
+        { { "GRAIN_SIZE", 768.0f }, { "GRAIN_OVERLAP", 384.0f }, { "GRAIN_SPACING", 32.0f },
+          { "GRAIN_WINDOW", (float)WindowShape::tukey }, { "GRAIN_INTERPOLATION", (float)Interpolation::cubic },
+          { "GRAIN_REVERSE", 1.0f },
+          { "FILTER_MODE", (float)GrainFilterMode::bandPass }, { "FILTER_CUTOFF", 1200.0f },
+          { "FILTER_RESONANCE", 2.0f }, { "FILTER_SPREAD", 1.0f } },
+        { { 0.3, 67, 0.9f } } });
+
+    // Pitch-synchronous grains retuned by notes
+    cases.push_back({ "psola", 4,
+        { { "PSOLA", 1.0f } },
+        { { 0.1, 57, 0.9f }, { 0.9, 64, 0.9f } } });
+
+    return cases;
+}
+
+bool GoldenRender::writeSource(const juce::File& file)
+{
+    constexpr int numChannels = 2;
+    constexpr int numHarmonics = 6;
+    const int numSamples = juce::roundToInt(sourceSeconds * sourceSampleRate);
+
+    juce::AudioBuffer<float> source(numChannels, numSamples);
+    juce::Random random(1234);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        double phase = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // Glides from 180 Hz to 260 Hz, so grains from different places differ in pitch
+            const double frequency = 180.0 + 80.0 * i / numSamples;
+            phase += juce::MathConstants<double>::twoPi * frequency / sourceSampleRate;
+
+            double sample = 0.0;
+
+            for (int harmonic = 1; harmonic <= numHarmonics; ++harmonic)
+                sample += std::sin(harmonic * phase + channel * 0.5 * harmonic) / harmonic;
+
+            source.setSample(channel, i, (float)(0.25 * sample) + 0.02f * (random.nextFloat() * 2.0f - 1.0f));
+        }
+    }
+
+    return writeWav(file, source, sourceSampleRate);
+}
+
+GoldenRender::Render GoldenRender::renderCase(const Case& testCase, const juce::File& sourceFile,
+                                              double sampleRate, int blockSize)
+{
+    constexpr int numChannels = 2;
+    const int numSamples = juce::roundToInt(renderSeconds * sampleRate);
+
+    Render render;
+    Hw5AudioProcessor processor;
+
+    for (const auto& [parameterID, value] : testCase.parameters)
+    {
+        auto* parameter = processor.getAPVTS().getParameter(parameterID);
+        jassert(parameter != nullptr);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    // Rendered as a host would bounce offline, so the CPU governor never thins grains out
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+    processor.setRandomSeed(testCase.seed);
+
+    if (!loadSource(processor, sourceFile))
+        return render;
+
+    juce::MidiBuffer notes;
+
+    for (const auto& note : testCase.notes)
+    {
+        const int position = juce::roundToInt(note.seconds * sampleRate);
+
+        if (note.velocity < 0.0f)
+            notes.addEvent(juce::MidiMessage::allNotesOff(1), position);
+        else if (note.velocity == 0.0f)
+            notes.addEvent(juce::MidiMessage::noteOff(1, note.noteNumber), position);
+        else
+            notes.addEvent(juce::MidiMessage::noteOn(1, note.noteNumber, note.velocity), position);
+    }
+
+    render.loaded = true;
+    render.output.setSize(numChannels, numSamples);
+
+    juce::MidiBuffer blockNotes;
+    juce::int64 renderTicks = 0;
+    int numBlocks = 0;
+
+    for (int position = 0; position < numSamples; position += blockSize)
+    {
+        const int blockLength = juce::jmin(blockSize, numSamples - position);
+        juce::AudioBuffer<float> block(render.output.getArrayOfWritePointers(), numChannels, position, blockLength);
+
+        blockNotes.clear();
+        blockNotes.addEvents(notes, position, blockLength, -position);
+
+        const juce::int64 start = juce::Time::getHighResolutionTicks();
+        processor.processBlock(block, blockNotes);
+        renderTicks += juce::Time::getHighResolutionTicks() - start;
+        ++numBlocks;
+    }
+
+    processor.releaseResources();
+
+    render.microsecondsPerBlock = juce::Time::highResolutionTicksToSeconds(renderTicks) * 1.0e6 / juce::jmax(1, numBlocks);
+    return render;
+}
+
+bool GoldenRender::loadSource(Hw5AudioProcessor& processor, const juce::File& sourceFile)
+{
+    processor.loadAudioFile(sourceFile);
+
+    // The waveform summary is built once the whole file has been decoded, and
+    // PSOLA needs the pitch marks, which are found after that
+    const double start = juce::Time::getMillisecondCounterHiRes();
+
+    while (processor.getPeakPyramid() == nullptr || !processor.isSourceAnalysed())
+    {
+        if (juce::Time::getMillisecondCounterHiRes() - start > loadTimeoutMs)
+            return false;
+
+        juce::Thread::sleep(1);
+    }
+
+    return true;
+}
+
+float GoldenRender::compare(const juce::AudioBuffer<float>& render, const juce::AudioBuffer<float>& golden,
+                            int& worstSample)
+{
+    if (render.getNumChannels() != golden.getNumChannels() || render.getNumSamples() != golden.getNumSamples())
+        return -1.0f;
+
+    float worst = 0.0f;
+
+    for (int channel = 0; channel < render.getNumChannels(); ++channel)
+    {
+        const float* rendered = render.getReadPointer(channel);
+        const float* expected = golden.getReadPointer(channel);
+
+        for (int i = 0; i < render.getNumSamples(); ++i)
+        {
+            const float difference = std::abs(rendered[i] - expected[i]);
+
+            if (difference > worst)
+            {
+                worst = difference;
+                worstSample = i;
+            }
+        }
+    }
+
+    return worst;
+}
+
+juce::File GoldenRender::getGoldenFile(const juce::File& directory, const Case& testCase, double sampleRate, int blockSize)
+{
+    return directory.getChildFile(getBaselineKey(testCase, sampleRate, blockSize) + ".wav");
+}
+
+juce::String GoldenRender::getBaselineKey(const Case& testCase, double sampleRate, int blockSize)
+{
+    return testCase.name + "_" + juce::String(juce::roundToInt(sampleRate)) + "_" + juce::String(blockSize);
+}
+
+bool GoldenRender::writeWav(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate)
+{
+    file.deleteFile();
+
+    std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+
+    if (stream == nullptr)
+        return false;
+
+    // 32-bit WAVs hold floats, so a golden is exactly what was rendered
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(stream.get(), sampleRate,
+                                                                              (unsigned int)audio.getNumChannels(),
+                                                                              32, {}, 0));
+
+    if (writer == nullptr)
+        return false;
+
+    // The writer owns the stream from here on
+    stream.release();
+    return writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+}
+
+bool GoldenRender::readWav(const juce::File& file, juce::AudioBuffer<float>& audio)
+{
+    if (!file.existsAsFile())
+        return false;
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatReader> reader(wavFormat.createReaderFor(file.createInputStream().release(), true));
+
+    if (reader == nullptr || reader->lengthInSamples > std::numeric_limits<int>::max())
+        return false;
+
+    const int numSamples = (int)reader->lengthInSamples;
+    audio.setSize((int)reader->numChannels, numSamples);
+
+    return reader->read(&audio, 0, numSamples, 0, true, true);
+}
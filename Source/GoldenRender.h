@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    GoldenRender.h
+    Created: 18 Oct 2026 7:46:39pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class Hw5AudioProcessor;
+
+/**
+ * Regression checks for the plugin's output and CPU cost.
+ *
+ * A fixed set of cases, each with its own seed, parameters and notes, is
+ * rendered through Hw5AudioProcessor from a synthetic source at several sample
+ * rates and block sizes. Every render is compared with a golden file recorded
+ * for the same case, rate and block size, so any change to the sound fails the
+ * check. The CPU time per block is compared with a stored baseline, and fails
+ * once it exceeds it by more than a margin, so a processor that renders the
+ * engine more than once per block fails even if the output still matches.
+ *
+ * The golden directory holds one 32-bit float WAV per render, named
+ * <case>_<rate>_<block>.wav, and baseline.json with the microseconds per block
+ * of each. Recording replaces both, so do it on the machine the check runs on,
+ * and only when a change to the sound is intended.
+ */
+class GoldenRender
+{
+public:
+    /** How to run the check. */
+    struct Options
+    {
+        juce::File goldenDirectory;
+        bool record = false;            // Write new goldens and baselines instead of checking
+        float tolerance = 1.0e-4f;      // Largest difference from a golden sample that still passes
+        double cpuMargin = 0.5;         // Fraction over the baseline CPU time that still passes
+        int timingRuns = 3;             // The fastest of this many renders is timed
+
+        std::vector<double> sampleRates { 44100.0, 48000.0, 96000.0 };
+        std::vector<int> blockSizes { 1, 64, 512, 4096 };
+    };
+
+    /** The outcome of a check. */
+    struct Summary
+    {
+        int numRenders = 0;
+        int numRecorded = 0;
+        juce::StringArray failures;     // One line per render that didn't match or ran too slowly
+
+        bool passed() const { return failures.isEmpty(); }
+    };
+
+    /**
+     * Renders every case and checks or records it.
+     *
+     * @param options  What to check, and where the goldens are.
+     * @return         What was rendered, and anything that failed.
+     */
+    static Summary run(const Options& options);
+
+private:
+    /** A note event, placed in seconds so it lands at the same time at any rate. */
+    struct Note
+    {
+        double seconds = 0.0;
+        int noteNumber = 60;
+        float velocity = 0.0f;          // 0 for note off, below 0 for all notes off
+    };
+
+    /** One fixed scenario. */
+    struct Case
+    {
+        juce::String name;
+        juce::int64 seed = 0;
+        std::vector<std::pair<juce::String, float>> parameters;     // Parameter IDs and plain values
+        std::vector<Note> notes;
+    };
+
+    /** One render of a case. */
+    struct Render
+    {
+        bool loaded = false;            // False if the source never finished loading
+        juce::AudioBuffer<float> output;
+        double microsecondsPerBlock = 0.0;
+    };
+
+    static constexpr double renderSeconds = 2.0;
+    static constexpr double sourceSeconds = 2.0;
+    static constexpr double sourceSampleRate = 44100.0;
+    static constexpr double loadTimeoutMs = 30000.0;
+
+    /**
+     * Returns the cases every run checks.
+     */
+    static std::vector<Case> getCases();
+
+    /**
+     * Writes the source every case granulates: a gliding harmonic tone with
+     * seeded noise, so no audio file has to be checked in.
+     */
+    static bool writeSource(const juce::File& file);
+
+    /**
+     * Renders a case on a freshly constructed processor.
+     */
+    static Render renderCase(const Case& testCase, const juce::File& sourceFile, double sampleRate, int blockSize);
+
+    /**
+     * Loads the source into a processor and waits until it can be played in full.
+     */
+    static bool loadSource(Hw5AudioProcessor& processor, const juce::File& sourceFile);
+
+    /**
+     * Returns the largest difference between a render and its golden, and where
+     * it is. Returns a negative difference if the lengths or channels differ.
+     */
+    static float compare(const juce::AudioBuffer<float>& render, const juce::AudioBuffer<float>& golden,
+                         int& worstSample);
+
+    static juce::File getGoldenFile(const juce::File& directory, const Case& testCase, double sampleRate, int blockSize);
+    static juce::String getBaselineKey(const Case& testCase, double sampleRate, int blockSize);
+
+    static bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate);
+    static bool readWav(const juce::File& file, juce::AudioBuffer<float>& audio);
+
+    GoldenRender() = delete;
+};
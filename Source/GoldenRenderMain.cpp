@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    GoldenRenderMain.cpp
+    Created: 18 Oct 2026 7:46:39pm
+    Author:  David Matthew Welch
+
+    Entry point of the GoldenRender console app (GoldenRender/GoldenRender.jucer).
+    Renders the plugin's regression cases and exits with 1 if any render
+    differs from its golden or runs over its CPU baseline, so it can gate a
+    build.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "GoldenRender.h"
+
+int main(int argc, char* argv[])
+{
+    // The processor's parameters and background jobs need a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    GoldenRender::Options options;
+    options.goldenDirectory = juce::File::getCurrentWorkingDirectory().getChildFile("GoldenRender/Goldens");
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String argument(argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--record")
+            options.record = true;
+        else if (argument == "--goldens" && hasValue)
+            options.goldenDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else if (argument == "--tolerance" && hasValue)
+            options.tolerance = juce::String(argv[++i]).getFloatValue();
+        else if (argument == "--cpu-margin" && hasValue)
+            options.cpuMargin = juce::String(argv[++i]).getDoubleValue();
+        else
+        {
+            std::cerr << "Usage: GoldenRender [--record] [--goldens <dir>] [--tolerance <difference>] "
+                         "[--cpu-margin <fraction>]" << std::endl;
+            return 1;
+        }
+    }
+
+    const auto summary = GoldenRender::run(options);
+
+    for (const auto& failure : summary.failures)
+        std::cerr << "FAIL " << failure.toRawUTF8() << std::endl;
+
+    if (options.record)
+        std::cout << "Recorded " << summary.numRecorded << " goldens and the CPU baselines of "
+                  << summary.numRenders << " renders in " << options.goldenDirectory.getFullPathName().toRawUTF8()
+                  << std::endl;
+    else
+        std::cout << summary.numRenders << " renders checked, " << summary.failures.size() << " failures" << std::endl;
+
+    return summary.passed() ? 0 : 1;
+}
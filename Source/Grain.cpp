@@ -11,112 +11,74 @@
 #include "Grain.h"
 #include <JuceHeader.h>
 
-#include <cmath> // For std::cos
-
-Grain::Grain(const juce::AudioBuffer<float>& sourceBuffer, int startSample,
-             int grainSize, float pitchShiftFactor, double sampleRate)
-    : size(grainSize), pitchShiftFactor(pitchShiftFactor), currentSampleRate(sampleRate)
+Grain::Grain(int startSample, int grainSize, float pitchShiftFactor, int sourceLength,
+             const GrainRenderSettings& settings)
+    : state(getInitialState(startSample, grainSize, pitchShiftFactor, sourceLength, settings.reverse)),
+      size(getOutputLength(grainSize, pitchShiftFactor)),
+      numChannels(juce::jlimit(1, 2, settings.numChannels)),
+      pitchShiftFactor(pitchShiftFactor),
+      floatKernel(GrainKernels::select<float>(settings)),
+      doubleKernel(GrainKernels::select<double>(settings))
 {
-    int numChannels = sourceBuffer.getNumChannels();
-    grainAudioData.setSize(numChannels, size);
-
-    for (int channel = 0; channel < numChannels; ++channel)
-    {
-        if (startSample + size <= sourceBuffer.getNumSamples())
-        {
-            grainAudioData.copyFrom(channel, 0, sourceBuffer, channel, startSample, size);
-        }
-        else
-        {
-            int remainingSamples = sourceBuffer.getNumSamples() - startSample;
-            grainAudioData.copyFrom(channel, 0, sourceBuffer, channel, startSample, remainingSamples);
-            grainAudioData.copyFrom(channel, remainingSamples, sourceBuffer, channel, 0, size - remainingSamples);
-        }
-    }
+}
 
-    // Create and apply window
-    window.resize(size);
-    for (int i = 0; i < size; ++i)
-    {
-        window[i] = 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * i / (size - 1)));
-    }
-    applyWindow();
+int Grain::getOutputLength(int grainSize, float pitchShiftFactor)
+{
+    return juce::jmax(1, static_cast<int>(grainSize / pitchShiftFactor));
+}
 
-    // Apply pitch shifting
-    applyPitchShift();
+GrainRenderState Grain::getInitialState(int startSample, int grainSize, float pitchShiftFactor,
+                                        int sourceLength, bool reverse)
+{
+    // Reversed grains cover the same span of the source, read from its end
+    const int firstSample = reverse ? startSample + grainSize - 1 : startSample;
+    const int outputLength = getOutputLength(grainSize, pitchShiftFactor);
+
+    GrainRenderState state;
+    state.readPosition = sourceLength > 0 ? ((firstSample % sourceLength) + sourceLength) % sourceLength : 0;
+    state.readIncrement = reverse ? -pitchShiftFactor : pitchShiftFactor;
+    state.windowPhase = 0.0f;
+    state.windowIncrement = outputLength > 1 ? 1.0f / static_cast<float>(outputLength - 1) : 0.0f;
+    return state;
 }
 
-void Grain::applyWindow()
+template <>
+GrainKernels::Kernel<float> Grain::getKernel<float>() const
 {
-    int numChannels = grainAudioData.getNumChannels();
-    for (int channel = 0; channel < numChannels; ++channel)
-    {
-        float* data = grainAudioData.getWritePointer(channel);
-        for (int i = 0; i < size; ++i)
-        {
-            data[i] *= window[i];
-        }
-    }
+    return floatKernel;
 }
 
-void Grain::applyPitchShift()
+template <>
+GrainKernels::Kernel<double> Grain::getKernel<double>() const
 {
-    if (pitchShiftFactor == 1.0f)
-        return;
+    return doubleKernel;
+}
 
-    int numChannels = grainAudioData.getNumChannels();
-    int newSize = static_cast<int>(size / pitchShiftFactor);
+template <typename SampleType>
+void Grain::processGrain(const GrainSource& source, juce::AudioBuffer<SampleType>& outputBuffer,
+                         int startSampleInOutput, int numSamples)
+{
+    const int numToRender = juce::jmin(numSamples, size - currentPosition,
+                                       outputBuffer.getNumSamples() - startSampleInOutput);
 
-    juce::AudioBuffer<float> resampledData;
-    resampledData.setSize(numChannels, newSize);
-    resampledData.clear();
+    if (numToRender <= 0)
+        return;
 
-    for (int channel = 0; channel < numChannels; ++channel)
+    if (!source.isEmpty() && outputBuffer.getNumChannels() > 0)
     {
-        juce::LagrangeInterpolator interpolator;
-        interpolator.reset();
-
-        const float* srcData = grainAudioData.getReadPointer(channel);
-        float* destData = resampledData.getWritePointer(channel);
-
-        double speedRatio = pitchShiftFactor;
-        int numOutputSamples = newSize;
-
-        int samplesConsumed = interpolator.process(
-            speedRatio,      // double speedRatio
-            srcData,         // const float* inputSamples
-            destData,        // float* outputSamples
-            numOutputSamples // int numOutputSamples
-        );
+        SampleType* outputs[2] = {
+            outputBuffer.getWritePointer(0, startSampleInOutput),
+            outputBuffer.getWritePointer(juce::jmin(numChannels, outputBuffer.getNumChannels()) - 1, startSampleInOutput)
+        };
 
-        // Optionally, you can check if samplesConsumed matches expected values
+        getKernel<SampleType>()(state, source, outputs, numToRender);
     }
 
-    grainAudioData = resampledData;
-    size = newSize;
+    currentPosition += numToRender;
 }
 
-void Grain::processGrain(juce::AudioBuffer<float>& outputBuffer, int startSampleInOutput)
-{
-    int numChannels = grainAudioData.getNumChannels();
-    int outputChannels = outputBuffer.getNumChannels();
-
-    for (int channel = 0; channel < numChannels; ++channel)
-    {
-        const float* grainData = grainAudioData.getReadPointer(channel);
-        float* outputData = outputBuffer.getWritePointer(channel % outputChannels);
-
-        for (int i = 0; i < size; ++i)
-        {
-            if (startSampleInOutput + i < outputBuffer.getNumSamples())
-            {
-                outputData[startSampleInOutput + i] += grainData[i];
-            }
-        }
-    }
-
-    currentPosition += size;
-}
+template void Grain::processGrain<float>(const GrainSource&, juce::AudioBuffer<float>&, int, int);
+template void Grain::processGrain<double>(const GrainSource&, juce::AudioBuffer<double>&, int, int);
 
 bool Grain::isFinished() const
 {
@@ -11,29 +11,44 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "GrainKernels.h"
 
+/**
+ * A single grain rendered through its kernel, e.g. when filling the rendered
+ * grain cache. Playing grains live in GrainBank, which shares the start-state
+ * and length helpers below.
+ */
 class Grain
 {
 public:
     /**
      * Constructor for the Grain class.
      *
-     * @param sourceBuffer      The audio buffer from which the grain is extracted.
-     * @param startSample       The starting sample index in the source buffer.
-     * @param grainSize         The size of the grain in samples.
+     * @param startSample       The starting sample index in the source.
+     * @param grainSize         The size of the grain in source samples.
      * @param pitchShiftFactor  The factor by which to shift the pitch (e.g., 1.0 = no shift).
-     * @param sampleRate        The current sample rate of the audio processor.
+     * @param sourceLength      The length of the source the grain will read from.
+     * @param settings          The window, interpolation, channel count and direction to render with.
      */
-    Grain(const juce::AudioBuffer<float>& sourceBuffer, int startSample,
-          int grainSize, float pitchShiftFactor, double sampleRate);
+    Grain(int startSample, int grainSize, float pitchShiftFactor, int sourceLength,
+          const GrainRenderSettings& settings);
 
     /**
-     * Processes the grain and adds it to the output buffer.
+     * Renders the next part of the grain and adds it to the output buffer.
      *
+     * Grains read straight from the source as they play, so a grain longer than
+     * one block carries on where it left off in the next call.
+     *
+     * @param source               The audio the grain reads from.
      * @param outputBuffer         The buffer to which the grain's audio will be added.
      * @param startSampleInOutput  The starting sample index in the output buffer.
+     * @param numSamples           The maximum number of samples to render.
+     *
+     * Instantiated for float and double output buffers.
      */
-    void processGrain(juce::AudioBuffer<float>& outputBuffer, int startSampleInOutput);
+    template <typename SampleType>
+    void processGrain(const GrainSource& source, juce::AudioBuffer<SampleType>& outputBuffer,
+                      int startSampleInOutput, int numSamples);
 
     /**
      * Checks if the grain has finished processing.
@@ -42,21 +57,34 @@ public:
      */
     bool isFinished() const;
 
-private:
-    juce::AudioBuffer<float> grainAudioData;  // The audio data of the grain
-    int currentPosition = 0;                  // The current position within the grain
-    int size = 0;                             // The size of the grain in samples
-    float pitchShiftFactor = 1.0f;            // The pitch shift factor
-    std::vector<float> window;                // The windowing function applied to the grain
-    double currentSampleRate = 44100.0;       // The current sample rate
-
     /**
-     * Applies a Hanning window to the grain's audio data.
+     * Returns the number of output samples the grain lasts for at the given source
+     * size and pitch shift factor.
      */
-    void applyWindow();
+    static int getOutputLength(int grainSize, float pitchShiftFactor);
 
     /**
-     * Applies pitch shifting to the grain's audio data using LagrangeInterpolator.
+     * Returns the render state a grain starts with.
+     *
+     * @param startSample       The starting sample index in the source.
+     * @param grainSize         The size of the grain in source samples.
+     * @param pitchShiftFactor  The factor by which to shift the pitch.
+     * @param sourceLength      The length of the source the grain will read from.
+     * @param reverse           True if the grain reads backwards.
      */
-    void applyPitchShift();
+    static GrainRenderState getInitialState(int startSample, int grainSize, float pitchShiftFactor,
+                                            int sourceLength, bool reverse);
+
+private:
+    GrainRenderState state;                   // Read position and window phase
+    int currentPosition = 0;                  // The current position within the grain
+    int size = 0;                             // The length of the grain in output samples
+    int numChannels = 2;                      // The number of output channels the kernels write
+    float pitchShiftFactor = 1.0f;            // The pitch shift factor
+
+    GrainKernels::Kernel<float> floatKernel = nullptr;    // Kernels selected once, at construction
+    GrainKernels::Kernel<double> doubleKernel = nullptr;
+
+    template <typename SampleType>
+    GrainKernels::Kernel<SampleType> getKernel() const;
 };
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    GrainActivityFifo.h
+    Created: 18 Oct 2026 9:34:17am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * A single-producer/single-consumer queue of grain spawn events.
+ *
+ * The audio thread pushes one event per spawned grain and the editor pops them
+ * on the message thread to draw the grain-cloud overlay. Neither side ever
+ * blocks or allocates; if the editor falls behind, new events are dropped.
+ */
+class GrainActivityFifo
+{
+public:
+    struct GrainEvent
+    {
+        int startSample = 0;        // Source position the grain starts reading from
+        int length = 0;             // Number of source samples the grain covers
+        float pitchShiftFactor = 1.0f;
+    };
+
+    static constexpr int capacity = 1024;
+
+    /**
+     * Pushes an event onto the queue. Called from the audio thread only.
+     *
+     * @param event  The event to push.
+     * @return       False if the queue was full and the event was dropped.
+     */
+    bool push(const GrainEvent& event) noexcept
+    {
+        const auto scope = fifo.write(1);
+
+        if (scope.blockSize1 > 0)
+            events[(size_t)scope.startIndex1] = event;
+        else if (scope.blockSize2 > 0)
+            events[(size_t)scope.startIndex2] = event;
+        else
+            return false;
+
+        return true;
+    }
+
+    /**
+     * Pops every pending event and passes each one to the callback. Called from
+     * the message thread only.
+     *
+     * @param callback  A function taking a const GrainEvent&.
+     */
+    template <typename Callback>
+    void popAll(Callback&& callback)
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            callback(events[(size_t)(scope.startIndex1 + i)]);
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            callback(events[(size_t)(scope.startIndex2 + i)]);
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<GrainEvent, capacity> events;
+};
@@ -0,0 +1,463 @@
+/*
+  ==============================================================================
+
+    GrainBank.cpp
+    Created: 18 Oct 2026 6:10:44pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "GrainBank.h"
+#include "Grain.h"
+
+namespace
+{
+    void addCachedSamples(float* destination, const float* source, int numSamples)
+    {
+        juce::FloatVectorOperations::add(destination, source, numSamples);
+    }
+
+    void addCachedSamples(double* destination, const float* source, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            destination[i] += static_cast<double>(source[i]);
+    }
+}
+
+GrainBank::FilterCoefficients GrainBank::FilterCoefficients::make(GrainFilterMode mode, float cutoffHz,
+                                                                  float resonance, double sampleRate)
+{
+    FilterCoefficients coefficients;
+
+    if (mode == GrainFilterMode::off || sampleRate <= 0.0)
+        return coefficients;
+
+    // Topology-preserving state-variable filter, stable under per-grain cutoffs
+    const double cutoff = juce::jlimit(10.0, 0.49 * sampleRate, (double)cutoffHz);
+    const float g = static_cast<float>(std::tan(juce::MathConstants<double>::pi * cutoff / sampleRate));
+    const float k = 1.0f / juce::jmax(0.1f, resonance);
+
+    coefficients.a1 = 1.0f / (1.0f + g * (g + k));
+    coefficients.a2 = g * coefficients.a1;
+    coefficients.a3 = g * coefficients.a2;
+    coefficients.enabled = true;
+
+    // The resonance decays with a time constant of 2Q / (2 pi fc); 60 dB is about 6.9 of those
+    const double decaySeconds = 6.9 * juce::jmax(0.5f, resonance) / (juce::MathConstants<double>::pi * cutoff);
+    coefficients.tailLength = (int)std::ceil(juce::jmin(decaySeconds, maxTailSeconds) * sampleRate);
+
+    switch (mode)
+    {
+        case GrainFilterMode::lowPass:  coefficients.m0 = 0.0f; coefficients.m1 = 0.0f; coefficients.m2 = 1.0f;  break;
+        case GrainFilterMode::bandPass: coefficients.m0 = 0.0f; coefficients.m1 = 1.0f; coefficients.m2 = 0.0f;  break;
+        case GrainFilterMode::highPass: coefficients.m0 = 1.0f; coefficients.m1 = -k;   coefficients.m2 = -1.0f; break;
+        case GrainFilterMode::off:
+        case GrainFilterMode::numModes:
+        default: break;
+    }
+
+    return coefficients;
+}
+
+//==============================================================================
+void GrainBank::clear()
+{
+    for (int slot = 0; slot < numActive; ++slot)
+        resetSlot(slot);
+
+    numActive = 0;
+}
+
+int GrainBank::getLongestRemaining() const
+{
+    int longest = 0;
+
+    for (int slot = 0; slot < numActive; ++slot)
+        longest = juce::jmax(longest, lengths[(size_t)slot] - positions[(size_t)slot]);
+
+    return longest;
+}
+
+bool GrainBank::holdsCachedGrains() const
+{
+    for (int slot = 0; slot < numActive; ++slot)
+        if (cachedGrains[(size_t)slot].isValid())
+            return true;
+
+    return false;
+}
+
+bool GrainBank::add(int startSample, int grainSize, float pitchShiftFactor, int sourceLength,
+                    const GrainRenderSettings& settings, const FilterCoefficients& filter)
+{
+    if (isFull())
+        return false;
+
+    const int slot = claimSlot(filter);
+    const auto state = Grain::getInitialState(startSample, grainSize, pitchShiftFactor, sourceLength, settings.reverse);
+
+    readPositions[(size_t)slot] = state.readPosition;
+    readIncrements[(size_t)slot] = state.readIncrement;
+    windowPhases[(size_t)slot] = state.windowPhase;
+    windowIncrements[(size_t)slot] = state.windowIncrement;
+    dryLengths[(size_t)slot] = Grain::getOutputLength(grainSize, pitchShiftFactor);
+    lengths[(size_t)slot] = dryLengths[(size_t)slot] + filter.tailLength;
+    channelCounts[(size_t)slot] = juce::jlimit(1, 2, settings.numChannels);
+    floatKernels[(size_t)slot] = GrainKernels::select<float>(settings);
+    doubleKernels[(size_t)slot] = GrainKernels::select<double>(settings);
+    return true;
+}
+
+bool GrainBank::addCached(RenderedGrainCache::Handle cachedGrain, const FilterCoefficients& filter)
+{
+    if (isFull() || !cachedGrain.isValid())
+        return false;
+
+    const int slot = claimSlot(filter);
+
+    dryLengths[(size_t)slot] = juce::jmax(1, cachedGrain.getLength());
+    lengths[(size_t)slot] = dryLengths[(size_t)slot] + filter.tailLength;
+    channelCounts[(size_t)slot] = juce::jmax(1, cachedGrain.getNumChannels());
+    cachedGrains[(size_t)slot] = std::move(cachedGrain);
+    return true;
+}
+
+int GrainBank::claimSlot(const FilterCoefficients& filter)
+{
+    const int slot = numActive++;
+
+    positions[(size_t)slot] = 0;
+    fadingOut[(size_t)slot] = false;
+
+    filterA1[(size_t)slot] = filter.a1;
+    filterA2[(size_t)slot] = filter.a2;
+    filterA3[(size_t)slot] = filter.a3;
+    filterM0[(size_t)slot] = filter.m0;
+    filterM1[(size_t)slot] = filter.m1;
+    filterM2[(size_t)slot] = filter.m2;
+    filtered[(size_t)slot] = filter.enabled;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        filterState1[channel][(size_t)slot] = 0.0f;
+        filterState2[channel][(size_t)slot] = 0.0f;
+    }
+
+    return slot;
+}
+
+void GrainBank::moveSlot(int from, int to)
+{
+    const auto f = (size_t)from;
+    const auto t = (size_t)to;
+
+    readPositions[t] = readPositions[f];
+    readIncrements[t] = readIncrements[f];
+    windowPhases[t] = windowPhases[f];
+    windowIncrements[t] = windowIncrements[f];
+    positions[t] = positions[f];
+    lengths[t] = lengths[f];
+    dryLengths[t] = dryLengths[f];
+    channelCounts[t] = channelCounts[f];
+    fadingOut[t] = fadingOut[f];
+    fadeGains[t] = fadeGains[f];
+    fadeSteps[t] = fadeSteps[f];
+    floatKernels[t] = floatKernels[f];
+    doubleKernels[t] = doubleKernels[f];
+    cachedGrains[t] = std::move(cachedGrains[f]);
+
+    filterA1[t] = filterA1[f];
+    filterA2[t] = filterA2[f];
+    filterA3[t] = filterA3[f];
+    filterM0[t] = filterM0[f];
+    filterM1[t] = filterM1[f];
+    filterM2[t] = filterM2[f];
+    filtered[t] = filtered[f];
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        filterState1[channel][t] = filterState1[channel][f];
+        filterState2[channel][t] = filterState2[channel][f];
+    }
+}
+
+void GrainBank::resetSlot(int slot)
+{
+    // Unused lanes in a group are still run through the filter, so they must stay silent
+    cachedGrains[(size_t)slot] = {};
+    positions[(size_t)slot] = 0;
+    lengths[(size_t)slot] = 0;
+    dryLengths[(size_t)slot] = 0;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        filterState1[channel][(size_t)slot] = 0.0f;
+        filterState2[channel][(size_t)slot] = 0.0f;
+    }
+}
+
+void GrainBank::removeFinished()
+{
+    int kept = 0;
+
+    for (int slot = 0; slot < numActive; ++slot)
+    {
+        if (positions[(size_t)slot] >= lengths[(size_t)slot])
+            continue;
+
+        if (kept != slot)
+            moveSlot(slot, kept);
+
+        ++kept;
+    }
+
+    for (int slot = kept; slot < numActive; ++slot)
+        resetSlot(slot);
+
+    numActive = kept;
+}
+
+int GrainBank::fadeOutOldest(int maxGrains, int fadeLength)
+{
+    fadeLength = juce::jmax(1, fadeLength);
+    int numFaded = 0;
+
+    for (int slot = 0; slot < numActive && numFaded < maxGrains; ++slot)
+    {
+        const auto s = (size_t)slot;
+
+        if (fadingOut[s] || cachedGrains[s].isValid() || dryLengths[s] - positions[s] <= fadeLength)
+            continue;
+
+        // A gain ramp over the window fades every shape, including the flat
+        // rectangular one, and leaves the render kernels untouched
+        fadeGains[s] = 1.0f;
+        fadeSteps[s] = 1.0f / static_cast<float>(fadeLength);
+        lengths[s] = positions[s] + fadeLength + (lengths[s] - dryLengths[s]);
+        dryLengths[s] = positions[s] + fadeLength;
+        fadingOut[s] = true;
+        ++numFaded;
+    }
+
+    return numFaded;
+}
+
+//==============================================================================
+template <typename SampleType>
+void GrainBank::render(const GrainSource& source, juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
+{
+    if (numActive == 0 || numSamples <= 0 || buffer.getNumChannels() == 0)
+        return;
+
+    for (int firstSlot = 0; firstSlot < numActive; firstSlot += numLanes)
+    {
+        const int endSlot = juce::jmin(firstSlot + numLanes, numActive);
+        bool anyFiltered = false;
+
+        for (int slot = firstSlot; slot < endSlot; ++slot)
+            anyFiltered = anyFiltered || filtered[(size_t)slot];
+
+        if (anyFiltered)
+        {
+            renderFilteredGroup(firstSlot, source, buffer, startSample, numSamples);
+        }
+        else
+        {
+            for (int slot = firstSlot; slot < endSlot; ++slot)
+                renderDirect(slot, source, buffer, startSample, numSamples);
+        }
+    }
+}
+
+template <typename SampleType>
+void GrainBank::renderDirect(int slot, const GrainSource& source, juce::AudioBuffer<SampleType>& buffer,
+                             int startSample, int numSamples)
+{
+    const auto s = (size_t)slot;
+    const int numToRender = juce::jmin(numSamples, lengths[s] - positions[s]);
+
+    if (numToRender <= 0)
+        return;
+
+    const TraceRecorder::Scope trace(tracer, "renderGrain", slot);
+
+    SampleType* outputs[2] = {
+        buffer.getWritePointer(0, startSample),
+        buffer.getWritePointer(juce::jmin(channelCounts[s], buffer.getNumChannels()) - 1, startSample)
+    };
+
+    if (cachedGrains[s].isValid())
+    {
+        for (int channel = 0; channel < channelCounts[s]; ++channel)
+            addCachedSamples(outputs[channel], cachedGrains[s].getChannel(channel) + positions[s], numToRender);
+    }
+    else if (fadingOut[s] && !source.isEmpty())
+    {
+        renderFading(slot, source, outputs, numToRender);
+    }
+    else if (!source.isEmpty())
+    {
+        GrainRenderState state { readPositions[s], readIncrements[s], windowPhases[s], windowIncrements[s] };
+
+        if constexpr (std::is_same_v<SampleType, float>)
+            floatKernels[s](state, source, outputs, numToRender);
+        else
+            doubleKernels[s](state, source, outputs, numToRender);
+
+        readPositions[s] = state.readPosition;
+        windowPhases[s] = state.windowPhase;
+    }
+
+    positions[s] += numToRender;
+}
+
+template <typename SampleType>
+void GrainBank::renderFading(int slot, const GrainSource& source, SampleType* const* outputs, int numSamples)
+{
+    const auto s = (size_t)slot;
+
+    for (int done = 0; done < numSamples; done += maxChunkSize)
+    {
+        const int chunkSize = juce::jmin(maxChunkSize, numSamples - done);
+        SampleType* rows[2];
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            if constexpr (std::is_same_v<SampleType, float>)
+                rows[channel] = fadeScratch[channel];
+            else
+                rows[channel] = fadeScratchDouble[channel];
+
+            juce::FloatVectorOperations::clear(rows[channel], chunkSize);
+        }
+
+        GrainRenderState state { readPositions[s], readIncrements[s], windowPhases[s], windowIncrements[s] };
+
+        if constexpr (std::is_same_v<SampleType, float>)
+            floatKernels[s](state, source, rows, chunkSize);
+        else
+            doubleKernels[s](state, source, rows, chunkSize);
+
+        readPositions[s] = state.readPosition;
+        windowPhases[s] = state.windowPhase;
+
+        applyFade(slot, rows, chunkSize);
+
+        for (int channel = 0; channel < channelCounts[s]; ++channel)
+            juce::FloatVectorOperations::add(outputs[channel] + done, rows[channel], chunkSize);
+    }
+}
+
+template <typename SampleType>
+void GrainBank::applyFade(int slot, SampleType* const* rows, int numSamples)
+{
+    const auto s = (size_t)slot;
+    float gain = fadeGains[s];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int channel = 0; channel < channelCounts[s]; ++channel)
+            rows[channel][i] *= static_cast<SampleType>(gain);
+
+        gain = juce::jmax(0.0f, gain - fadeSteps[s]);
+    }
+
+    fadeGains[s] = gain;
+}
+
+template <typename SampleType>
+void GrainBank::renderFilteredGroup(int firstSlot, const GrainSource& source, juce::AudioBuffer<SampleType>& buffer,
+                                    int startSample, int numSamples)
+{
+    const int endSlot = juce::jmin(firstSlot + numLanes, numActive);
+    const int numOutputChannels = juce::jmin(2, buffer.getNumChannels());
+    const auto first = (size_t)firstSlot;
+
+    const TraceRecorder::Scope trace(tracer, "renderFilteredGroup", firstSlot);
+
+    const auto a1 = FilterVector::fromRawArray(filterA1.data() + first);
+    const auto a2 = FilterVector::fromRawArray(filterA2.data() + first);
+    const auto a3 = FilterVector::fromRawArray(filterA3.data() + first);
+    const auto m0 = FilterVector::fromRawArray(filterM0.data() + first);
+    const auto m1 = FilterVector::fromRawArray(filterM1.data() + first);
+    const auto m2 = FilterVector::fromRawArray(filterM2.data() + first);
+
+    for (int done = 0; done < numSamples; done += maxChunkSize)
+    {
+        const int chunkSize = juce::jmin(maxChunkSize, numSamples - done);
+
+        // Render each grain dry into its own lane. Unused lanes and samples after a
+        // grain ends stay silent, so every lane can run through the filter and
+        // finished grains simply ring out.
+        for (int lane = 0; lane < numLanes; ++lane)
+            for (int channel = 0; channel < 2; ++channel)
+                juce::FloatVectorOperations::clear(scratch[channel][lane], chunkSize);
+
+        for (int slot = firstSlot; slot < endSlot; ++slot)
+        {
+            const auto s = (size_t)slot;
+            const int lane = slot - firstSlot;
+            const int numToAdvance = juce::jmin(chunkSize, lengths[s] - positions[s]);
+            const int numToRender = juce::jmin(numToAdvance, dryLengths[s] - positions[s]);
+
+            if (numToRender <= 0)
+            {
+                // Only the filter tail is left, which rings on from silence
+                positions[s] += juce::jmax(0, numToAdvance);
+                continue;
+            }
+
+            float* rows[2] = { scratch[0][lane], scratch[1][lane] };
+
+            if (cachedGrains[s].isValid())
+            {
+                for (int channel = 0; channel < channelCounts[s]; ++channel)
+                    addCachedSamples(rows[channel], cachedGrains[s].getChannel(channel) + positions[s], numToRender);
+            }
+            else if (!source.isEmpty())
+            {
+                GrainRenderState state { readPositions[s], readIncrements[s], windowPhases[s], windowIncrements[s] };
+                floatKernels[s](state, source, rows, numToRender);
+                readPositions[s] = state.readPosition;
+                windowPhases[s] = state.windowPhase;
+
+                if (fadingOut[s])
+                    applyFade(slot, rows, numToRender);
+            }
+
+            positions[s] += numToAdvance;
+        }
+
+        // Filter all lanes at once and sum them into the output
+        for (int channel = 0; channel < numOutputChannels; ++channel)
+        {
+            for (int i = 0; i < chunkSize; ++i)
+                for (int lane = 0; lane < numLanes; ++lane)
+                    interleaved[i * numLanes + lane] = scratch[channel][lane][i];
+
+            auto state1 = FilterVector::fromRawArray(filterState1[channel].data() + first);
+            auto state2 = FilterVector::fromRawArray(filterState2[channel].data() + first);
+            SampleType* output = buffer.getWritePointer(channel, startSample + done);
+
+            for (int i = 0; i < chunkSize; ++i)
+            {
+                const auto v0 = FilterVector::fromRawArray(interleaved + i * numLanes);
+                const auto v3 = v0 - state2;
+                const auto v1 = a1 * state1 + a2 * v3;
+                const auto v2 = state2 + a2 * state1 + a3 * v3;
+
+                state1 = v1 + v1 - state1;
+                state2 = v2 + v2 - state2;
+
+                output[i] += static_cast<SampleType>((m0 * v0 + m1 * v1 + m2 * v2).sum());
+            }
+
+            state1.copyToRawArray(filterState1[channel].data() + first);
+            state2.copyToRawArray(filterState2[channel].data() + first);
+        }
+    }
+}
+
+template void GrainBank::render<float>(const GrainSource&, juce::AudioBuffer<float>&, int, int);
+template void GrainBank::render<double>(const GrainSource&, juce::AudioBuffer<double>&, int, int);
@@ -0,0 +1,202 @@
+/*
+  ==============================================================================
+
+    GrainBank.h
+    Created: 18 Oct 2026 6:10:44pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GrainKernels.h"
+#include "RenderedGrainCache.h"
+#include "TraceRecorder.h"
+
+/** The resonant filter applied to each grain. */
+enum class GrainFilterMode
+{
+    off = 0,
+    lowPass,
+    bandPass,
+    highPass,
+    numModes
+};
+
+/**
+ * Every playing grain, stored as structure-of-arrays in fixed, preallocated slots.
+ *
+ * Slots are kept in the order grains started, so the oldest come first. Grains
+ * are rendered in groups of one SIMD register's worth of lanes: each grain's
+ * kernel reads its source into a lane of a small scratch block, then the
+ * group's per-grain state-variable filters run side by side in SIMD lanes and
+ * are summed into the output. Groups with no filtered grains skip the scratch
+ * block and render straight into the output.
+ *
+ * Adding and removing grains never allocates. All methods are called from the
+ * audio thread.
+ */
+class GrainBank
+{
+public:
+    using FilterVector = juce::dsp::SIMDRegister<float>;
+
+    static constexpr int capacity = 256;                                // Hard limit on playing grains
+    static constexpr int numLanes = (int)FilterVector::SIMDNumElements; // Grains filtered together
+    static constexpr int maxChunkSize = 64;                             // Samples rendered per scratch pass
+    static constexpr double maxTailSeconds = 0.25;                      // Longest filter tail kept after a grain
+
+    /** A grain's state-variable filter, as coefficients ready for the render loop. */
+    struct FilterCoefficients
+    {
+        float a1 = 1.0f, a2 = 0.0f, a3 = 0.0f;     // Trapezoidal SVF coefficients
+        float m0 = 1.0f, m1 = 0.0f, m2 = 0.0f;     // Mix of input, band pass and low pass outputs
+        int tailLength = 0;                         // Samples the filter rings on for after the grain
+        bool enabled = false;
+
+        /**
+         * Designs a filter. Cutoff is clamped below Nyquist. The tail lasts until the
+         * resonance has decayed by 60 dB, up to maxTailSeconds.
+         *
+         * @param mode        The filter response.
+         * @param cutoffHz    The cutoff or centre frequency.
+         * @param resonance   The filter Q.
+         * @param sampleRate  The engine sample rate.
+         */
+        static FilterCoefficients make(GrainFilterMode mode, float cutoffHz, float resonance, double sampleRate);
+    };
+
+    /**
+     * Sets the recorder that per-grain render events go to, or nullptr for none.
+     */
+    void setTracer(TraceRecorder* newTracer) { tracer = newTracer; }
+
+    /**
+     * Removes every grain.
+     */
+    void clear();
+
+    int size() const   { return numActive; }
+    bool isFull() const { return numActive >= capacity; }
+
+    /**
+     * Returns how many more output samples the longest-running grain lasts for,
+     * including its filter tail, or 0 if none are playing.
+     */
+    int getLongestRemaining() const;
+
+    /**
+     * Returns true if any grain is playing a copy from the rendered grain cache.
+     */
+    bool holdsCachedGrains() const;
+
+    /**
+     * Starts a grain that reads from the source.
+     *
+     * @param startSample       The starting sample index in the source.
+     * @param grainSize         The size of the grain in source samples.
+     * @param pitchShiftFactor  The factor by which to shift the pitch.
+     * @param sourceLength      The length of the source the grain will read from.
+     * @param settings          The kernel choices to render with.
+     * @param filter            The grain's filter.
+     * @return                  False if the bank is full.
+     */
+    bool add(int startSample, int grainSize, float pitchShiftFactor, int sourceLength,
+             const GrainRenderSettings& settings, const FilterCoefficients& filter);
+
+    /**
+     * Starts a grain that plays a copy from the rendered grain cache.
+     *
+     * @param cachedGrain  A valid handle to the rendered grain.
+     * @param filter       The grain's filter.
+     * @return             False if the bank is full.
+     */
+    bool addCached(RenderedGrainCache::Handle cachedGrain, const FilterCoefficients& filter);
+
+    /**
+     * Renders the next part of every grain and adds it to the buffer.
+     *
+     * @param source       The audio grains read from.
+     * @param buffer       The buffer to add to.
+     * @param startSample  The first sample of the span within the buffer.
+     * @param numSamples   The length of the span.
+     *
+     * Instantiated for float and double output buffers.
+     */
+    template <typename SampleType>
+    void render(const GrainSource& source, juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples);
+
+    /**
+     * Drops finished grains, keeping the rest in the order they started.
+     */
+    void removeFinished();
+
+    /**
+     * Shortens up to maxGrains of the oldest grains so they fade out over
+     * fadeLength samples. Cached grains are skipped, as they are already cheap.
+     *
+     * @return  The number of grains shortened.
+     */
+    int fadeOutOldest(int maxGrains, int fadeLength);
+
+private:
+    static constexpr size_t alignment = FilterVector::SIMDRegisterSize;
+
+    int numActive = 0;
+    TraceRecorder* tracer = nullptr;
+
+    // Per-grain render state
+    std::array<double, capacity> readPositions {};
+    std::array<double, capacity> readIncrements {};
+    std::array<float, capacity> windowPhases {};
+    std::array<float, capacity> windowIncrements {};
+    std::array<int, capacity> positions {};         // Output samples rendered so far
+    std::array<int, capacity> lengths {};           // Output samples in total, including any filter tail
+    std::array<int, capacity> dryLengths {};        // Output samples the grain itself lasts for
+    std::array<int, capacity> channelCounts {};
+    std::array<bool, capacity> fadingOut {};
+    std::array<float, capacity> fadeGains {};       // Gain an early fade has fallen to, applied over the window
+    std::array<float, capacity> fadeSteps {};       // How far that gain falls per sample
+    std::array<GrainKernels::Kernel<float>, capacity> floatKernels {};
+    std::array<GrainKernels::Kernel<double>, capacity> doubleKernels {};
+    std::array<RenderedGrainCache::Handle, capacity> cachedGrains;
+
+    // Per-grain filter coefficients and state, laid out so a group of lanes loads as one register
+    alignas(alignment) std::array<float, capacity> filterA1 {};
+    alignas(alignment) std::array<float, capacity> filterA2 {};
+    alignas(alignment) std::array<float, capacity> filterA3 {};
+    alignas(alignment) std::array<float, capacity> filterM0 {};
+    alignas(alignment) std::array<float, capacity> filterM1 {};
+    alignas(alignment) std::array<float, capacity> filterM2 {};
+    alignas(alignment) std::array<float, capacity> filterState1[2] {};
+    alignas(alignment) std::array<float, capacity> filterState2[2] {};
+    std::array<bool, capacity> filtered {};
+
+    // Scratch for a group: dry grains one lane per row, then interleaved by sample
+    alignas(alignment) float scratch[2][numLanes][maxChunkSize] {};
+    alignas(alignment) float interleaved[maxChunkSize * numLanes] {};
+
+    // Scratch for a fading grain, which renders on its own so its fade applies before it's mixed
+    alignas(alignment) float fadeScratch[2][maxChunkSize] {};
+    alignas(alignment) double fadeScratchDouble[2][maxChunkSize] {};
+
+    int claimSlot(const FilterCoefficients& filter);
+    void moveSlot(int from, int to);
+    void resetSlot(int slot);
+
+    template <typename SampleType>
+    void renderDirect(int slot, const GrainSource& source, juce::AudioBuffer<SampleType>& buffer,
+                      int startSample, int numSamples);
+
+    template <typename SampleType>
+    void renderFading(int slot, const GrainSource& source, SampleType* const* outputs, int numSamples);
+
+    template <typename SampleType>
+    void applyFade(int slot, SampleType* const* rows, int numSamples);
+
+    template <typename SampleType>
+    void renderFilteredGroup(int firstSlot, const GrainSource& source, juce::AudioBuffer<SampleType>& buffer,
+                             int startSample, int numSamples);
+};
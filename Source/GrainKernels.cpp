@@ -0,0 +1,415 @@
+/*
+  ==============================================================================
+
+    GrainKernels.cpp
+    Created: 18 Oct 2026 1:40:12pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "GrainKernels.h"
+
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace
+{
+    //==============================================================================
+    // Windows. Each policy maps a phase in [0, 1] to a gain.
+
+    constexpr int windowTableSize = 1024;
+
+    struct WindowTable
+    {
+        std::array<float, windowTableSize + 1> values {};  // One guard point for interpolation
+
+        template <typename Function>
+        explicit WindowTable(Function&& function)
+        {
+            for (int i = 0; i <= windowTableSize; ++i)
+                values[(size_t)i] = function(static_cast<float>(i) / windowTableSize);
+        }
+
+        float lookup(float phase) const noexcept
+        {
+            const float position = juce::jlimit(0.0f, 1.0f, phase) * windowTableSize;
+            const int index = juce::jmin(static_cast<int>(position), windowTableSize - 1);
+            const float fraction = position - index;
+            return values[(size_t)index] + fraction * (values[(size_t)index + 1] - values[(size_t)index]);
+        }
+    };
+
+    const WindowTable& getHannTable()
+    {
+        static const WindowTable table([](float phase)
+        {
+            return 0.5f * (1.0f - std::cos(juce::MathConstants<float>::twoPi * phase));
+        });
+        return table;
+    }
+
+    const WindowTable& getTukeyTable()
+    {
+        // Flat top over the middle half, cosine tapers over the outer quarters
+        static const WindowTable table([](float phase)
+        {
+            constexpr float taper = 0.25f;
+            const float edge = juce::jmin(phase, 1.0f - phase);
+
+            if (edge >= taper)
+                return 1.0f;
+
+            return 0.5f * (1.0f - std::cos(juce::MathConstants<float>::pi * edge / taper));
+        });
+        return table;
+    }
+
+    template <WindowShape shape>
+    struct Window;
+
+    template <>
+    struct Window<WindowShape::hann>
+    {
+        const WindowTable& table = getHannTable();
+        float gain(float phase) const noexcept { return table.lookup(phase); }
+    };
+
+    template <>
+    struct Window<WindowShape::tukey>
+    {
+        const WindowTable& table = getTukeyTable();
+        float gain(float phase) const noexcept { return table.lookup(phase); }
+    };
+
+    template <>
+    struct Window<WindowShape::triangle>
+    {
+        float gain(float phase) const noexcept { return juce::jmax(0.0f, 1.0f - std::abs(2.0f * phase - 1.0f)); }
+    };
+
+    template <>
+    struct Window<WindowShape::rectangular>
+    {
+        float gain(float) const noexcept { return 1.0f; }
+    };
+
+    //==============================================================================
+    // Interpolators. Each declares how many taps it reads before and after the
+    // integer read position; near the ends of the source the taps are gathered
+    // with wrapped indices into a small array and read from there.
+
+    inline int wrapIndex(int index, int numSamples) noexcept
+    {
+        index %= numSamples;
+        return index < 0 ? index + numSamples : index;
+    }
+
+    inline double wrapPosition(double position, int numSamples) noexcept
+    {
+        position = std::fmod(position, (double)numSamples);
+        return position < 0.0 ? position + numSamples : position;
+    }
+
+    template <Interpolation interpolation>
+    struct Interpolator;
+
+    template <>
+    struct Interpolator<Interpolation::none>
+    {
+        static constexpr int tapsBefore = 0;
+        static constexpr int tapsAfter = 0;
+
+        static float read(const float* data, int index, float) noexcept
+        {
+            return data[index];
+        }
+    };
+
+    template <>
+    struct Interpolator<Interpolation::linear>
+    {
+        static constexpr int tapsBefore = 0;
+        static constexpr int tapsAfter = 1;
+
+        static float read(const float* data, int index, float fraction) noexcept
+        {
+            return data[index] + fraction * (data[index + 1] - data[index]);
+        }
+    };
+
+    template <>
+    struct Interpolator<Interpolation::cubic>
+    {
+        static constexpr int tapsBefore = 1;
+        static constexpr int tapsAfter = 2;
+
+        static float hermite(float xm1, float x0, float x1, float x2, float fraction) noexcept
+        {
+            const float c1 = 0.5f * (x1 - xm1);
+            const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+            const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+            return ((c3 * fraction + c2) * fraction + c1) * fraction + x0;
+        }
+
+        static float read(const float* data, int index, float fraction) noexcept
+        {
+            return hermite(data[index - 1], data[index], data[index + 1], data[index + 2], fraction);
+        }
+    };
+
+    //==============================================================================
+    /**
+     * Returns how many samples, starting at the current position, can be read
+     * without any interpolator tap falling outside the source. Kept slightly
+     * conservative so accumulated rounding in the read position can't overshoot.
+     */
+    template <typename Interp, bool reverse>
+    int getNumSamplesBeforeEdge(double position, double increment, int numSamples) noexcept
+    {
+        constexpr double margin = 1.0e-6;
+        const double lowest = Interp::tapsBefore + margin;
+        const double highest = numSamples - 1 - Interp::tapsAfter - margin;
+
+        if (position < lowest || position > highest)
+            return 0;
+
+        const double distance = reverse ? position - lowest : highest - position;
+        const double steps = distance / std::abs(increment);
+
+        return steps >= (double)std::numeric_limits<int>::max() - 1 ? std::numeric_limits<int>::max()
+                                                                     : static_cast<int>(steps) + 1;
+    }
+
+    //==============================================================================
+    // Storage formats. Each gives the sample type a source is read as and how
+    // single samples convert to float; blocks convert through SampleStorageConversion.
+
+    template <SampleStorage storage>
+    struct StorageFormat;
+
+    template <>
+    struct StorageFormat<SampleStorage::float32>
+    {
+        using Type = float;
+        static const Type* getChannel(const GrainSource& source, int channel) noexcept { return source.channels[channel]; }
+        static float toFloat(Type sample) noexcept { return sample; }
+    };
+
+    template <>
+    struct StorageFormat<SampleStorage::int16>
+    {
+        using Type = juce::int16;
+        static const Type* getChannel(const GrainSource& source, int channel) noexcept { return static_cast<const Type*>(source.compactChannels[channel]); }
+        static float toFloat(Type sample) noexcept { return SampleStorageConversion::int16ToFloat(sample); }
+    };
+
+    template <>
+    struct StorageFormat<SampleStorage::float16>
+    {
+        using Type = juce::uint16;
+        static const Type* getChannel(const GrainSource& source, int channel) noexcept { return static_cast<const Type*>(source.compactChannels[channel]); }
+        static float toFloat(Type sample) noexcept { return SampleStorageConversion::halfToFloat(sample); }
+    };
+
+    // Samples per channel converted at a time from compact storage
+    constexpr int conversionBlockSize = 256;
+
+    //==============================================================================
+    /**
+     * Renders output samples [start, end) with plain indexing, reading source
+     * index i from data[channel][i - indexOffset].
+     */
+    template <typename SampleType, typename Interp, typename WindowType, int numChannels>
+    void renderRun(const float* const* data, int indexOffset, SampleType* const* destinations, int start, int end,
+                   double& position, double increment, float& phase, float phaseIncrement, const WindowType& window) noexcept
+    {
+        for (int i = start; i < end; ++i)
+        {
+            const int index = static_cast<int>(position) - indexOffset;
+            const float fraction = static_cast<float>(position - static_cast<int>(position));
+            const float gain = window.gain(phase);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                destinations[channel][i] += static_cast<SampleType>(gain * Interp::read(data[channel], index, fraction));
+
+            position += increment;
+            phase += phaseIncrement;
+        }
+    }
+
+    template <SampleStorage storage, typename SampleType, WindowShape shape, Interpolation interpolation, int numChannels, bool reverse>
+    void renderGrainFrom(GrainRenderState& state, const GrainSource& source, SampleType* const* outputs, int numSamples)
+    {
+        using Interp = Interpolator<interpolation>;
+        using Format = StorageFormat<storage>;
+
+        constexpr bool isCompact = storage != SampleStorage::float32;
+        constexpr int numTaps = Interp::tapsBefore + 1 + Interp::tapsAfter;
+
+        const Window<shape> window;
+        const int sourceLength = source.numSamples;
+
+        const typename Format::Type* channels[numChannels];
+        SampleType* destinations[numChannels];
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            channels[channel] = Format::getChannel(source, channel % source.numChannels);
+            destinations[channel] = outputs[channel];
+        }
+
+        // Compact sources are converted into this scratch span by span
+        float converted[numChannels][isCompact ? conversionBlockSize : 1];
+        const float* convertedChannels[numChannels];
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            convertedChannels[channel] = converted[channel];
+
+        double position = state.readPosition;
+        const double increment = state.readIncrement;
+        float phase = state.windowPhase;
+        const float phaseIncrement = state.windowIncrement;
+
+        int done = 0;
+
+        while (done < numSamples)
+        {
+            // Run as far as possible with plain indexing, then take a single wrapped
+            // step near or across the ends of the source before carrying on
+            const int run = juce::jmin(numSamples - done,
+                                       getNumSamplesBeforeEdge<Interp, reverse>(position, increment, sourceLength));
+
+            if constexpr (isCompact)
+            {
+                // Split the run so the source span each part reads fits the scratch,
+                // with a sample of slack each side for rounding in the read position
+                constexpr int spanPadding = numTaps + 3;
+                const int maxPart = juce::jmax(1, static_cast<int>((conversionBlockSize - spanPadding) / std::abs(increment)));
+
+                for (const int runEnd = done + run; done < runEnd;)
+                {
+                    const int part = juce::jmin(runEnd - done, maxPart);
+                    const double last = position + (part - 1) * increment;
+
+                    const int firstIndex = juce::jmax(0, static_cast<int>(juce::jmin(position, last)) - Interp::tapsBefore - 1);
+                    const int lastIndex = juce::jmin(sourceLength - 1, static_cast<int>(juce::jmax(position, last)) + Interp::tapsAfter + 1);
+                    jassert(lastIndex - firstIndex < conversionBlockSize);
+
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        SampleStorageConversion::toFloat(channels[channel] + firstIndex, converted[channel], lastIndex - firstIndex + 1);
+
+                    renderRun<SampleType, Interp, Window<shape>, numChannels>(convertedChannels, firstIndex, destinations, done, done + part,
+                                                                             position, increment, phase, phaseIncrement, window);
+                    done += part;
+                }
+            }
+            else
+            {
+                renderRun<SampleType, Interp, Window<shape>, numChannels>(channels, 0, destinations, done, done + run,
+                                                                         position, increment, phase, phaseIncrement, window);
+                done += run;
+            }
+
+            if (done == numSamples)
+                break;
+
+            position = wrapPosition(position, sourceLength);
+
+            const int index = juce::jmin(static_cast<int>(position), sourceLength - 1);
+            const float fraction = static_cast<float>(position - index);
+            const float gain = window.gain(phase);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                float taps[numTaps];
+
+                for (int tap = 0; tap < numTaps; ++tap)
+                    taps[tap] = Format::toFloat(channels[channel][wrapIndex(index - Interp::tapsBefore + tap, sourceLength)]);
+
+                destinations[channel][done] += static_cast<SampleType>(gain * Interp::read(taps, Interp::tapsBefore, fraction));
+            }
+
+            position = wrapPosition(position + increment, sourceLength);
+            phase += phaseIncrement;
+            ++done;
+        }
+
+        state.readPosition = position;
+        state.windowPhase = phase;
+    }
+
+    template <typename SampleType, WindowShape shape, Interpolation interpolation, int numChannels, bool reverse>
+    void renderGrain(GrainRenderState& state, const GrainSource& source, SampleType* const* outputs, int numSamples)
+    {
+        switch (source.storage)
+        {
+            case SampleStorage::int16:
+                renderGrainFrom<SampleStorage::int16, SampleType, shape, interpolation, numChannels, reverse>(state, source, outputs, numSamples);
+                break;
+
+            case SampleStorage::float16:
+                renderGrainFrom<SampleStorage::float16, SampleType, shape, interpolation, numChannels, reverse>(state, source, outputs, numSamples);
+                break;
+
+            case SampleStorage::float32:
+            case SampleStorage::numStorages:
+                renderGrainFrom<SampleStorage::float32, SampleType, shape, interpolation, numChannels, reverse>(state, source, outputs, numSamples);
+                break;
+        }
+    }
+
+    //==============================================================================
+    // The dispatch table holds one kernel per combination, indexed by
+    // ((window * numInterpolations + interpolation) * 2 + channels - 1) * 2 + reverse.
+
+    constexpr int numWindows = static_cast<int>(WindowShape::numShapes);
+    constexpr int numInterpolations = static_cast<int>(Interpolation::numInterpolations);
+    constexpr int numKernels = numWindows * numInterpolations * 2 * 2;
+
+    constexpr int getKernelIndex(int window, int interpolation, int numChannels, bool reverse)
+    {
+        return ((window * numInterpolations + interpolation) * 2 + numChannels - 1) * 2 + (reverse ? 1 : 0);
+    }
+
+    template <typename SampleType, int index>
+    constexpr GrainKernels::Kernel<SampleType> makeKernel()
+    {
+        return &renderGrain<SampleType,
+                            static_cast<WindowShape>(index / (numInterpolations * 4)),
+                            static_cast<Interpolation>((index / 4) % numInterpolations),
+                            (index / 2) % 2 + 1,
+                            index % 2 == 1>;
+    }
+
+    template <typename SampleType, int... indices>
+    constexpr std::array<GrainKernels::Kernel<SampleType>, sizeof...(indices)>
+        makeKernelTable(std::integer_sequence<int, indices...>)
+    {
+        return { { makeKernel<SampleType, indices>()... } };
+    }
+
+    template <typename SampleType>
+    constexpr auto kernelTable = makeKernelTable<SampleType>(std::make_integer_sequence<int, numKernels> {});
+}
+
+template <typename SampleType>
+GrainKernels::Kernel<SampleType> GrainKernels::select(const GrainRenderSettings& settings)
+{
+    const int index = getKernelIndex(static_cast<int>(settings.window),
+                                     static_cast<int>(settings.interpolation),
+                                     juce::jlimit(1, 2, settings.numChannels),
+                                     settings.reverse);
+
+    return kernelTable<SampleType>[(size_t)index];
+}
+
+void GrainKernels::prepareTables()
+{
+    getHannTable();
+    getTukeyTable();
+}
+
+template GrainKernels::Kernel<float> GrainKernels::select<float>(const GrainRenderSettings&);
+template GrainKernels::Kernel<double> GrainKernels::select<double>(const GrainRenderSettings&);
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    GrainKernels.h
+    Created: 18 Oct 2026 1:40:12pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleStorage.h"
+
+/**
+ * A non-owning view onto the audio that grains read from.
+ *
+ * Reads wrap around the end of the view, so the same grain code can play from a
+ * loaded file or from the circular live-input capture buffer without copying.
+ *
+ * Float sources are read through channels. Sources kept in a compact storage
+ * format are read through compactChannels instead, and the kernels convert
+ * them to float block by block as they render.
+ */
+struct GrainSource
+{
+    const float* const* channels = nullptr;         // One read pointer per channel, for float32 storage
+    int numChannels = 0;
+    int numSamples = 0;
+    SampleStorage storage = SampleStorage::float32;
+    const void* const* compactChannels = nullptr;   // One read pointer per channel, for the other formats
+
+    bool isEmpty() const { return numChannels == 0 || numSamples == 0; }
+};
+
+/** The envelope applied over the length of a grain. */
+enum class WindowShape
+{
+    hann = 0,
+    tukey,
+    triangle,
+    rectangular,
+    numShapes
+};
+
+/** How grains read between source samples when pitch shifted. */
+enum class Interpolation
+{
+    none = 0,   // Nearest sample, cheapest
+    linear,
+    cubic,      // 4-point Hermite
+    numInterpolations
+};
+
+/** The choices that select a grain's render kernel. */
+struct GrainRenderSettings
+{
+    WindowShape window = WindowShape::hann;
+    Interpolation interpolation = Interpolation::linear;
+    int numChannels = 2;        // Output channels rendered: 1 or 2
+    bool reverse = false;       // Read the source backwards
+};
+
+/** The per-grain state a render kernel advances. */
+struct GrainRenderState
+{
+    double readPosition = 0.0;      // Read position in the source, always within [0, numSamples)
+    double readIncrement = 1.0;     // Source samples advanced per output sample; negative when reversed
+    float windowPhase = 0.0f;       // Position within the window, from 0 to 1
+    float windowIncrement = 0.0f;   // Window phase advanced per output sample
+};
+
+namespace GrainKernels
+{
+    /**
+     * A function that renders numSamples of a grain, adding them to the output
+     * channels and advancing the grain's state.
+     */
+    template <typename SampleType>
+    using Kernel = void (*)(GrainRenderState& state, const GrainSource& source,
+                            SampleType* const* outputs, int numSamples);
+
+    /**
+     * Returns the kernel specialised for the given settings. Every combination is
+     * generated at compile time, so the choice costs one table lookup per grain and
+     * the render loop itself has no branches on window, interpolation, channel
+     * count or direction. The source's storage format is dispatched once per
+     * call, so a grain keeps working if its source is swapped for one stored
+     * differently.
+     *
+     * Instantiated for float and double output.
+     */
+    template <typename SampleType>
+    Kernel<SampleType> select(const GrainRenderSettings& settings);
+
+    /**
+     * Builds the process-wide window tables, if nothing has yet. They are built
+     * once and shared by every instance; call this before playback so the first
+     * grain never builds them on the audio thread.
+     */
+    void prepareTables();
+}
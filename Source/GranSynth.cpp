@@ -11,118 +11,862 @@
 #include "GranSynth.h"
 
 GranSynth::GranSynth()
+    : releaseQueue([this] { samplePool->releaseUnused(); })
 {
-    formatManager.registerBasicFormats();
+    grains.setTracer(&tracer);
 }
 
 GranSynth::~GranSynth()
 {
+    // The bake thread may still be calling back into its configure function
+    baker.cancel();
     releaseResources();
+
+    // Let the pool drop anything that only this instance was using
+    while (auto* command = commandQueue.peek())
+    {
+        command->source = nullptr;
+        commandQueue.pop();
+    }
+
+    currentSource = nullptr;
+    samplePool->releaseUnused();
 }
 
-void GranSynth::prepareToPlay(double sampleRate, int samplesPerBlock)
+void GranSynth::prepareToPlay(double sampleRate, int samplesPerBlock, int numOutputChannels)
 {
+    // Instances that are never played don't pay for a thread or the shared tables
+    releaseQueue.start();
+    GrainKernels::prepareTables();
+
     currentSampleRate = sampleRate;
     currentSamplesPerBlock = samplesPerBlock;
+    renderSettings.numChannels = juce::jlimit(1, 2, numOutputChannels);
+
+    // Enough history for the longest delay, plus the longest grain and a block of slack
+    const int captureCapacity = static_cast<int>(std::ceil(maxLiveDelaySeconds * sampleRate)) + samplesPerBlock + 2048;
+    captureBuffer.prepare(2, captureCapacity);
+
+    governor.prepare(sampleRate, samplesPerBlock);
+    grains.clear();
+    sampleCounter = 0;
+
+    // Grains holding cached copies are gone, so an evicted cache can be prepared
+    // again. It isn't prepared here, as most instances never turn it on.
+    if (grainCacheEvictionRequested)
+    {
+        grainCache.release();
+        grainCacheReady = false;
+    }
+
+    grainCacheEvicted = false;
+    grainCacheUnused = false;
+    grainCacheEvictionRequested = false;
+
+    // A loop baked at another rate or block size no longer fits
+    baker.cancel();
+    bakedCloud = nullptr;
+    bakedMix = 0.0f;
+    playingBakedCloud = false;
+    bakedCloudBytes = 0;
+    noteParameterChange();
 }
 
 void GranSynth::releaseResources()
 {
     grains.clear();
+    grainCache.release();
+    grainCacheReady = false;
+
+    // The audio thread is stopped, so the loop can be dropped here
+    baker.cancel();
+    bakedCloud = nullptr;
+    bakedMix = 0.0f;
+    playingBakedCloud = false;
+    bakedCloudBytes = 0;
 }
 
 void GranSynth::setGrainParameters(int size, int overlap, int spacing)
 {
+    if (size != grainSize || overlap != grainOverlap || spacing != grainSpacing)
+        noteParameterChange();
+
     grainSize = size;
     grainOverlap = overlap;
     grainSpacing = spacing;
 }
 
-void GranSynth::loadAudioFile(const juce::File& audioFile)
+void GranSynth::setPitchShift(float semitones)
+{
+    const float factor = std::exp2(semitones / 12.0f);
+
+    if (factor != continuousPitchShift)
+        noteParameterChange();
+
+    continuousPitchShift = factor;
+}
+
+void GranSynth::setGrainRendering(WindowShape window, Interpolation interpolation, bool reverse)
+{
+    if (window != renderSettings.window || interpolation != renderSettings.interpolation || reverse != renderSettings.reverse)
+        noteParameterChange();
+
+    renderSettings.window = window;
+    renderSettings.interpolation = interpolation;
+    renderSettings.reverse = reverse;
+}
+
+void GranSynth::setPitchSynchronous(bool enabled)
+{
+    if (enabled != pitchSynchronous)
+        noteParameterChange();
+
+    pitchSynchronous = enabled;
+}
+
+void GranSynth::setGrainFilter(GrainFilterMode mode, float cutoffHz, float resonance, float spreadOctaves)
+{
+    if (mode != filterMode || cutoffHz != filterCutoff || resonance != filterResonance || spreadOctaves != filterSpread)
+        noteParameterChange();
+
+    filterMode = mode;
+    filterCutoff = cutoffHz;
+    filterResonance = resonance;
+    filterSpread = spreadOctaves;
+}
+
+void GranSynth::setGrainCacheEnabled(bool enabled)
+{
+    // The cache moves grain starts onto a grid, which changes the texture slightly
+    if (enabled != grainCacheEnabled)
+        noteParameterChange();
+
+    grainCacheEnabled = enabled;
+}
+
+void GranSynth::prepareGrainCache()
+{
+    // An evicted cache stays gone until the engine is prepared again
+    if (grainCacheReady.load(std::memory_order_relaxed) || grainCacheEvictionRequested)
+        return;
+
+    grainCache.prepare(residency);
+    grainCacheReady.store(true, std::memory_order_release);
+}
+
+void GranSynth::setLiveInputParameters(bool enabled, bool freeze, float minDelayMs, float maxDelayMs)
+{
+    const bool modeChanged = enabled != liveInputEnabled;
+
+    // Grains that were reading from the other source would jump to unrelated audio,
+    // and a baked loop of either source no longer matches what is playing
+    if (modeChanged)
+    {
+        grains.clear();
+        noteParameterChange();
+    }
+
+    liveInputEnabled = enabled;
+    captureBuffer.setFrozen(freeze);
+
+    const int minDelay = static_cast<int>(minDelayMs * 0.001 * currentSampleRate);
+    const int maxDelay = static_cast<int>(maxDelayMs * 0.001 * currentSampleRate);
+
+    liveDelayMin = juce::jmin(minDelay, maxDelay);
+    liveDelayMax = juce::jmax(minDelay, maxDelay);
+}
+
+template <typename SampleType>
+void GranSynth::captureInput(const juce::AudioBuffer<SampleType>& input)
+{
+    if (liveInputEnabled)
+        captureBuffer.write(input);
+}
+
+SourceBuffer::Ptr GranSynth::loadAudioFile(const juce::File& audioFile, SampleStorage storage, bool convertToEngineRate)
 {
     if (!audioFile.existsAsFile())
     {
         DBG("Selected file does not exist.");
-        return;
+        return nullptr;
     }
 
-    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioFile));
+    SourceBuffer::Ptr newSource = samplePool->getOrLoad(audioFile, convertToEngineRate ? currentSampleRate : 0.0,
+                                                        storage, residency);
 
-    if (reader != nullptr)
+    if (newSource == nullptr)
     {
-        sourceBuffer.setSize((int)reader->numChannels, (int)reader->lengthInSamples);
-        reader->read(&sourceBuffer, 0, (int)reader->lengthInSamples, 0, true, true);
+        DBG("Failed to create AudioFormatReader for the selected file.");
+        return nullptr;
+    }
 
-        DBG("Audio file loaded successfully.");
+    if (!commandQueue.push({ EngineCommand::Type::loadComplete, newSource, {} }))
+    {
+        DBG("Engine command queue is full; the loaded file was not sent to the engine.");
+        return nullptr;
     }
-    else
+
+    sentSource = newSource;
+
+    DBG("Audio file loaded successfully.");
+    return newSource;
+}
+
+bool GranSynth::swapSource(SourceBuffer::Ptr newSource)
+{
+    SourceBuffer::Ptr sent = newSource;
+
+    if (!commandQueue.push({ EngineCommand::Type::swapSource, std::move(newSource), {} }))
+        return false;
+
+    sentSource = std::move(sent);
+    return true;
+}
+
+MemoryAccounting::Usage GranSynth::getMemoryUsage(bool includePooled) const
+{
+    using Category = MemoryAccounting::Category;
+
+    MemoryAccounting::Usage usage;
+    usage[Category::buffers] = (juce::int64)sizeof(GrainBank) + captureBuffer.getSizeInBytes() + tracer.getSizeInBytes();
+
+    // An evicted cache is on its way out, so it no longer counts against the budget
+    if (!grainCacheEvictionRequested)
+        usage[Category::caches] = grainCache.getSizeInBytes();
+
+    usage[Category::caches] += bakedCloudBytes.load(std::memory_order_relaxed);
+
+    if (sentSource != nullptr && (includePooled || !samplePool->contains(sentSource.get())))
     {
-        DBG("Failed to create AudioFormatReader for the selected file.");
+        usage[Category::sources] = sentSource->getSizeInBytes();
+
+        if (const auto* marks = sentSource->getPitchMarks())
+            usage[Category::analysis] = (juce::int64)marks->getSizeInBytes();
     }
+
+    return usage;
 }
 
-void GranSynth::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+juce::int64 GranSynth::evictGrainCache()
 {
-    buffer.clear();
-    handleMidi(midiMessages);
+    if (grainCacheEvictionRequested || grainCache.getSizeInBytes() == 0)
+        return 0;
+
+    if (!commandQueue.push({ EngineCommand::Type::evictGrainCache, nullptr, {} }))
+        return 0;
 
-    int numSamples = buffer.getNumSamples();
-    sampleCounter += numSamples;
+    grainCacheEvictionRequested = true;
+    return grainCache.getSizeInBytes();
+}
 
-    // Check if it's time to create a new grain
-    int grainInterval = grainSize - grainOverlap + grainSpacing;
-    if (sampleCounter >= grainInterval)
+void GranSynth::finishGrainCacheEviction()
+{
+    if (grainCacheEvictionRequested && grainCacheUnused.load(std::memory_order_acquire) && grainCache.getSizeInBytes() > 0)
     {
-        sampleCounter = 0;
+        grainCache.release();
+        grainCacheReady = false;
+    }
+}
 
-        // Remove finished grains
-        grains.erase(std::remove_if(grains.begin(), grains.end(),
-            [](const std::unique_ptr<Grain>& grain) { return grain->isFinished(); }),
-            grains.end());
+void GranSynth::panic()
+{
+    commandQueue.push({ EngineCommand::Type::panic, nullptr, {} });
+}
+
+bool GranSynth::bakeCloud(double seconds, std::function<void(GranSynth&)> configure)
+{
+    if (sentSource == nullptr || seconds <= 0.0)
+        return false;
+
+    CloudBaker::Request request;
+    request.source = sentSource;
+    request.sampleRate = currentSampleRate;
+    request.blockSize = currentSamplesPerBlock;
+    request.numChannels = renderSettings.numChannels;
+    request.seconds = seconds;
+    request.seed = juce::Random().nextInt64();
+
+    // Read before the parameters are, so a change made in between makes the
+    // cloud stale rather than wrongly current
+    request.parameterGeneration = publishedGeneration.load(std::memory_order_acquire);
+    request.notePitch = publishedNotePitch.load(std::memory_order_relaxed);
+    request.configure = std::move(configure);
+
+    baker.bake(std::move(request));
+    return true;
+}
+
+bool GranSynth::setGovernorSettings(const CpuGovernor::Settings& settings)
+{
+    return commandQueue.push({ EngineCommand::Type::reconfigure, nullptr, settings });
+}
+
+template <typename SampleType>
+void GranSynth::renderGrains(const GrainSource& source, juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
+{
+    const PitchMarks* marks = getActivePitchMarks();
+    const int grainInterval = juce::jmax(minGrainInterval, grainSize - grainOverlap + grainSpacing);
 
-        // Create new grains if notes are active
-        // For simplicity, we create grains continuously
-        if (sourceBuffer.getNumSamples() > 0)
+    // Grains fall due every interval however the block is split, so render up to
+    // each one and carry what is left of the interval into the next span
+    int position = 0;
+
+    while (position < numSamples)
+    {
+        if (sampleCounter >= grainInterval)
         {
-            int startSample = juce::Random::getSystemRandom().nextInt(sourceBuffer.getNumSamples() - grainSize);
-            float pitchShiftFactor = 1.0f; // Adjust as needed
+            sampleCounter -= grainInterval;
+
+            // A shorter interval than the one counted towards starts the next grain a full interval on
+            if (sampleCounter >= grainInterval)
+                sampleCounter = 0;
 
-            grains.push_back(std::make_unique<Grain>(sourceBuffer, startSample, grainSize, pitchShiftFactor, currentSampleRate));
+            // In PSOLA mode the grain interval moves the stream somewhere new instead
+            if (marks != nullptr)
+                psolaPosition = random.nextInt(juce::jmax(1, source.numSamples));
+            else
+                spawnGrain(source, continuousPitchShift);
         }
+
+        const int spanLength = juce::jmin(numSamples - position, grainInterval - sampleCounter);
+
+        if (marks != nullptr)
+            renderPitchSynchronous(source, *marks, buffer, startSample + position, spanLength);
+        else
+            grains.render(source, buffer, startSample + position, spanLength);
+
+        sampleCounter += spanLength;
+        position += spanLength;
     }
+}
+
+template <typename SampleType>
+void GranSynth::renderPitchSynchronous(const GrainSource& source, const PitchMarks& marks,
+                                       juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
+{
+    const float rateCorrection = currentSource->getSampleRate() > 0.0
+                               ? static_cast<float>(currentSource->getSampleRate() / currentSampleRate) : 1.0f;
+    const float pitch = continuousPitchShift * psolaNotePitch;
 
-    // Process and mix all grains into the output buffer
-    for (auto& grain : grains)
+    // Grains start part way through the span, so render up to each start in turn
+    int position = 0;
+
+    while (position < numSamples)
     {
-        grain->processGrain(buffer, 0); // Adjust startSampleInOutput as needed
+        if (psolaCountdown <= 0)
+        {
+            const int markIndex = marks.findNearest(psolaPosition);
+            spawnPitchSynchronousGrain(source, marks, markIndex, rateCorrection);
+
+            // Overlapping the grains at the target period rather than the source's sets the pitch
+            psolaCountdown += juce::jmax(1, juce::roundToInt((float)marks.getPeriod(markIndex) / (rateCorrection * pitch)));
+        }
+
+        const int span = juce::jmin(numSamples - position, psolaCountdown);
+        grains.render(source, buffer, startSample + position, span);
+
+        position += span;
+        psolaCountdown -= span;
+
+        // The stream reads the source at its original speed, whatever the pitch
+        psolaPosition += span * rateCorrection;
+
+        if (psolaPosition >= source.numSamples)
+            psolaPosition -= source.numSamples;
     }
 }
 
-void GranSynth::handleMidi(const juce::MidiBuffer& midiMessages)
+template <typename SampleType>
+void GranSynth::processBlock(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
 {
+    const TraceRecorder::Scope trace(tracer, "processBlock", buffer.getNumSamples());
+
+    buffer.clear();
+
+    handleCommands();
+
+    // Grains finished last block, so once none hold a cached copy the cache can go
+    if (grainCacheEvicted && !grainCacheUnused.load(std::memory_order_relaxed) && !grains.holdsCachedGrains())
+        grainCacheUnused.store(true, std::memory_order_release);
+
+    // Notes change the cloud, so they end any baked loop before they are rendered.
+    // Anything handleMidiMessage() ignores, such as clock or controllers, doesn't.
     for (const auto metadata : midiMessages)
     {
-        const auto& message = metadata.getMessage();
-        const int samplePosition = metadata.samplePosition;
+        const auto message = metadata.getMessage();
+
+        if (message.isNoteOnOrOff() || message.isAllNotesOff())
+        {
+            noteParameterChange();
+            break;
+        }
+    }
+
+    takeBakedClouds();
+    publishedGeneration.store(parameterGeneration, std::memory_order_release);
+
+    // Fully on the loop: grains stay where they are until something changes
+    if (bakedMix >= 1.0f && isBakedCloudCurrent())
+    {
+        mixBakedCloud(buffer);
+        publishTailLength();
+        return;
+    }
+
+    const GrainSource source = getActiveSource();
+    const int numSamples = buffer.getNumSamples();
+
+    // With nothing to hear, skip the scheduler, the governor and the MIDI entirely.
+    // Notes can only spawn grains, and those grains would be silent.
+    if (isIdle(source))
+    {
+        mixBakedCloud(buffer);
+        publishTailLength();
+        return;
+    }
+
+    governor.beginBlock();
+
+    // Render up to each event, then apply it, so notes start on the sample the host
+    // scheduled them. Events are sorted by position, and events sharing a position
+    // cost nothing extra as there is nothing to render between them.
+    int position = 0;
+
+    for (const auto metadata : midiMessages)
+    {
+        const int eventPosition = juce::jlimit(position, numSamples, metadata.samplePosition);
+
+        if (eventPosition > position)
+        {
+            renderGrains(source, buffer, position, eventPosition - position);
+            position = eventPosition;
+        }
+
+        handleMidiMessage(metadata.getMessage(), source);
+    }
+
+    if (position < numSamples)
+        renderGrains(source, buffer, position, numSamples - position);
+
+    // Finished grains render nothing, so they are only removed once per block
+    grains.removeFinished();
+
+    shedOldestGrains();
+
+    const int previousLevel = governor.getLevel();
+    governor.endBlock(numSamples, grains.size());
+
+    if (governor.getLevel() != previousLevel)
+        tracer.recordInstant("governorLevel", governor.getLevel());
+
+    tracer.recordCounter("activeGrains", grains.size());
+
+    mixBakedCloud(buffer);
+    publishTailLength();
+}
+
+void GranSynth::takeBakedClouds()
+{
+    BakedCloud::Ptr cloud;
+
+    // Each cloud taken retires exactly one, so one free slot is enough
+    while (releaseQueue.hasSpace() && baker.pop(cloud))
+    {
+        // A cloud that's already audible keeps playing rather than jumping to an equivalent one
+        const bool audible = bakedCloud != nullptr && bakedMix > 0.0f;
 
-        if (message.isNoteOn())
+        if (cloud->parameterGeneration == parameterGeneration && !audible)
         {
-            int midiNoteNumber = message.getNoteNumber();
-            float pitchShiftFactor = midiNoteToPitchShift(midiNoteNumber);
+            tracer.recordInstant("bakedCloud");
+            std::swap(bakedCloud, cloud);
+            bakedPosition = 0;
+            bakedCloudBytes.store(bakedCloud->getSizeInBytes(), std::memory_order_relaxed);
+        }
+
+        releaseQueue.push(cloud);
+    }
+}
+
+bool GranSynth::isBakedCloudCurrent() const noexcept
+{
+    return bakedCloud != nullptr && bakedCloud->parameterGeneration == parameterGeneration && !liveInputEnabled;
+}
+
+template <typename SampleType>
+void GranSynth::mixBakedCloud(juce::AudioBuffer<SampleType>& buffer)
+{
+    if (bakedCloud == nullptr)
+        return;
+
+    const bool current = isBakedCloudCurrent();
+    const float target = current ? 1.0f : 0.0f;
+
+    if (bakedMix != target || bakedMix > 0.0f)
+    {
+        const auto& loop = bakedCloud->loop;
+        const int loopLength = loop.getNumSamples();
+        const int loopChannels = loop.getNumChannels();
+        const int numChannels = buffer.getNumChannels();
+        const int numSamples = buffer.getNumSamples();
+        const float step = 1.0f / (float)(bakedCrossfadeSeconds * currentSampleRate);
+
+        if (bakedMix == target)
+        {
+            // Fully on the loop: a straight copy, split where it wraps
+            for (int start = 0; start < numSamples;)
+            {
+                const int span = juce::jmin(numSamples - start, loopLength - bakedPosition);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    const float* in = loop.getReadPointer(channel % loopChannels, bakedPosition);
+                    SampleType* out = buffer.getWritePointer(channel, start);
+
+                    for (int i = 0; i < span; ++i)
+                        out[i] = static_cast<SampleType>(in[i]);
+                }
+
+                start += span;
+                bakedPosition = (bakedPosition + span) % loopLength;
+            }
+        }
+        else
+        {
+            // Live grains and the loop are uncorrelated, so fade with equal power
+            for (int i = 0; i < numSamples; ++i)
+            {
+                bakedMix = bakedMix < target ? juce::jmin(target, bakedMix + step) : juce::jmax(target, bakedMix - step);
+
+                const float angle = juce::MathConstants<float>::halfPi * bakedMix;
+                const auto liveGain = static_cast<SampleType>(std::cos(angle));
+                const auto loopGain = static_cast<SampleType>(std::sin(angle));
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    SampleType* out = buffer.getWritePointer(channel);
+                    out[i] = out[i] * liveGain + static_cast<SampleType>(loop.getSample(channel % loopChannels, bakedPosition)) * loopGain;
+                }
+
+                if (++bakedPosition == loopLength)
+                    bakedPosition = 0;
+            }
+        }
+    }
+
+    // Once faded out, a stale cloud can never become current again
+    if (!current && bakedMix <= 0.0f && releaseQueue.push(bakedCloud))
+        bakedCloudBytes.store(0, std::memory_order_relaxed);
+
+    playingBakedCloud.store(bakedMix > 0.0f, std::memory_order_relaxed);
+}
+
+template void GranSynth::captureInput<float>(const juce::AudioBuffer<float>&);
+template void GranSynth::captureInput<double>(const juce::AudioBuffer<double>&);
+template void GranSynth::processBlock<float>(juce::AudioBuffer<float>&, juce::MidiBuffer&);
+template void GranSynth::processBlock<double>(juce::AudioBuffer<double>&, juce::MidiBuffer&);
+
+void GranSynth::handleCommands()
+{
+    while (auto* command = commandQueue.peek())
+    {
+        switch (command->type)
+        {
+            case EngineCommand::Type::loadComplete:
+            case EngineCommand::Type::swapSource:
+                // The old source goes to the release thread. If that queue is full,
+                // leave the command where it is and try again next block.
+                if (!releaseQueue.hasSpace())
+                    return;
+
+                tracer.recordInstant("swapSource");
+                releaseQueue.push(currentSource);
+                currentSource = std::move(command->source);
 
-            int startSample = juce::Random::getSystemRandom().nextInt(sourceBuffer.getNumSamples() - grainSize);
-            grains.push_back(std::make_unique<Grain>(sourceBuffer, startSample, grainSize, pitchShiftFactor, currentSampleRate));
+                // Cached grains rendered from the previous source no longer apply
+                grainCache.invalidate();
+                noteParameterChange();
+                break;
+
+            case EngineCommand::Type::panic:
+                tracer.recordInstant("panic");
+                grains.clear();
+                noteParameterChange();
+                break;
+
+            case EngineCommand::Type::reconfigure:
+                governor.setSettings(command->governorSettings);
+                break;
+
+            case EngineCommand::Type::evictGrainCache:
+                tracer.recordInstant("evictGrainCache");
+                grainCacheEvicted = true;
+                grainCache.invalidate();
+                break;
         }
-        else if (message.isNoteOff())
+
+        commandQueue.pop();
+    }
+}
+
+void GranSynth::handleMidiMessage(const juce::MidiMessage& message, const GrainSource& source)
+{
+    const TraceRecorder::Scope trace(tracer, "handleMidiMessage");
+
+    if (message.isNoteOn())
+    {
+        int midiNoteNumber = message.getNoteNumber();
+        float pitchShiftFactor = midiNoteToPitchShift(midiNoteNumber);
+
+        // In PSOLA mode a note retunes the stream and restarts it somewhere new
+        if (getActivePitchMarks() != nullptr)
         {
-            // Handle note-off events if necessary
-            grains.clear();
+            psolaNotePitch = pitchShiftFactor;
+            psolaPosition = random.nextInt(juce::jmax(1, source.numSamples));
+            psolaCountdown = 0;
+
+            // Published ahead of the next generation, so a bake stamped with an
+            // older one is stale rather than played at the old pitch
+            publishedNotePitch.store(pitchShiftFactor, std::memory_order_relaxed);
+            noteParameterChange();
+            return;
         }
-        else if (message.isAllNotesOff())
+
+        spawnGrain(source, pitchShiftFactor);
+    }
+    else if (message.isNoteOff())
+    {
+        // Handle note-off events if necessary
+        grains.clear();
+    }
+    else if (message.isAllNotesOff())
+    {
+        grains.clear();
+    }
+}
+
+bool GranSynth::isIdle(const GrainSource& source) const
+{
+    if (grains.size() > 0)
+        return false;
+
+    if (liveInputEnabled)
+        return captureBuffer.isSilent();
+
+    return source.isEmpty();
+}
+
+void GranSynth::publishTailLength()
+{
+    if (!liveInputEnabled && currentSource != nullptr)
+    {
+        tailSeconds.store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+        return;
+    }
+
+    int tail = grains.getLongestRemaining();
+
+    if (liveInputEnabled)
+    {
+        // Input arriving now may be read after the longest delay, by a grain that then
+        // plays out in full (MIDI grains at other pitches count once they are playing)
+        int newestGrain = liveDelayMax + Grain::getOutputLength(grainSize, continuousPitchShift);
+
+        if (filterMode != GrainFilterMode::off)
+            newestGrain += static_cast<int>(GrainBank::maxTailSeconds * currentSampleRate);
+
+        tail = juce::jmax(tail, newestGrain);
+    }
+
+    tailSeconds.store(tail / currentSampleRate, std::memory_order_relaxed);
+}
+
+GrainSource GranSynth::getActiveSource() const
+{
+    if (liveInputEnabled)
+        return captureBuffer.getSource();
+
+    if (currentSource == nullptr)
+        return {};
+
+    // While the source is still decoding, grains only see the part that is ready
+    return currentSource->getGrainSource();
+}
+
+void GranSynth::spawnGrain(const GrainSource& source, float pitchShiftFactor)
+{
+    if (source.isEmpty() || grains.isFull())
+        return;
+
+    if (!governor.tryConsumeSpawn())
+    {
+        tracer.recordInstant("spawnCapped");
+        return;
+    }
+
+    const TraceRecorder::Scope trace(tracer, "spawnGrain", grains.size());
+
+    const auto filter = makeGrainFilter();
+
+    // Under load, new grains use the next cheaper interpolator
+    GrainRenderSettings settings = renderSettings;
+
+    if (governor.isStepActive(CpuGovernor::Step::reduceInterpolation) && settings.interpolation != Interpolation::none)
+        settings.interpolation = static_cast<Interpolation>(static_cast<int>(settings.interpolation) - 1);
+
+    if (liveInputEnabled)
+    {
+        const int startSample = chooseLiveStartSample(pitchShiftFactor, renderSettings.reverse);
+
+        if (startSample >= 0)
+            grains.add(startSample, grainSize, pitchShiftFactor, source.numSamples, settings, filter);
+
+        return;
+    }
+
+    // Sources are converted to the engine rate when loaded, but the host may have
+    // changed rate since, so correct for any difference when reading
+    if (currentSource != nullptr && currentSource->getSampleRate() > 0.0)
+        pitchShiftFactor *= static_cast<float>(currentSource->getSampleRate() / currentSampleRate);
+
+    int startSample = random.nextInt(juce::jmax(1, source.numSamples - grainSize));
+
+    // Grains from a partly decoded source may wrap early, so they aren't cached
+    if (grainCacheEnabled && !grainCacheEvicted && grainCacheReady.load(std::memory_order_acquire)
+        && currentSource->isFullyLoaded()
+        && Grain::getOutputLength(grainSize, pitchShiftFactor) <= RenderedGrainCache::maxGrainLength)
+    {
+        // Snap to the cache grid so that nearby grains share one rendered copy
+        startSample -= startSample % RenderedGrainCache::positionQuantum;
+
+        RenderedGrainCache::Key key;
+        key.generation = grainCache.getGeneration();
+        key.startSample = startSample;
+        key.grainSize = grainSize;
+        key.pitchCents = juce::roundToInt(120000.0 * std::log2((double)pitchShiftFactor));
+        key.window = (juce::uint8)settings.window;
+        key.interpolation = (juce::uint8)settings.interpolation;
+        key.numChannels = (juce::uint8)settings.numChannels;
+        key.reverse = settings.reverse;
+
+        auto cachedGrain = grainCache.find(key);
+
+        if (cachedGrain.isValid())
         {
-            grains.clear();
+            grains.addCached(std::move(cachedGrain), filter);
+            grainActivity.push({ startSample, grainSize, pitchShiftFactor });
+            return;
         }
+
+        grainCache.request(key, currentSource, settings, pitchShiftFactor);
+    }
+
+    grains.add(startSample, grainSize, pitchShiftFactor, source.numSamples, settings, filter);
+
+    grainActivity.push({ startSample, grainSize, pitchShiftFactor });
+}
+
+const PitchMarks* GranSynth::getActivePitchMarks() const noexcept
+{
+    // Marks are only analysed once the whole file has loaded
+    if (!pitchSynchronous || liveInputEnabled || currentSource == nullptr || !currentSource->isFullyLoaded())
+        return nullptr;
+
+    const PitchMarks* marks = currentSource->getPitchMarks();
+
+    return marks != nullptr && !marks->isEmpty() ? marks : nullptr;
+}
+
+void GranSynth::spawnPitchSynchronousGrain(const GrainSource& source, const PitchMarks& marks, int markIndex, float rateCorrection)
+{
+    if (grains.isFull())
+        return;
+
+    if (!governor.tryConsumeSpawn())
+    {
+        tracer.recordInstant("spawnCapped");
+        return;
     }
+
+    const TraceRecorder::Scope trace(tracer, "spawnPitchSynchronousGrain", grains.size());
+
+    // Hann windows two periods long, a period apart, sum to a constant at the source
+    // pitch; the grain itself is never resampled, so the formants stay put
+    GrainRenderSettings settings = renderSettings;
+    settings.window = WindowShape::hann;
+    settings.reverse = false;
+
+    if (governor.isStepActive(CpuGovernor::Step::reduceInterpolation) && settings.interpolation != Interpolation::none)
+        settings.interpolation = static_cast<Interpolation>(static_cast<int>(settings.interpolation) - 1);
+
+    const int period = marks.getPeriod(markIndex);
+    const int startSample = marks.getMark(markIndex) - period;
+    const int length = 2 * period;
+
+    grains.add(startSample, length, rateCorrection, source.numSamples, settings, makeGrainFilter());
+
+    grainActivity.push({ startSample, length, rateCorrection });
+}
+
+int GranSynth::chooseLiveStartSample(float pitchShiftFactor, bool reverse)
+{
+    // Delays are measured backwards from the write head. A grain covers grainSize source
+    // samples over outputLength output samples, while the write head advances one sample
+    // per output sample:
+    //  - pitched up, it reads faster than the input arrives, so it must start at least
+    //    grainSize - outputLength behind the head to never overtake it;
+    //  - pitched down, it falls behind, so it must start late enough that the writer
+    //    doesn't wrap round onto it before it finishes (unless the capture is frozen).
+    // A reversed grain starts reading from the end of its span, so the whole span must
+    // already be captured, and its oldest sample is read last.
+    const int outputLength = Grain::getOutputLength(grainSize, pitchShiftFactor);
+    const auto source = captureBuffer.getSource();
+
+    const int newestDelay = reverse ? grainSize + 1 : juce::jmax(0, grainSize - outputLength) + 1;
+    const int lag = reverse ? outputLength : juce::jmax(0, outputLength - grainSize);
+    int oldestDelay = captureBuffer.getNumValidSamples();
+
+    if (!captureBuffer.isFrozen())
+        oldestDelay = juce::jmin(oldestDelay, source.numSamples - lag - 1);
+
+    const int minDelay = juce::jmax(newestDelay, liveDelayMin);
+    const int maxDelay = juce::jmin(oldestDelay, juce::jmax(minDelay, liveDelayMax));
+
+    if (maxDelay < minDelay)
+        return -1;
+
+    const int delay = minDelay + random.nextInt(maxDelay - minDelay + 1);
+
+    return ((captureBuffer.getWritePosition() - delay) % source.numSamples + source.numSamples) % source.numSamples;
+}
+
+void GranSynth::shedOldestGrains()
+{
+    if (!governor.isStepActive(CpuGovernor::Step::fadeOldestGrains))
+        return;
+
+    const auto& settings = governor.getSettings();
+    const int fadeLength = juce::jmax(1, static_cast<int>(settings.fadeLengthMs * 0.001 * currentSampleRate));
+
+    const int numFaded = grains.fadeOutOldest(settings.grainsFadedPerBlock, fadeLength);
+
+    if (numFaded > 0)
+        tracer.recordInstant("fadeOldestGrains", numFaded);
+
+    governor.addFadedGrains(numFaded);
+}
+
+GrainBank::FilterCoefficients GranSynth::makeGrainFilter()
+{
+    if (filterMode == GrainFilterMode::off)
+        return {};
+
+    // Each grain gets its own cutoff, spread randomly either side of the base cutoff
+    float cutoff = filterCutoff;
+
+    if (filterSpread > 0.0f)
+        cutoff *= std::exp2(filterSpread * (2.0f * random.nextFloat() - 1.0f));
+
+    return GrainBank::FilterCoefficients::make(filterMode, cutoff, filterResonance, currentSampleRate);
 }
 
 float GranSynth::midiNoteToPitchShift(int midiNoteNumber)
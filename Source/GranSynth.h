@@ -12,10 +12,55 @@
 
 #include <JuceHeader.h>
 #include "Grain.h"
+#include "GrainBank.h"
+#include "SourceBuffer.h"
+#include "SamplePool.h"
+#include "GrainActivityFifo.h"
+#include "CaptureBuffer.h"
+#include "CpuGovernor.h"
+#include "RenderedGrainCache.h"
+#include "EngineCommandQueue.h"
+#include "ObjectReleaseQueue.h"
+#include "TraceRecorder.h"
+#include "MemoryAccounting.h"
+#include "CloudBaker.h"
 
+/**
+ * The granular engine.
+ *
+ * Thread ownership:
+ *  - Audio thread: processBlock(), captureInput() and the set...() parameter
+ *    methods, which the processor calls at the start of each block. Every member
+ *    that affects rendering belongs to the audio thread.
+ *  - Message thread: prepareToPlay() and releaseResources() (while the audio
+ *    thread is stopped), loadAudioFile(), swapSource(), panic(), bakeCloud()
+ *    and setGovernorSettings(). These never touch engine state directly; they push
+ *    commands that the audio thread applies at the top of its next block.
+ *  - Any thread: getGrainActivity() for its consumer, the governor's getState(),
+ *    getGrainCacheStats() and getSamplePool(). The tracer is started and stopped
+ *    from the message thread and records from the audio thread.
+ *
+ * Sources the audio thread stops using are handed to a release thread, so the
+ * audio thread never blocks, allocates or frees.
+ *
+ * When no grains are playing and there is nothing audible to spawn them from,
+ * processBlock() only applies pending commands and clears the buffer, which
+ * also flags it as silent for hosts that propagate silence.
+ *
+ * A static cloud can be baked into a loop with bakeCloud(). While nothing has
+ * changed since the bake was asked for, processBlock() crossfades to the loop
+ * and then only copies it out. Any parameter change, MIDI event, source swap or
+ * panic moves the parameter generation on, and the engine crossfades back to
+ * live grains.
+ */
 class GranSynth
 {
 public:
+    static constexpr double maxLiveDelaySeconds = 5.0;      // Longest delay a live-input grain can read at
+    static constexpr int maxGrains = GrainBank::capacity;   // Hard limit on simultaneously playing grains
+    static constexpr double bakedCrossfadeSeconds = 0.1;    // Fade between live grains and a baked cloud
+    static constexpr int minGrainInterval = 64;             // Shortest gap between grains, for overlaps as long as the grain
+
     /**
      * Constructor for the GranSynth class.
      */
@@ -31,8 +76,9 @@ public:
      *
      * @param sampleRate       The current sample rate.
      * @param samplesPerBlock  The maximum number of samples that will be processed in one block.
+     * @param numOutputChannels  The number of output channels that will be rendered.
      */
-    void prepareToPlay(double sampleRate, int samplesPerBlock);
+    void prepareToPlay(double sampleRate, int samplesPerBlock, int numOutputChannels = 2);
 
     /**
      * Releases any resources used by the synthesizer.
@@ -44,8 +90,12 @@ public:
      *
      * @param buffer         The audio buffer to process.
      * @param midiMessages   The MIDI messages to process.
+     *
+     * Instantiated for float and double buffers, so hosts running a 64-bit mix
+     * engine get a native path without a conversion per block.
      */
-    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages);
+    template <typename SampleType>
+    void processBlock(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
 
     /**
      * Sets the grain parameters for the synthesizer.
@@ -57,31 +107,407 @@ public:
     void setGrainParameters(int size, int overlap, int spacing);
 
     /**
-     * Loads an audio file into the synthesizer.
+     * Sets the pitch of the grains spawned continuously, as opposed to those
+     * started by MIDI notes.
+     *
+     * @param semitones  The shift in semitones, 0 for none.
+     */
+    void setPitchShift(float semitones);
+
+    /**
+     * Sets how new grains are rendered. Grains that are already playing keep the
+     * kernel they were created with.
+     *
+     * @param window         The window shape applied over each grain.
+     * @param interpolation  The interpolation used when reading between source samples.
+     * @param reverse        True to read grains backwards.
+     */
+    void setGrainRendering(WindowShape window, Interpolation interpolation, bool reverse);
+
+    /**
+     * Enables or disables pitch-synchronous (PSOLA) grains. While enabled, and once
+     * the loaded file's pitch marks have been analysed, grains are two pitch periods
+     * long, centred on the source's pitch marks, and started once per target period,
+     * so pitch changes without shifting formants. Live input, and files still
+     * loading or being analysed, fall back to resampled grains.
+     *
+     * @param enabled  True to use pitch-synchronous grains where possible.
+     */
+    void setPitchSynchronous(bool enabled);
+
+    /**
+     * Sets the resonant filter applied to new grains. Grains that are already
+     * playing keep the filter they were created with.
+     *
+     * @param mode           The filter response, or off.
+     * @param cutoffHz       The base cutoff or centre frequency.
+     * @param resonance      The filter Q.
+     * @param spreadOctaves  How far each grain's cutoff may stray either side of the base cutoff.
+     */
+    void setGrainFilter(GrainFilterMode mode, float cutoffHz, float resonance, float spreadOctaves);
+
+    /**
+     * Enables or disables the rendered grain cache. While enabled, file grains start
+     * on a coarse grid of positions so repeated grains can share one rendered copy.
+     * Grains only play from the cache once prepareGrainCache() has been called.
+     *
+     * @param enabled  True to play repeated grains from the cache.
+     */
+    void setGrainCacheEnabled(bool enabled);
+
+    /**
+     * Allocates the rendered grain cache and starts its fill thread, unless that
+     * has been done already. Engines that never enable the cache don't pay for
+     * it. Called from the message thread, or while the audio thread is stopped.
+     */
+    void prepareGrainCache();
+
+    /**
+     * Returns the rendered grain cache's hit, miss and fill counters. Safe to call
+     * from any thread.
+     */
+    RenderedGrainCache::Stats getGrainCacheStats() const { return grainCache.getStats(); }
+
+    /**
+     * Sets the live-input parameters for the synthesizer.
+     *
+     * @param enabled     True to granulate the captured host input instead of the loaded file.
+     * @param freeze      True to stop capturing, so grains keep reading the same audio.
+     * @param minDelayMs  The shortest delay behind the live input that grains start reading at.
+     * @param maxDelayMs  The longest delay behind the live input that grains start reading at.
+     */
+    void setLiveInputParameters(bool enabled, bool freeze, float minDelayMs, float maxDelayMs);
+
+    /**
+     * Writes a block of host input into the live capture buffer. Call this before
+     * processBlock(), as processBlock() overwrites the buffer with the output.
+     *
+     * @param input  The host input for this block.
+     */
+    template <typename SampleType>
+    void captureInput(const juce::AudioBuffer<SampleType>& input);
+
+    /**
+     * Reseeds the generator that picks grain start positions. With a fixed seed,
+     * the same parameters, MIDI and block sizes always render the same output,
+     * which makes renders comparable between builds. Call before playback.
+     *
+     * @param seed  The new seed.
+     */
+    void setRandomSeed(juce::int64 seed) { random.setSeed(seed); }
+
+    /**
+     * Sets the pitch PSOLA mode plays at, as if a note had retuned it. Used to
+     * bake a cloud at the live engine's pitch. Call before playback.
+     *
+     * @param pitch  The pitch factor of the note.
+     */
+    void setPsolaNotePitch(float pitch) noexcept { psolaNotePitch = pitch; }
+
+    /**
+     * Loads an audio file into the synthesizer. The decoded audio comes from the
+     * process-wide sample pool, so instances loading the same file share it.
+     *
+     * @param audioFile            The audio file to load.
+     * @param storage              How to hold the decoded samples in memory.
+     * @param convertToEngineRate  Convert the audio to the engine's sample rate when loading.
+     *                             Otherwise grains correct for the file's rate as they read,
+     *                             which costs less memory when the file's rate is lower.
+     * @return                     The newly loaded source, or nullptr if the file could not be read.
+     */
+    SourceBuffer::Ptr loadAudioFile(const juce::File& audioFile, SampleStorage storage = SampleStorage::float32,
+                                    bool convertToEngineRate = true);
+
+    /**
+     * Asks the engine to granulate a different source from its next block.
+     * Called from the message thread.
+     *
+     * @param newSource  The source to switch to, or nullptr for none.
+     * @return           False if the command queue was full.
+     */
+    bool swapSource(SourceBuffer::Ptr newSource);
+
+    /**
+     * Asks the engine to stop every grain at the start of its next block.
+     * Called from the message thread.
+     */
+    void panic();
+
+    /**
+     * Sets whether sources loaded and the grain cache prepared from now on are
+     * prefaulted and locked in memory, and backed by huge pages. Called from the
+     * message thread.
+     */
+    void setMemoryResidency(const ResidentMemory::Options& options) { residency = options; }
+
+    /**
+     * Returns the memory the engine holds, by category. Called from the message thread.
+     *
+     * @param includePooled  Count the source last sent to the engine, and its pitch
+     *                       marks, even if they are shared through the sample pool.
+     */
+    MemoryAccounting::Usage getMemoryUsage(bool includePooled) const;
+
+    /**
+     * Asks the engine to stop using the rendered grain cache, so that
+     * finishGrainCacheEviction() can free it once no grain is playing from it.
+     * After the next prepareToPlay() it can be prepared again. Called from the
+     * message thread.
+     *
+     * @return  The bytes that will be freed, or 0 if the cache is already gone.
+     */
+    juce::int64 evictGrainCache();
+
+    /**
+     * Frees an evicted grain cache once the engine has stopped using it. Called
+     * from the message thread.
+     */
+    void finishGrainCacheEviction();
+
+    /**
+     * Starts rendering the current cloud into a seamless loop on a background
+     * thread. Once it is ready, and if nothing has changed in the meantime, the
+     * engine plays the loop instead of rendering grains. Called from the message
+     * thread.
+     *
+     * @param seconds    The length of the loop.
+     * @param configure  Applies the current parameters to the engine that renders
+     *                   the loop. Called on the bake thread.
+     * @return           False if there is no source to bake.
+     */
+    bool bakeCloud(double seconds, std::function<void(GranSynth&)> configure);
+
+    /**
+     * Abandons any bake in progress. Call while the audio thread is stopped, e.g.
+     * before destroying whatever the configure function reads.
+     */
+    void cancelBake() { baker.cancel(); }
+
+    /**
+     * Returns true while a cloud is being baked. Safe to call from any thread.
+     */
+    bool isBaking() const noexcept { return baker.isBaking(); }
+
+    /**
+     * Returns true while a baked cloud can be heard, including while it fades in
+     * or out. Safe to call from any thread.
+     */
+    bool isPlayingBakedCloud() const noexcept { return playingBakedCloud.load(std::memory_order_relaxed); }
+
+    /**
+     * Sends new CPU governor settings to the engine. Called from the message thread.
      *
-     * @param audioFile  The audio file to load.
+     * @param settings  The settings to apply from the engine's next block.
+     * @return          False if the command queue was full.
+     */
+    bool setGovernorSettings(const CpuGovernor::Settings& settings);
+
+    /**
+     * Returns how long the output can go on after the input stops, as of the last
+     * block. Infinite while a file is loaded, as grains keep spawning from it with
+     * no input at all; otherwise the longest playing grain, plus the longest delay
+     * a live grain can read input from. Safe to call from any thread.
+     */
+    double getTailLengthSeconds() const noexcept { return tailSeconds.load(std::memory_order_relaxed); }
+
+    /**
+     * Returns the queue of grain spawn events, for visualising the grain cloud.
+     * Only the message thread may pop from it.
+     */
+    GrainActivityFifo& getGrainActivity() { return grainActivity; }
+
+    /**
+     * Returns the CPU-budget governor. Its settings and enablement may only be
+     * changed from the audio thread; its state may be read from any thread.
+     */
+    CpuGovernor& getGovernor() { return governor; }
+    const CpuGovernor& getGovernor() const { return governor; }
+
+    /**
+     * Returns the sample pool shared by all instances in the process.
+     */
+    SamplePool& getSamplePool() const { return *samplePool; }
+
+    /**
+     * Returns the recorder for audio-thread trace events. Start and stop it from
+     * the message thread.
      */
-    void loadAudioFile(const juce::File& audioFile);
+    TraceRecorder& getTracer() { return tracer; }
 
 private:
-    std::vector<std::unique_ptr<Grain>> grains; // Vector to manage active grains
-    juce::AudioBuffer<float> sourceBuffer;      // Buffer holding the loaded audio file
-    juce::AudioFormatManager formatManager;     // Manages audio formats for file loading
+    TraceRecorder tracer;                       // Opt-in timeline of audio-thread activity
+    GrainBank grains;                           // Every playing grain, in the order they started
+    SourceBuffer::Ptr currentSource;            // The source being granulated; audio thread only
+    juce::SharedResourcePointer<SamplePool> samplePool; // Decoded sources shared across instances
+    EngineCommandQueue commandQueue;            // Message thread to audio thread
+    ObjectReleaseQueue releaseQueue;            // Audio thread to release thread
+    GrainActivityFifo grainActivity;            // Grain spawn events for the editor
+    CaptureBuffer captureBuffer;                // Recent host input for live granulation
+    CpuGovernor governor;                       // Degrades grain density when over the CPU budget
+    juce::Random random;                        // Picks grain start positions
+    RenderedGrainCache grainCache;              // Rendered copies of repeated grains
+    bool grainCacheEnabled = false;
+    std::atomic<bool> grainCacheReady { false };    // The cache has been prepared and may be used
+    bool grainCacheEvicted = false;                 // Audio thread; set by evictGrainCache
+    std::atomic<bool> grainCacheUnused { false };   // No grain plays from an evicted cache any more
+    bool grainCacheEvictionRequested = false;       // Message thread only
+    SourceBuffer::Ptr sentSource;                   // The last source sent to the engine; message thread only
+
+    CloudBaker baker;                               // Renders baked clouds in the background
+    BakedCloud::Ptr bakedCloud;                     // The loop to play while nothing changes; audio thread only
+    int bakedPosition = 0;                          // Read position in the loop
+    float bakedMix = 0.0f;                          // 0 for live grains, 1 for the loop
+    juce::uint32 parameterGeneration = 0;           // Moves on whenever the cloud would sound different
+    std::atomic<juce::uint32> publishedGeneration { 0 };    // parameterGeneration as of the last block
+    std::atomic<bool> playingBakedCloud { false };
+    std::atomic<juce::int64> bakedCloudBytes { 0 };
+    ResidentMemory::Options residency;          // For new sources and cache slots; message thread only
+
+    bool liveInputEnabled = false;  // Granulate the capture buffer rather than the file
+    int liveDelayMin = 0;           // Live grain delay range in samples
+    int liveDelayMax = 0;
 
     int grainSize = 512;        // Grain size in samples
     int grainOverlap = 256;     // Grain overlap in samples
     int grainSpacing = 0;       // Grain spacing in samples
+    float continuousPitchShift = 1.0f;  // Pitch shift factor of continuously spawned grains
+
+    bool pitchSynchronous = false;      // PSOLA grains when the source has pitch marks
+    double psolaPosition = 0.0;         // Source position the pitch-synchronous stream has reached
+    int psolaCountdown = 0;             // Output samples until the next pitch-synchronous grain
+    float psolaNotePitch = 1.0f;        // Pitch factor of the last note, applied to the stream
+    std::atomic<float> publishedNotePitch { 1.0f };     // psolaNotePitch, for bakes
+
+    GrainRenderSettings renderSettings;     // Kernel choices for new grains
+
+    GrainFilterMode filterMode = GrainFilterMode::off;  // Per-grain filter for new grains
+    float filterCutoff = 2000.0f;
+    float filterResonance = 0.707f;
+    float filterSpread = 0.0f;              // In octaves
 
     double currentSampleRate = 44100.0;
     int currentSamplesPerBlock = 512;
     int sampleCounter = 0;
+    std::atomic<double> tailSeconds { 0.0 };    // Published at the end of each block
 
     /**
-     * Handles incoming MIDI messages.
+     * Returns true if no grains are playing and any new grain would only read
+     * silence, so a block can be skipped entirely.
+     */
+    bool isIdle(const GrainSource& source) const;
+
+    /**
+     * Notes that the cloud would now sound different from any baked loop.
+     */
+    void noteParameterChange() noexcept { ++parameterGeneration; }
+
+    /**
+     * Takes finished clouds from the baker, keeping one that matches the current
+     * parameters and retiring the rest. Audio thread only.
+     */
+    void takeBakedClouds();
+
+    /**
+     * Returns true if the baked cloud matches what the engine would render now.
+     */
+    bool isBakedCloudCurrent() const noexcept;
+
+    /**
+     * Crossfades the live output in the buffer towards or away from the baked
+     * cloud, and retires the cloud once it has faded out for good.
+     */
+    template <typename SampleType>
+    void mixBakedCloud(juce::AudioBuffer<SampleType>& buffer);
+
+    /**
+     * Works out the current tail length and publishes it for the host.
+     */
+    void publishTailLength();
+
+    /**
+     * Applies every pending command from the message thread.
+     */
+    void handleCommands();
+
+    /**
+     * Renders a span of the block: mixes every playing grain into it, spawning
+     * each grain that falls due on the sample it's due.
+     *
+     * @param source       The source grains read from.
+     * @param buffer       The output buffer.
+     * @param startSample  The first sample of the span within the buffer.
+     * @param numSamples   The length of the span.
+     */
+    template <typename SampleType>
+    void renderGrains(const GrainSource& source, juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples);
+
+    /**
+     * Renders a span in PSOLA mode: walks the source in real time, starting a grain
+     * on the nearest pitch mark each time one is due, and mixes every playing
+     * grain into the span up to each start.
+     */
+    template <typename SampleType>
+    void renderPitchSynchronous(const GrainSource& source, const PitchMarks& marks,
+                                juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples);
+
+    /**
+     * Returns the pitch marks to align grains to, or nullptr when grains should be
+     * resampled instead. Audio thread only.
+     */
+    const PitchMarks* getActivePitchMarks() const noexcept;
+
+    /**
+     * Creates a Hann-windowed grain centred on a pitch mark, spanning a period either side.
+     *
+     * @param source            The source to read the grain from.
+     * @param marks             The source's pitch marks.
+     * @param markIndex         The mark to centre the grain on.
+     * @param rateCorrection    The source rate over the engine rate.
+     */
+    void spawnPitchSynchronousGrain(const GrainSource& source, const PitchMarks& marks, int markIndex, float rateCorrection);
+
+    /**
+     * Handles a single MIDI message at the current render position.
+     *
+     * @param message  The MIDI message to handle.
+     * @param source   The source to spawn grains from.
+     */
+    void handleMidiMessage(const juce::MidiMessage& message, const GrainSource& source);
+
+    /**
+     * Returns the view grains should read from this block: the capture buffer in
+     * live mode, otherwise the loaded file (which may be empty).
+     */
+    GrainSource getActiveSource() const;
+
+    /**
+     * Creates a grain reading from the source and reports it to the grain activity queue.
      *
-     * @param midiMessages  The MIDI messages to handle.
+     * @param source            The source to read the grain from.
+     * @param pitchShiftFactor  The pitch shift factor for the grain.
+     */
+    void spawnGrain(const GrainSource& source, float pitchShiftFactor);
+
+    /**
+     * Picks a random start position for a live-input grain within the delay range,
+     * such that the grain never overtakes the write head nor reads audio that is
+     * overwritten while it plays.
+     *
+     * @param pitchShiftFactor  The pitch shift factor of the grain.
+     * @param reverse           True if the grain reads backwards.
+     * @return                  The start position, or -1 if not enough input has been captured.
+     */
+    int chooseLiveStartSample(float pitchShiftFactor, bool reverse);
+
+    /**
+     * Fades out the oldest grains while the governor asks for it.
+     */
+    void shedOldestGrains();
+
+    /**
+     * Designs the filter for a new grain from the current filter settings.
      */
-    void handleMidi(const juce::MidiBuffer& midiMessages);
+    GrainBank::FilterCoefficients makeGrainFilter();
 
     /**
      * Converts a MIDI note number to a pitch shift factor.
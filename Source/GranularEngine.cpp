@@ -0,0 +1,312 @@
+/*
+  ==============================================================================
+
+    GranularEngine.cpp
+    Created: 19 Oct 2026 1:07:36am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "GranularEngine.h"
+#include "GranSynth.h"
+
+/**
+ * The engine behind the C handle, with the parameter values the grouped
+ * GranSynth setters need.
+ */
+struct granular_engine
+{
+    GranSynth synth;
+    double sampleRate = 44100.0;
+    int maxBlockSize = 512;
+    int numChannels = 2;
+
+    int grainSize = 512;
+    int grainOverlap = 256;
+    int grainSpacing = 0;
+    WindowShape window = WindowShape::hann;
+    Interpolation interpolation = Interpolation::linear;
+    bool reverse = false;
+    GrainFilterMode filterMode = GrainFilterMode::off;
+    float filterCutoff = 2000.0f;
+    float filterResonance = 0.707f;
+    float filterSpread = 0.0f;
+
+    juce::MidiBuffer pendingNotes;  // Applied at the start of the next render
+
+    /**
+     * Passes the grouped parameters to the engine.
+     */
+    void applyParameters()
+    {
+        synth.setGrainParameters(grainSize, grainOverlap, grainSpacing);
+        synth.setGrainRendering(window, interpolation, reverse);
+        synth.setGrainFilter(filterMode, filterCutoff, filterResonance, filterSpread);
+    }
+
+    /**
+     * Turns the grain cache on or off, setting it up the first time it's turned on.
+     */
+    void setGrainCacheEnabled(bool enabled)
+    {
+        if (enabled)
+            synth.prepareGrainCache();
+
+        synth.setGrainCacheEnabled(enabled);
+    }
+
+    /**
+     * Hands a source to the engine, and starts its pitch analysis for PSOLA grains.
+     */
+    granular_result useSource(SourceBuffer::Ptr source)
+    {
+        synth.getSamplePool().analysePitchMarks(source);
+        return synth.swapSource(std::move(source)) ? GRANULAR_OK : GRANULAR_ERROR_BUSY;
+    }
+};
+
+namespace
+{
+    /**
+     * Runs the body of an entry point, turning anything it throws into a result,
+     * as exceptions must not cross the C interface.
+     */
+    template <typename Function>
+    granular_result guard(Function&& function) noexcept
+    {
+        try
+        {
+            return function();
+        }
+        catch (const std::bad_alloc&)
+        {
+            return GRANULAR_ERROR_OUT_OF_MEMORY;
+        }
+        catch (...)
+        {
+            return GRANULAR_ERROR_INTERNAL;
+        }
+    }
+
+    template <typename EnumType>
+    EnumType toChoice(double value, EnumType count)
+    {
+        return static_cast<EnumType>(juce::jlimit(0, static_cast<int>(count) - 1, juce::roundToInt(value)));
+    }
+}
+
+//==============================================================================
+granular_engine* granular_engine_create(double sample_rate, int max_block_size, int num_channels)
+{
+    if (sample_rate <= 0.0 || max_block_size <= 0 || num_channels < 1 || num_channels > 2)
+        return nullptr;
+
+    try
+    {
+        auto engine = std::make_unique<granular_engine>();
+        engine->sampleRate = sample_rate;
+        engine->maxBlockSize = max_block_size;
+        engine->numChannels = num_channels;
+
+        engine->synth.prepareToPlay(sample_rate, max_block_size, num_channels);
+
+        // Services render faster than real time, so there's no deadline to thin grains for
+        engine->synth.getGovernor().setEnabled(false);
+        engine->applyParameters();
+
+        return engine.release();
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void granular_engine_destroy(granular_engine* engine)
+{
+    try
+    {
+        delete engine;
+    }
+    catch (...)
+    {
+    }
+}
+
+granular_result granular_engine_load_file(granular_engine* engine, const char* utf8_path)
+{
+    if (engine == nullptr || utf8_path == nullptr)
+        return GRANULAR_ERROR_INVALID_ARGUMENT;
+
+    return guard([&]
+    {
+        const juce::File file(juce::String::fromUTF8(utf8_path));
+
+        // Kept at the file's own rate, as grains correct for it; instances loading the
+        // same file share one decoded copy
+        SourceBuffer::Ptr source = engine->synth.getSamplePool().getOrLoad(file, 0.0);
+
+        // Only sent once decoded, so a failed load leaves the previous source playing
+        // and a render straight after loading hears the whole file
+        if (source == nullptr || !source->waitUntilLoaded())
+            return GRANULAR_ERROR_LOAD_FAILED;
+
+        return engine->synth.swapSource(std::move(source)) ? GRANULAR_OK : GRANULAR_ERROR_BUSY;
+    });
+}
+
+granular_result granular_engine_load_memory(granular_engine* engine, const void* data, size_t num_bytes)
+{
+    if (engine == nullptr || data == nullptr || num_bytes == 0)
+        return GRANULAR_ERROR_INVALID_ARGUMENT;
+
+    return guard([&]
+    {
+        auto& formatManager = engine->synth.getSamplePool().getFormatManager();
+        std::unique_ptr<juce::AudioFormatReader> reader(
+            formatManager.createReaderFor(std::make_unique<juce::MemoryInputStream>(data, num_bytes, false)));
+
+        if (reader == nullptr || reader->numChannels == 0 || reader->lengthInSamples <= 0
+            || reader->lengthInSamples > std::numeric_limits<int>::max())
+            return GRANULAR_ERROR_LOAD_FAILED;
+
+        const int numSamples = (int)reader->lengthInSamples;
+        SourceBuffer::Ptr source = new SourceBuffer("Memory", (int)reader->numChannels, numSamples, reader->sampleRate);
+
+        if (!reader->read(&source->getAudioSampleBuffer(), 0, numSamples, 0, true, true))
+            return GRANULAR_ERROR_LOAD_FAILED;
+
+        return engine->useSource(std::move(source));
+    });
+}
+
+granular_result granular_engine_load_samples(granular_engine* engine, const float* const* channels,
+                                             int num_channels, int num_frames, double sample_rate)
+{
+    if (engine == nullptr || channels == nullptr || num_channels <= 0 || num_frames <= 0 || sample_rate <= 0.0)
+        return GRANULAR_ERROR_INVALID_ARGUMENT;
+
+    for (int channel = 0; channel < num_channels; ++channel)
+        if (channels[channel] == nullptr)
+            return GRANULAR_ERROR_INVALID_ARGUMENT;
+
+    return guard([&]
+    {
+        SourceBuffer::Ptr source = new SourceBuffer("Samples", num_channels, num_frames, sample_rate);
+
+        for (int channel = 0; channel < num_channels; ++channel)
+            source->writeSamples(channel, 0, channels[channel], num_frames);
+
+        return engine->useSource(std::move(source));
+    });
+}
+
+granular_result granular_engine_set_parameter(granular_engine* engine, granular_parameter parameter, double value)
+{
+    if (engine == nullptr)
+        return GRANULAR_ERROR_INVALID_ARGUMENT;
+
+    return guard([&]
+    {
+        const bool on = value >= 0.5;
+
+        switch (parameter)
+        {
+            case GRANULAR_PARAM_GRAIN_SIZE:         engine->grainSize = juce::jlimit(1, 2048, juce::roundToInt(value)); break;
+            case GRANULAR_PARAM_GRAIN_OVERLAP:      engine->grainOverlap = juce::jlimit(0, 2048, juce::roundToInt(value)); break;
+            case GRANULAR_PARAM_GRAIN_SPACING:      engine->grainSpacing = juce::jlimit(0, 2048, juce::roundToInt(value)); break;
+            case GRANULAR_PARAM_PITCH:              engine->synth.setPitchShift((float)juce::jlimit(-24.0, 24.0, value)); return GRANULAR_OK;
+            case GRANULAR_PARAM_WINDOW:             engine->window = toChoice(value, WindowShape::numShapes); break;
+            case GRANULAR_PARAM_INTERPOLATION:      engine->interpolation = toChoice(value, Interpolation::numInterpolations); break;
+            case GRANULAR_PARAM_REVERSE:            engine->reverse = on; break;
+            case GRANULAR_PARAM_PSOLA:              engine->synth.setPitchSynchronous(on); return GRANULAR_OK;
+            case GRANULAR_PARAM_FILTER_MODE:        engine->filterMode = toChoice(value, GrainFilterMode::numModes); break;
+            case GRANULAR_PARAM_FILTER_CUTOFF:      engine->filterCutoff = (float)juce::jlimit(20.0, 20000.0, value); break;
+            case GRANULAR_PARAM_FILTER_RESONANCE:   engine->filterResonance = (float)juce::jlimit(0.5, 10.0, value); break;
+            case GRANULAR_PARAM_FILTER_SPREAD:      engine->filterSpread = (float)juce::jlimit(0.0, 4.0, value); break;
+            case GRANULAR_PARAM_GRAIN_CACHE:        engine->setGrainCacheEnabled(on); return GRANULAR_OK;
+            case GRANULAR_PARAM_CPU_GOVERNOR:       engine->synth.getGovernor().setEnabled(on); return GRANULAR_OK;
+            case GRANULAR_PARAM_COUNT:
+            default:                                return GRANULAR_ERROR_INVALID_ARGUMENT;
+        }
+
+        engine->applyParameters();
+        return GRANULAR_OK;
+    });
+}
+
+granular_result granular_engine_set_seed(granular_engine* engine, int64_t seed)
+{
+    if (engine == nullptr)
+        return GRANULAR_ERROR_INVALID_ARGUMENT;
+
+    return guard([&]
+    {
+        engine->synth.setRandomSeed((juce::int64)seed);
+        return GRANULAR_OK;
+    });
+}
+
+granular_result granular_engine_note_on(granular_engine* engine, int note, float velocity)
+{
+    if (engine == nullptr || note < 0 || note > 127)
+        return GRANULAR_ERROR_INVALID_ARGUMENT;
+
+    return guard([&]
+    {
+        engine->pendingNotes.addEvent(juce::MidiMessage::noteOn(1, note, juce::jlimit(0.0f, 1.0f, velocity)), 0);
+        return GRANULAR_OK;
+    });
+}
+
+granular_result granular_engine_note_off(granular_engine* engine, int note)
+{
+    if (engine == nullptr || note < 0 || note > 127)
+        return GRANULAR_ERROR_INVALID_ARGUMENT;
+
+    return guard([&]
+    {
+        engine->pendingNotes.addEvent(juce::MidiMessage::noteOff(1, note), 0);
+        return GRANULAR_OK;
+    });
+}
+
+granular_result granular_engine_render(granular_engine* engine, float* const* channels, int num_channels, int num_frames)
+{
+    if (engine == nullptr || channels == nullptr || num_channels != engine->numChannels || num_frames < 0)
+        return GRANULAR_ERROR_INVALID_ARGUMENT;
+
+    for (int channel = 0; channel < num_channels; ++channel)
+        if (channels[channel] == nullptr)
+            return GRANULAR_ERROR_INVALID_ARGUMENT;
+
+    return guard([&]
+    {
+        for (int position = 0; position < num_frames; position += engine->maxBlockSize)
+        {
+            const int blockLength = juce::jmin(engine->maxBlockSize, num_frames - position);
+            juce::AudioBuffer<float> block(channels, num_channels, position, blockLength);
+
+            engine->synth.processBlock(block, engine->pendingNotes);
+            engine->pendingNotes.clear();
+        }
+
+        return GRANULAR_OK;
+    });
+}
+
+const char* granular_result_to_string(granular_result result)
+{
+    switch (result)
+    {
+        case GRANULAR_OK:                       return "OK";
+        case GRANULAR_ERROR_INVALID_ARGUMENT:   return "Invalid argument";
+        case GRANULAR_ERROR_LOAD_FAILED:        return "The audio could not be loaded";
+        case GRANULAR_ERROR_BUSY:               return "Too many changes queued; render and retry";
+        case GRANULAR_ERROR_OUT_OF_MEMORY:      return "Out of memory";
+        case GRANULAR_ERROR_INTERNAL:           return "Internal error";
+        default:                                return "Unknown result";
+    }
+}
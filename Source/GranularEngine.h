@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    GranularEngine.h
+    Created: 19 Oct 2026 1:07:36am
+    Author:  David Matthew Welch
+
+    C interface to the granular engine, built as a shared library by
+    GranularEngine/GranularEngine.jucer. Plain C with no JUCE types, so
+    services can embed the engine without hosting the plugin.
+
+  ==============================================================================
+*/
+
+#ifndef GRANULAR_ENGINE_H
+#define GRANULAR_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+ #if defined(GRANULAR_ENGINE_BUILD)
+  #define GRANULAR_ENGINE_API __declspec(dllexport)
+ #else
+  #define GRANULAR_ENGINE_API __declspec(dllimport)
+ #endif
+#else
+ #define GRANULAR_ENGINE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * An engine instance. Each one is independent, apart from decoded files, which
+ * are shared by every instance in the process that loads the same path.
+ *
+ * Calls on one instance must not overlap; different instances may be used from
+ * different threads at once.
+ */
+typedef struct granular_engine granular_engine;
+
+/** Results returned by the functions below. */
+typedef enum granular_result
+{
+    GRANULAR_OK = 0,
+    GRANULAR_ERROR_INVALID_ARGUMENT = -1,   /* A null pointer, an unknown parameter or a mismatched channel count */
+    GRANULAR_ERROR_LOAD_FAILED = -2,        /* The audio couldn't be read or decoded */
+    GRANULAR_ERROR_BUSY = -3,               /* Too many changes queued since the last render; render and retry */
+    GRANULAR_ERROR_OUT_OF_MEMORY = -4,      /* An allocation failed */
+    GRANULAR_ERROR_INTERNAL = -5            /* The engine failed unexpectedly */
+} granular_result;
+
+/** Parameters for granular_engine_set_parameter(). Values are clamped to the ranges given. */
+typedef enum granular_parameter
+{
+    GRANULAR_PARAM_GRAIN_SIZE = 0,      /* Samples, 1 to 2048; default 512 */
+    GRANULAR_PARAM_GRAIN_OVERLAP,       /* Samples, 0 to 2048; default 256 */
+    GRANULAR_PARAM_GRAIN_SPACING,       /* Samples, 0 to 2048; default 0 */
+    GRANULAR_PARAM_PITCH,               /* Semitones of the continuous grains, -24 to 24; default 0 */
+    GRANULAR_PARAM_WINDOW,              /* 0 Hann, 1 Tukey, 2 triangle, 3 rectangular; default 0 */
+    GRANULAR_PARAM_INTERPOLATION,       /* 0 none, 1 linear, 2 cubic; default 1 */
+    GRANULAR_PARAM_REVERSE,             /* 0 or 1; default 0 */
+    GRANULAR_PARAM_PSOLA,               /* Pitch-synchronous grains once pitch marks are analysed, 0 or 1; default 0 */
+    GRANULAR_PARAM_FILTER_MODE,         /* 0 off, 1 low pass, 2 band pass, 3 high pass; default 0 */
+    GRANULAR_PARAM_FILTER_CUTOFF,       /* Hz, 20 to 20000; default 2000 */
+    GRANULAR_PARAM_FILTER_RESONANCE,    /* Q, 0.5 to 10; default 0.707 */
+    GRANULAR_PARAM_FILTER_SPREAD,       /* Octaves, 0 to 4; default 0 */
+    GRANULAR_PARAM_GRAIN_CACHE,         /* Reuse rendered copies of repeated grains, 0 or 1; default 0; allocated when first on */
+    GRANULAR_PARAM_CPU_GOVERNOR,        /* Thin grains out when rendering falls behind real time, 0 or 1; default 0 */
+    GRANULAR_PARAM_COUNT
+} granular_parameter;
+
+/**
+ * Creates an engine.
+ *
+ * @param sample_rate     The rate to render at.
+ * @param max_block_size  The largest number of frames rendered in one go; longer
+ *                        renders are split into blocks of this size.
+ * @param num_channels    1 or 2.
+ * @return                The engine, or NULL if an argument is out of range.
+ */
+GRANULAR_ENGINE_API granular_engine* granular_engine_create(double sample_rate, int max_block_size, int num_channels);
+
+/** Destroys an engine. Does nothing if engine is NULL. */
+GRANULAR_ENGINE_API void granular_engine_destroy(granular_engine* engine);
+
+/**
+ * Loads an audio file as the source, and waits until it has been decoded. If
+ * it can't be decoded, the previous source carries on playing.
+ *
+ * @param utf8_path  The file's path, UTF-8 encoded.
+ */
+GRANULAR_ENGINE_API granular_result granular_engine_load_file(granular_engine* engine, const char* utf8_path);
+
+/**
+ * Decodes an audio file held in memory (WAV, AIFF, FLAC, ...) as the source.
+ * The data is copied, so the caller may free it once this returns.
+ */
+GRANULAR_ENGINE_API granular_result granular_engine_load_memory(granular_engine* engine, const void* data, size_t num_bytes);
+
+/**
+ * Uses raw audio as the source. The samples are copied.
+ *
+ * @param channels      One pointer per channel to num_frames floats.
+ * @param num_channels  The number of channels.
+ * @param num_frames    The number of samples per channel.
+ * @param sample_rate   The rate the audio was recorded at; grains correct for it.
+ */
+GRANULAR_ENGINE_API granular_result granular_engine_load_samples(granular_engine* engine, const float* const* channels,
+                                                                 int num_channels, int num_frames, double sample_rate);
+
+/** Sets a parameter. Takes effect from the next render. */
+GRANULAR_ENGINE_API granular_result granular_engine_set_parameter(granular_engine* engine, granular_parameter parameter, double value);
+
+/** Reseeds grain placement, so the same calls always render the same audio. */
+GRANULAR_ENGINE_API granular_result granular_engine_set_seed(granular_engine* engine, int64_t seed);
+
+/**
+ * Starts or stops a note at the beginning of the next render. Notes spawn grains
+ * at the note's pitch, with A4 (69) at the original pitch; a note off
+ * stops every grain.
+ */
+GRANULAR_ENGINE_API granular_result granular_engine_note_on(granular_engine* engine, int note, float velocity);
+GRANULAR_ENGINE_API granular_result granular_engine_note_off(granular_engine* engine, int note);
+
+/**
+ * Renders frames into the caller's buffers, replacing their contents.
+ *
+ * @param channels      One pointer per channel to num_frames floats.
+ * @param num_channels  Must match the count the engine was created with.
+ * @param num_frames    Any number; rendered in blocks of at most max_block_size.
+ */
+GRANULAR_ENGINE_API granular_result granular_engine_render(granular_engine* engine, float* const* channels,
+                                                           int num_channels, int num_frames);
+
+/** Returns a short description of a result, e.g. for logging. */
+GRANULAR_ENGINE_API const char* granular_result_to_string(granular_result result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GRANULAR_ENGINE_H */
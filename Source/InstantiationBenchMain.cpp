@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    InstantiationBenchMain.cpp
+    Created: 18 Oct 2026 11:59:47pm
+    Author:  David Matthew Welch
+
+    Entry point of the InstantiationBench console app
+    (InstantiationBench/InstantiationBench.jucer). Measures how long it takes
+    to construct and prepare many engines, as a large session does when it
+    opens.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "GranSynth.h"
+
+namespace
+{
+    double millisecondsSince(double start)
+    {
+        return juce::Time::getMillisecondCounterHiRes() - start;
+    }
+
+    void report(const char* stage, double milliseconds, int count)
+    {
+        std::cout << stage << ": " << juce::String(milliseconds, 2).toRawUTF8() << " ms";
+
+        if (count > 1)
+            std::cout << " (" << juce::String(milliseconds / count, 3).toRawUTF8() << " ms each)";
+
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int numInstances = argc > 1 ? juce::jmax(1, juce::String(argv[1]).getIntValue()) : 100;
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    std::vector<std::unique_ptr<GranSynth>> engines;
+    engines.reserve((size_t)numInstances);
+
+    // The first instance also pays for anything shared across the process
+    double start = juce::Time::getMillisecondCounterHiRes();
+    engines.push_back(std::make_unique<GranSynth>());
+    engines.front()->prepareToPlay(sampleRate, blockSize);
+    report("First instance, construct and prepare", millisecondsSince(start), 1);
+
+    start = juce::Time::getMillisecondCounterHiRes();
+
+    for (int i = 1; i < numInstances; ++i)
+        engines.push_back(std::make_unique<GranSynth>());
+
+    const double constructTime = millisecondsSince(start);
+
+    start = juce::Time::getMillisecondCounterHiRes();
+
+    for (size_t i = 1; i < engines.size(); ++i)
+        engines[i]->prepareToPlay(sampleRate, blockSize);
+
+    const double prepareTime = millisecondsSince(start);
+
+    if (numInstances > 1)
+    {
+        report("Construct remaining", constructTime, numInstances - 1);
+        report("Prepare remaining", prepareTime, numInstances - 1);
+    }
+
+    // Only instances that turn the grain cache on pay for its slots and fill thread
+    start = juce::Time::getMillisecondCounterHiRes();
+    engines.front()->setGrainCacheEnabled(true);
+    engines.front()->prepareGrainCache();
+    report("Turn the grain cache on in one instance", millisecondsSince(start), 1);
+
+    start = juce::Time::getMillisecondCounterHiRes();
+    engines.clear();
+    report("Destroy all", millisecondsSince(start), numInstances);
+
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+  ==============================================================================
+
+    KernelBenchMain.cpp
+    Created: 18 Oct 2026 1:40:12pm
+    Author:  David Matthew Welch
+
+    Entry point of the KernelBench console app (KernelBench/KernelBench.jucer).
+    Times the specialised grain kernels against a single generic loop that
+    branches on every choice per sample, for each window and interpolation,
+    and checks that both render the same audio.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include <iomanip>
+#include "GrainKernels.h"
+
+namespace
+{
+    constexpr int tableSize = 1024;     // Matches the kernels' window tables
+
+    /** The Hann and Tukey tables, built the same way as the kernels' own. */
+    struct GenericTables
+    {
+        std::array<float, tableSize + 1> hann {};
+        std::array<float, tableSize + 1> tukey {};
+
+        GenericTables()
+        {
+            for (int i = 0; i <= tableSize; ++i)
+            {
+                const float phase = static_cast<float>(i) / tableSize;
+                const float edge = juce::jmin(phase, 1.0f - phase);
+
+                hann[(size_t)i] = 0.5f * (1.0f - std::cos(juce::MathConstants<float>::twoPi * phase));
+                tukey[(size_t)i] = edge >= 0.25f ? 1.0f
+                                                 : 0.5f * (1.0f - std::cos(juce::MathConstants<float>::pi * edge / 0.25f));
+            }
+        }
+
+        static float lookup(const std::array<float, tableSize + 1>& table, float phase)
+        {
+            const float position = juce::jlimit(0.0f, 1.0f, phase) * tableSize;
+            const int index = juce::jmin(static_cast<int>(position), tableSize - 1);
+            const float fraction = position - index;
+            return table[(size_t)index] + fraction * (table[(size_t)index + 1] - table[(size_t)index]);
+        }
+    };
+
+    float windowGain(const GenericTables& tables, WindowShape window, float phase)
+    {
+        switch (window)
+        {
+            case WindowShape::hann:         return GenericTables::lookup(tables.hann, phase);
+            case WindowShape::tukey:        return GenericTables::lookup(tables.tukey, phase);
+            case WindowShape::triangle:     return juce::jmax(0.0f, 1.0f - std::abs(2.0f * phase - 1.0f));
+            case WindowShape::rectangular:
+            case WindowShape::numShapes:    break;
+        }
+
+        return 1.0f;
+    }
+
+    float readSample(const float* data, int numSamples, double position, Interpolation interpolation)
+    {
+        const int index = static_cast<int>(position);
+        const float fraction = static_cast<float>(position - index);
+        const auto tap = [data, numSamples, index](int offset)
+        {
+            const int wrapped = (index + offset) % numSamples;
+            return data[wrapped < 0 ? wrapped + numSamples : wrapped];
+        };
+
+        switch (interpolation)
+        {
+            case Interpolation::none:
+                return tap(0);
+
+            case Interpolation::linear:
+                return tap(0) + fraction * (tap(1) - tap(0));
+
+            case Interpolation::cubic:
+            case Interpolation::numInterpolations:
+                break;
+        }
+
+        const float xm1 = tap(-1), x0 = tap(0), x1 = tap(1), x2 = tap(2);
+        const float c1 = 0.5f * (x1 - xm1);
+        const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+        const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+        return ((c3 * fraction + c2) * fraction + c1) * fraction + x0;
+    }
+
+    /**
+     * The loop the kernels replace: every sample branches on the window, the
+     * interpolation and the channel count, and wraps every tap.
+     */
+    void renderGeneric(const GenericTables& tables, const GrainRenderSettings& settings, GrainRenderState& state,
+                       const GrainSource& source, float* const* outputs, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float gain = windowGain(tables, settings.window, state.windowPhase);
+
+            for (int channel = 0; channel < settings.numChannels; ++channel)
+                outputs[channel][i] += gain * readSample(source.channels[channel % source.numChannels], source.numSamples,
+                                                         state.readPosition, settings.interpolation);
+
+            state.readPosition = std::fmod(state.readPosition + state.readIncrement, (double)source.numSamples);
+
+            if (state.readPosition < 0.0)
+                state.readPosition += source.numSamples;
+
+            state.windowPhase += state.windowIncrement;
+        }
+    }
+
+    const char* getName(WindowShape window)
+    {
+        static const char* const names[] = { "hann", "tukey", "triangle", "rectangular" };
+        return names[static_cast<int>(window)];
+    }
+
+    const char* getName(Interpolation interpolation)
+    {
+        static const char* const names[] = { "none", "linear", "cubic" };
+        return names[static_cast<int>(interpolation)];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int numGrains = argc > 1 ? juce::jmax(1, juce::String(argv[1]).getIntValue()) : 2000;
+    constexpr int grainLength = 2048;
+    constexpr int numChannels = 2;
+    constexpr int sourceLength = 1 << 16;
+    constexpr double readIncrement = 1.37;     // Pitched up, so every interpolator does real work
+    constexpr float tolerance = 1.0e-4f;
+
+    juce::Random random(42);
+    juce::AudioBuffer<float> sourceAudio(numChannels, sourceLength);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int i = 0; i < sourceLength; ++i)
+            sourceAudio.setSample(channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+    GrainSource source;
+    source.channels = sourceAudio.getArrayOfReadPointers();
+    source.numChannels = numChannels;
+    source.numSamples = sourceLength;
+
+    // Some grains start near the end, so the wrapped steps are timed as well
+    std::vector<double> startPositions((size_t)numGrains);
+
+    for (auto& position : startPositions)
+        position = random.nextDouble() * sourceLength;
+
+    const GenericTables tables;
+
+    juce::AudioBuffer<float> kernelOutput(numChannels, grainLength);
+    juce::AudioBuffer<float> genericOutput(numChannels, grainLength);
+    bool allMatch = true;
+
+    std::cout << std::left << std::setw(13) << "window" << std::setw(8) << "interp"
+              << std::right << std::setw(14) << "kernel ns/smp" << std::setw(15) << "generic ns/smp"
+              << std::setw(9) << "speedup" << std::setw(12) << "max diff" << std::endl;
+
+    for (int windowIndex = 0; windowIndex < (int)WindowShape::numShapes; ++windowIndex)
+    {
+        for (int interpolationIndex = 0; interpolationIndex < (int)Interpolation::numInterpolations; ++interpolationIndex)
+        {
+            GrainRenderSettings settings;
+            settings.window = static_cast<WindowShape>(windowIndex);
+            settings.interpolation = static_cast<Interpolation>(interpolationIndex);
+            settings.numChannels = numChannels;
+
+            const auto kernel = GrainKernels::select<float>(settings);
+            const auto makeState = [](double position)
+            {
+                GrainRenderState state;
+                state.readPosition = position;
+                state.readIncrement = readIncrement;
+                state.windowIncrement = 1.0f / grainLength;
+                return state;
+            };
+
+            // The same grain through both paths must sound the same
+            kernelOutput.clear();
+            genericOutput.clear();
+
+            auto kernelState = makeState(startPositions.front());
+            auto genericState = makeState(startPositions.front());
+            kernel(kernelState, source, kernelOutput.getArrayOfWritePointers(), grainLength);
+            renderGeneric(tables, settings, genericState, source, genericOutput.getArrayOfWritePointers(), grainLength);
+
+            float maxDifference = 0.0f;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < grainLength; ++i)
+                    maxDifference = juce::jmax(maxDifference, std::abs(kernelOutput.getSample(channel, i)
+                                                                       - genericOutput.getSample(channel, i)));
+
+            allMatch = allMatch && maxDifference <= tolerance;
+
+            // Both paths clear their output per grain, so only the rendering differs
+            double start = juce::Time::getMillisecondCounterHiRes();
+
+            for (const double position : startPositions)
+            {
+                auto state = makeState(position);
+                kernelOutput.clear();
+                kernel(state, source, kernelOutput.getArrayOfWritePointers(), grainLength);
+            }
+
+            const double kernelMs = juce::Time::getMillisecondCounterHiRes() - start;
+            start = juce::Time::getMillisecondCounterHiRes();
+
+            for (const double position : startPositions)
+            {
+                auto state = makeState(position);
+                genericOutput.clear();
+                renderGeneric(tables, settings, state, source, genericOutput.getArrayOfWritePointers(), grainLength);
+            }
+
+            const double genericMs = juce::Time::getMillisecondCounterHiRes() - start;
+            const double samplesRendered = (double)numGrains * grainLength;
+
+            std::cout << std::left << std::setw(13) << getName(settings.window) << std::setw(8) << getName(settings.interpolation)
+                      << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(14) << kernelMs * 1.0e6 / samplesRendered
+                      << std::setw(15) << genericMs * 1.0e6 / samplesRendered
+                      << std::setprecision(2) << std::setw(8) << genericMs / juce::jmax(1.0e-9, kernelMs) << "x"
+                      << std::scientific << std::setprecision(1) << std::setw(12) << maxDifference
+                      << std::defaultfloat << std::endl;
+        }
+    }
+
+    if (!allMatch)
+        std::cerr << "The kernels and the generic loop rendered different audio" << std::endl;
+
+    return allMatch ? 0 : 1;
+}
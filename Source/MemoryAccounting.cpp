@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    MemoryAccounting.cpp
+    Created: 18 Oct 2026 11:59:58pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "MemoryAccounting.h"
+
+//==============================================================================
+juce::int64 MemoryAccounting::Usage::getTotal() const
+{
+    juce::int64 total = 0;
+
+    for (auto categoryBytes : bytes)
+        total += categoryBytes;
+
+    return total;
+}
+
+MemoryAccounting::Usage& MemoryAccounting::Usage::operator+=(const Usage& other)
+{
+    for (size_t i = 0; i < bytes.size(); ++i)
+        bytes[i] += other.bytes[i];
+
+    return *this;
+}
+
+juce::String MemoryAccounting::Usage::toString() const
+{
+    return juce::File::descriptionOfSizeInBytes(getTotal())
+         + " (sources " + juce::File::descriptionOfSizeInBytes((*this)[Category::sources])
+         + ", buffers " + juce::File::descriptionOfSizeInBytes((*this)[Category::buffers])
+         + ", analysis " + juce::File::descriptionOfSizeInBytes((*this)[Category::analysis])
+         + ", caches " + juce::File::descriptionOfSizeInBytes((*this)[Category::caches]) + ")";
+}
+
+//==============================================================================
+MemoryAccounting::MemoryAccounting()
+{
+    startTimer(1000);
+}
+
+MemoryAccounting::~MemoryAccounting()
+{
+    stopTimer();
+}
+
+void MemoryAccounting::addClient(Client* client)
+{
+    clients.addIfNotAlreadyThere(client);
+}
+
+void MemoryAccounting::removeClient(Client* client)
+{
+    clients.removeFirstMatchingValue(client);
+}
+
+MemoryAccounting::Usage MemoryAccounting::getProcessUsage() const
+{
+    Usage usage;
+    usage[Category::sources] = samplePool->getTotalBytes();
+    usage[Category::analysis] = samplePool->getAnalysisBytes();
+
+    for (auto* client : clients)
+        usage += client->getMemoryUsage(false);
+
+    return usage;
+}
+
+juce::int64 MemoryAccounting::getBudget() const
+{
+    juce::int64 budget = 0;
+
+    for (auto* client : clients)
+    {
+        const juce::int64 clientBudget = client->getMemoryBudget();
+
+        if (clientBudget > 0 && (budget == 0 || clientBudget < budget))
+            budget = clientBudget;
+    }
+
+    return budget;
+}
+
+juce::int64 MemoryAccounting::enforceBudget()
+{
+    const juce::int64 budget = getBudget();
+
+    if (budget <= 0)
+        return 0;
+
+    juce::int64 excess = getProcessUsage().getTotal() - budget;
+    juce::int64 freed = 0;
+
+    for (int eviction = 0; eviction < (int)Eviction::numEvictions && excess > 0; ++eviction)
+    {
+        for (auto* client : clients)
+        {
+            const juce::int64 clientFreed = client->evict(static_cast<Eviction>(eviction));
+            freed += clientFreed;
+            excess -= clientFreed;
+
+            if (excess <= 0)
+                break;
+        }
+    }
+
+    if (freed > 0)
+        DBG("Memory budget: freed " << juce::File::descriptionOfSizeInBytes(freed));
+
+    return freed;
+}
+
+void MemoryAccounting::timerCallback()
+{
+    for (auto* client : clients)
+        client->finishEvictions();
+
+    enforceBudget();
+}
@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    MemoryAccounting.h
+    Created: 18 Oct 2026 11:59:58pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SamplePool.h"
+
+/**
+ * Process-wide accounting of the memory held by every instance, and a budget
+ * that evicts memory when it is exceeded.
+ *
+ * Each instance registers as a Client that reports what it holds by category
+ * and knows how to give some of it back. The sample pool's sources and their
+ * pitch marks are shared, so the process total counts them once from the pool
+ * rather than from every instance using them.
+ *
+ * When the process total is over budget, evictions run in priority order
+ * across every client until it fits: first the rendered grain caches, then the
+ * finer levels of the waveform summaries, then sources that were upsampled to
+ * the engine rate, which are swapped for copies at the file's own rate. The
+ * budget is checked every second, and whenever a client asks.
+ *
+ * Access it through juce::SharedResourcePointer<MemoryAccounting>. Everything
+ * here runs on the message thread.
+ */
+class MemoryAccounting : private juce::Timer
+{
+public:
+    /** What the memory is used for. */
+    enum class Category
+    {
+        sources = 0,    // Decoded audio
+        buffers,        // Grain state, live capture, recording and trace rings
+        analysis,       // Waveform summaries and pitch marks
+        caches,         // Rendered grains
+        numCategories
+    };
+
+    /** Ways of giving memory back, in the order they are tried. */
+    enum class Eviction
+    {
+        grainCaches = 0,
+        peakLevels,
+        rateConvertedSources,
+        numEvictions
+    };
+
+    /** Bytes held in each category. */
+    struct Usage
+    {
+        std::array<juce::int64, (size_t)Category::numCategories> bytes {};
+
+        juce::int64& operator[](Category category)       { return bytes[(size_t)category]; }
+        juce::int64 operator[](Category category) const  { return bytes[(size_t)category]; }
+
+        juce::int64 getTotal() const;
+        Usage& operator+=(const Usage& other);
+
+        /** A one-line breakdown for display. */
+        juce::String toString() const;
+    };
+
+    /** Something that holds memory, usually a plugin instance. */
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        /**
+         * Returns what the client holds.
+         *
+         * @param includePooled  Include sources, and their pitch marks, shared through the sample pool.
+         */
+        virtual Usage getMemoryUsage(bool includePooled) const = 0;
+
+        /**
+         * Gives back as much memory as one kind of eviction can.
+         *
+         * @return  The bytes freed, or about to be.
+         */
+        virtual juce::int64 evict(Eviction eviction) = 0;
+
+        /** Returns the budget this client asks for, or 0 for none. */
+        virtual juce::int64 getMemoryBudget() const = 0;
+
+        /**
+         * Frees anything evicted earlier that had to wait, e.g. for the audio
+         * thread to stop using it. Called every second.
+         */
+        virtual void finishEvictions() {}
+    };
+
+    MemoryAccounting();
+    ~MemoryAccounting() override;
+
+    void addClient(Client* client);
+    void removeClient(Client* client);
+
+    /**
+     * Returns the memory held across the process, counting shared sources once.
+     */
+    Usage getProcessUsage() const;
+
+    /**
+     * Returns the budget in force: the smallest any client asks for, or 0 for none.
+     */
+    juce::int64 getBudget() const;
+
+    /**
+     * Evicts memory in priority order until the process fits the budget.
+     *
+     * @return  The number of bytes freed.
+     */
+    juce::int64 enforceBudget();
+
+private:
+    juce::SharedResourcePointer<SamplePool> samplePool;
+    juce::Array<Client*> clients;
+
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MemoryAccounting)
+};
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    ObjectReleaseQueue.cpp
+    Created: 18 Oct 2026 7:24:51pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "ObjectReleaseQueue.h"
+
+ObjectReleaseQueue::ObjectReleaseQueue(std::function<void()> onReleased)
+    : juce::Thread("Object release"), releasedCallback(std::move(onReleased))
+{
+}
+
+ObjectReleaseQueue::~ObjectReleaseQueue()
+{
+    stopThread(1000);
+    releasePending();
+}
+
+void ObjectReleaseQueue::start()
+{
+    if (!isThreadRunning())
+        startThread(juce::Thread::Priority::background);
+}
+
+void ObjectReleaseQueue::run()
+{
+    while (!threadShouldExit())
+    {
+        releasePending();
+        wait(50);
+    }
+}
+
+void ObjectReleaseQueue::releasePending()
+{
+    const int numReady = fifo.getNumReady();
+
+    if (numReady == 0)
+        return;
+
+    {
+        const auto scope = fifo.read(numReady);
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            objects[(size_t)(scope.startIndex1 + i)] = nullptr;
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            objects[(size_t)(scope.startIndex2 + i)] = nullptr;
+    }
+
+    if (releasedCallback)
+        releasedCallback();
+}
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    ObjectReleaseQueue.h
+    Created: 18 Oct 2026 7:24:51pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Hands reference-counted objects from the audio thread to a background thread,
+ * which drops the references. The audio thread can then retire a source it was
+ * playing without ever being the one to free it.
+ *
+ * push() and hasSpace() are called from the audio thread only.
+ */
+class ObjectReleaseQueue : private juce::Thread
+{
+public:
+    using ObjectPtr = juce::ReferenceCountedObjectPtr<juce::ReferenceCountedObject>;
+
+    static constexpr int capacity = 32;
+
+    /**
+     * Constructor for the ObjectReleaseQueue class. The release thread isn't
+     * started until start() is called.
+     *
+     * @param onReleased  Called on the release thread after each batch of objects
+     *                    has been dropped, e.g. to let a pool free its copies.
+     */
+    explicit ObjectReleaseQueue(std::function<void()> onReleased = {});
+
+    /**
+     * Destructor for the ObjectReleaseQueue class. Stops the thread and drops
+     * anything still queued.
+     */
+    ~ObjectReleaseQueue() override;
+
+    /**
+     * Starts the release thread, if it isn't running yet. Call before the audio
+     * thread first pushes anything; until then pushed objects just wait.
+     */
+    void start();
+
+    /**
+     * Returns true if another object can be pushed.
+     */
+    bool hasSpace() const noexcept { return fifo.getFreeSpace() > 0; }
+
+    /**
+     * Queues an object for release, taking over the caller's reference. If the
+     * queue is full the object is left with the caller.
+     *
+     * @param object  The reference to hand over; null on success.
+     * @return        False if the queue was full.
+     */
+    template <typename ObjectType>
+    bool push(juce::ReferenceCountedObjectPtr<ObjectType>& object) noexcept
+    {
+        if (object == nullptr)
+            return true;
+
+        const auto scope = fifo.write(1);
+        ObjectPtr* slot = nullptr;
+
+        if (scope.blockSize1 > 0)
+            slot = &objects[(size_t)scope.startIndex1];
+        else if (scope.blockSize2 > 0)
+            slot = &objects[(size_t)scope.startIndex2];
+        else
+            return false;
+
+        // The slot takes its reference before the caller's is dropped, so the count
+        // can't reach zero here
+        *slot = ObjectPtr(object.get());
+        object = nullptr;
+        return true;
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<ObjectPtr, capacity> objects;
+    std::function<void()> releasedCallback;
+
+    void run() override;
+    void releasePending();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ObjectReleaseQueue)
+};
@@ -0,0 +1,200 @@
+/*
+  ==============================================================================
+
+    OutputRecorder.cpp
+    Created: 18 Oct 2026 11:20:44pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "OutputRecorder.h"
+
+namespace
+{
+    template <typename SampleType>
+    void copyToFloat(const SampleType* source, float* destination, int numSamples) noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            juce::FloatVectorOperations::copy(destination, source, numSamples);
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = static_cast<float>(source[i]);
+        }
+    }
+}
+
+//==============================================================================
+OutputRecorder::OutputRecorder()
+    : juce::Thread("Output recorder")
+{
+}
+
+OutputRecorder::~OutputRecorder()
+{
+    stop();
+}
+
+void OutputRecorder::prepare(double sampleRate, int numChannels)
+{
+    stop();
+
+    currentSampleRate = sampleRate;
+    currentNumChannels = numChannels;
+}
+
+bool OutputRecorder::start(const juce::File& file, bool keepAsSource)
+{
+    stop();
+
+    if (currentSampleRate <= 0.0 || currentNumChannels <= 0)
+        return false;
+
+    // Most instances never record, so the ring is only allocated when one starts
+    const int capacity = (int)std::ceil(currentSampleRate * ringSeconds);
+
+    if (ring.getNumChannels() != currentNumChannels || ring.getNumSamples() != capacity)
+    {
+        ring.setSize(currentNumChannels, capacity);
+        fifo.setTotalSize(capacity);
+    }
+
+    file.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+
+    if (stream == nullptr)
+        return false;
+
+    juce::WavAudioFormat wavFormat;
+    writer.reset(wavFormat.createWriterFor(stream.get(), currentSampleRate, (unsigned int)ring.getNumChannels(), 32, {}, 0));
+
+    if (writer == nullptr)
+        return false;
+
+    // The writer owns the stream from here on
+    stream.release();
+
+    // Discard anything pushed after the last stop()
+    fifo.read(fifo.getNumReady());
+
+    currentFile = file;
+    keepingSource = keepAsSource;
+    kept.setSize(keepAsSource ? ring.getNumChannels() : 0, 0);
+    maxKeptSamples = (juce::int64)(maxKeptSeconds * currentSampleRate);
+    recorded = 0;
+    dropped = 0;
+
+    recording = true;
+    startThread(juce::Thread::Priority::normal);
+    return true;
+}
+
+SourceBuffer::Ptr OutputRecorder::stop()
+{
+    if (writer == nullptr)
+        return nullptr;
+
+    recording = false;
+    stopThread(1000);
+    writePending();
+
+    writer.reset();
+
+    if (dropped.load() > 0)
+        DBG("Output recorder dropped " << dropped.load() << " samples");
+
+    if (!keepingSource || recorded.load() == 0)
+        return nullptr;
+
+    if (recorded.load() > maxKeptSamples)
+        DBG("Output recorder kept only the first " << maxKeptSeconds << " seconds as a source");
+
+    const int numSamples = (int)juce::jmin(recorded.load(), (juce::int64)kept.getNumSamples());
+    SourceBuffer::Ptr source = new SourceBuffer(currentFile.getFileName(), kept.getNumChannels(), numSamples, currentSampleRate);
+
+    for (int channel = 0; channel < kept.getNumChannels(); ++channel)
+        source->writeSamples(channel, 0, kept.getReadPointer(channel), numSamples);
+
+    kept.setSize(0, 0);
+    return source;
+}
+
+template <typename SampleType>
+void OutputRecorder::push(const juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    if (!isRecording() || buffer.getNumChannels() == 0)
+        return;
+
+    const int numSamples = buffer.getNumSamples();
+    const auto scope = fifo.write(numSamples);
+
+    for (int channel = 0; channel < ring.getNumChannels(); ++channel)
+    {
+        const SampleType* source = buffer.getReadPointer(juce::jmin(channel, buffer.getNumChannels() - 1));
+
+        if (scope.blockSize1 > 0)
+            copyToFloat(source, ring.getWritePointer(channel, scope.startIndex1), scope.blockSize1);
+
+        if (scope.blockSize2 > 0)
+            copyToFloat(source + scope.blockSize1, ring.getWritePointer(channel, scope.startIndex2), scope.blockSize2);
+    }
+
+    const int numWritten = scope.blockSize1 + scope.blockSize2;
+
+    if (numWritten < numSamples)
+        dropped.fetch_add(numSamples - numWritten);
+}
+
+void OutputRecorder::run()
+{
+    while (!threadShouldExit())
+    {
+        writePending();
+        wait(10);
+    }
+}
+
+void OutputRecorder::writePending()
+{
+    const int numReady = fifo.getNumReady();
+
+    if (numReady == 0)
+        return;
+
+    const auto scope = fifo.read(numReady);
+    const int numChannels = ring.getNumChannels();
+
+    const auto writeBlock = [this, numChannels](int start, int length)
+    {
+        if (length <= 0)
+            return;
+
+        writer->writeFromAudioSampleBuffer(ring, start, length);
+
+        // Past the cap the rest of the recording only goes to the file
+        const juce::int64 keptSamples = recorded.load();
+        const int keepLength = keepingSource ? (int)juce::jlimit((juce::int64)0, (juce::int64)length, maxKeptSamples - keptSamples) : 0;
+
+        if (keepLength > 0)
+        {
+            // Grow geometrically so a long recording isn't copied on every block
+            if (keptSamples + keepLength > kept.getNumSamples())
+                kept.setSize(numChannels, (int)juce::jmin(maxKeptSamples, juce::jmax(keptSamples + keepLength, (juce::int64)kept.getNumSamples() * 2)),
+                             true, false, true);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                kept.copyFrom(channel, (int)keptSamples, ring, channel, start, keepLength);
+        }
+
+        recorded += length;
+    };
+
+    writeBlock(scope.startIndex1, scope.blockSize1);
+    writeBlock(scope.startIndex2, scope.blockSize2);
+}
+
+template void OutputRecorder::push<float>(const juce::AudioBuffer<float>&) noexcept;
+template void OutputRecorder::push<double>(const juce::AudioBuffer<double>&) noexcept;
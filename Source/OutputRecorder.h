@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    OutputRecorder.h
+    Created: 18 Oct 2026 11:20:44pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SourceBuffer.h"
+
+/**
+ * Records the plugin's output to a WAV file, and optionally keeps the recording
+ * so it can be granulated as a new source.
+ *
+ * The audio thread only copies each block into a preallocated ring; a
+ * background thread drains the ring to a 32-bit float WAV file, so the audio
+ * thread never touches the file system. The ring holds several seconds, which
+ * keeps sustained recording lossless at 96 kHz stereo even when the disk
+ * stalls briefly. If the writer does fall that far behind, samples are dropped
+ * and counted rather than blocking.
+ *
+ * Thread ownership: push() is for the audio thread only; prepare(), start()
+ * and stop() are for the message thread.
+ */
+class OutputRecorder : private juce::Thread
+{
+public:
+    static constexpr double ringSeconds = 4.0;  // Audio held before the writer must catch up
+    static constexpr double maxKeptSeconds = 300.0;     // Longest recording kept as a source; the file goes on
+
+    /**
+     * Constructor for the OutputRecorder class.
+     */
+    OutputRecorder();
+
+    /**
+     * Destructor for the OutputRecorder class. Stops any recording in progress.
+     */
+    ~OutputRecorder() override;
+
+    /**
+     * Sets the sample rate and channel count to record at. Stops any recording
+     * in progress, discarding its source. Call before playback. The ring itself
+     * is allocated by the first start() at these settings.
+     */
+    void prepare(double sampleRate, int numChannels);
+
+    /**
+     * Starts recording to a file, replacing it if it exists.
+     *
+     * @param file          The WAV file to write.
+     * @param keepAsSource  Also keep the recording in memory, for stop() to return as a source.
+     *                      Only the first maxKeptSeconds are kept, so a recording left
+     *                      running can't use up memory.
+     * @return              False if the file could not be opened or prepare() hasn't been called.
+     *                      Allocates the ring the first time, so call it from the message thread.
+     */
+    bool start(const juce::File& file, bool keepAsSource);
+
+    /**
+     * Stops recording, writes out everything still in the ring and closes the file.
+     *
+     * @return  The recording as a source if start() was asked to keep it and
+     *          anything was recorded, otherwise nullptr.
+     */
+    SourceBuffer::Ptr stop();
+
+    bool isRecording() const noexcept { return recording.load(std::memory_order_relaxed); }
+
+    /**
+     * Copies a block of output into the ring. Does nothing unless recording.
+     */
+    template <typename SampleType>
+    void push(const juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+    /**
+     * Returns the number of samples per channel written so far in this recording.
+     */
+    juce::int64 getNumRecorded() const noexcept { return recorded.load(); }
+
+    /**
+     * Returns the number of samples per channel dropped because the ring was full.
+     */
+    juce::int64 getNumDropped() const noexcept { return dropped.load(); }
+
+    double getSampleRate() const noexcept { return currentSampleRate; }
+
+    /**
+     * Returns the memory held for the ring and any recording kept as a source.
+     * Message thread only.
+     */
+    juce::int64 getSizeInBytes() const
+    {
+        return ((juce::int64)ring.getNumChannels() * ring.getNumSamples()
+              + (juce::int64)kept.getNumChannels() * kept.getNumSamples()) * (juce::int64)sizeof(float);
+    }
+
+private:
+    std::atomic<bool> recording { false };
+    std::atomic<juce::int64> recorded { 0 };
+    std::atomic<juce::int64> dropped { 0 };
+    juce::AbstractFifo fifo { 1 };
+    juce::AudioBuffer<float> ring;
+
+    double currentSampleRate = 0.0;
+    int currentNumChannels = 0;
+    juce::File currentFile;
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    bool keepingSource = false;
+    juce::AudioBuffer<float> kept;      // The recording so far, when keeping it as a source
+    juce::int64 maxKeptSamples = 0;     // maxKeptSeconds at the current sample rate
+
+    void run() override;
+    void writePending();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OutputRecorder)
+};
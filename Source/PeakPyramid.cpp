@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    PeakPyramid.cpp
+    Created: 18 Oct 2026 9:20:41am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "PeakPyramid.h"
+
+PeakPyramid::PeakPyramid(const juce::AudioBuffer<float>& source)
+    : PeakPyramid(source.getNumChannels(), source.getNumSamples(),
+                  [&source](int channel, int startSample, float* destination, int numSamples)
+                  {
+                      juce::FloatVectorOperations::copy(destination, source.getReadPointer(channel, startSample), numSamples);
+                  })
+{
+}
+
+PeakPyramid::PeakPyramid(int numChannels, int numSamples, const SampleReader& readSamples)
+    : numSourceSamples(numSamples)
+{
+    static_assert(readBlockSize % baseSamplesPerBucket == 0, "Blocks must hold whole buckets");
+
+    const int numBuckets = (numSourceSamples + baseSamplesPerBucket - 1) / baseSamplesPerBucket;
+
+    if (numChannels <= 0 || numBuckets == 0)
+        return;
+
+    // Build the finest level from the audio, a block of each channel at a time
+    Level base;
+    base.samplesPerBucket = baseSamplesPerBucket;
+    base.minimums.resize((size_t)numBuckets);
+    base.maximums.resize((size_t)numBuckets);
+
+    std::array<float, readBlockSize> block;
+
+    for (int blockStart = 0; blockStart < numSourceSamples; blockStart += readBlockSize)
+    {
+        const int blockLength = juce::jmin(readBlockSize, numSourceSamples - blockStart);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            readSamples(channel, blockStart, block.data(), blockLength);
+
+            for (int offset = 0; offset < blockLength; offset += baseSamplesPerBucket)
+            {
+                const auto bucket = (size_t)((blockStart + offset) / baseSamplesPerBucket);
+                const auto range = juce::FloatVectorOperations::findMinAndMax(block.data() + offset,
+                                                                              juce::jmin(baseSamplesPerBucket, blockLength - offset));
+
+                base.minimums[bucket] = channel == 0 ? range.getStart() : juce::jmin(base.minimums[bucket], range.getStart());
+                base.maximums[bucket] = channel == 0 ? range.getEnd() : juce::jmax(base.maximums[bucket], range.getEnd());
+            }
+        }
+    }
+
+    levels.push_back(std::move(base));
+    buildCoarserLevels();
+}
+
+void PeakPyramid::buildCoarserLevels()
+{
+    // Each coarser level merges pairs of buckets from the level below it
+    while (levels.back().minimums.size() > 1)
+    {
+        const auto& finer = levels.back();
+        const size_t finerSize = finer.minimums.size();
+
+        Level coarser;
+        coarser.samplesPerBucket = finer.samplesPerBucket * 2;
+        coarser.minimums.resize((finerSize + 1) / 2);
+        coarser.maximums.resize((finerSize + 1) / 2);
+
+        for (size_t i = 0; i < coarser.minimums.size(); ++i)
+        {
+            const size_t a = i * 2;
+            const size_t b = juce::jmin(a + 1, finerSize - 1);
+
+            coarser.minimums[i] = juce::jmin(finer.minimums[a], finer.minimums[b]);
+            coarser.maximums[i] = juce::jmax(finer.maximums[a], finer.maximums[b]);
+        }
+
+        levels.push_back(std::move(coarser));
+    }
+}
+
+juce::Range<float> PeakPyramid::getPeakRange(double startSample, double endSample) const
+{
+    startSample = juce::jmax(0.0, startSample);
+    endSample = juce::jmin((double)numSourceSamples, endSample);
+
+    if (levels.empty() || endSample <= startSample)
+        return {};
+
+    // Pick the coarsest level whose buckets are no wider than the span, so at most
+    // a handful of buckets need to be scanned regardless of zoom
+    const double span = endSample - startSample;
+    size_t levelIndex = 0;
+
+    while (levelIndex + 1 < levels.size() && levels[levelIndex + 1].samplesPerBucket <= span)
+        ++levelIndex;
+
+    const auto& level = levels[levelIndex];
+    const int lastBucket = (int)level.minimums.size() - 1;
+    const int firstIndex = juce::jlimit(0, lastBucket, (int)(startSample / level.samplesPerBucket));
+    const int lastIndex = juce::jlimit(firstIndex, lastBucket, (int)((endSample - 1.0) / level.samplesPerBucket));
+
+    float minimum = level.minimums[(size_t)firstIndex];
+    float maximum = level.maximums[(size_t)firstIndex];
+
+    for (int i = firstIndex + 1; i <= lastIndex; ++i)
+    {
+        minimum = juce::jmin(minimum, level.minimums[(size_t)i]);
+        maximum = juce::jmax(maximum, level.maximums[(size_t)i]);
+    }
+
+    return { minimum, maximum };
+}
+
+PeakPyramid::Ptr PeakPyramid::withoutLevelsFinerThan(int samplesPerBucket) const
+{
+    if (levels.size() < 2 || levels.front().samplesPerBucket >= samplesPerBucket)
+        return const_cast<PeakPyramid*>(this);
+
+    Ptr coarser = new PeakPyramid();
+    coarser->numSourceSamples = numSourceSamples;
+
+    // Always keep the coarsest level, whatever its resolution
+    for (size_t i = 0; i < levels.size(); ++i)
+        if (levels[i].samplesPerBucket >= samplesPerBucket || i + 1 == levels.size())
+            coarser->levels.push_back(levels[i]);
+
+    return coarser;
+}
+
+juce::int64 PeakPyramid::getSizeInBytes() const
+{
+    juce::int64 total = 0;
+
+    for (const auto& level : levels)
+        total += (juce::int64)(level.minimums.size() + level.maximums.size()) * (juce::int64)sizeof(float);
+
+    return total;
+}
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    PeakPyramid.h
+    Created: 18 Oct 2026 9:20:41am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * A multi-resolution min/max summary of an audio buffer.
+ *
+ * Level 0 holds one min/max pair per baseSamplesPerBucket samples (taken across
+ * all channels), and every following level halves the resolution of the one
+ * before it. Looking up the peak range of any span of samples only touches a
+ * couple of buckets on the coarsest level that still resolves that span, so
+ * drawing and zooming cost does not depend on the length of the source.
+ *
+ * A PeakPyramid is built once and never modified afterwards, which means it can
+ * be built on a background thread and then read freely by the message thread.
+ */
+class PeakPyramid : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<PeakPyramid>;
+
+    static constexpr int baseSamplesPerBucket = 16;
+    static constexpr int readBlockSize = 256;       // Samples read at a time; a whole number of buckets
+
+    /** Writes numSamples float samples of a channel, from startSample on, to destination. */
+    using SampleReader = std::function<void(int channel, int startSample, float* destination, int numSamples)>;
+
+    /**
+     * Builds the pyramid from the given audio.
+     *
+     * @param source  The audio to summarise.
+     */
+    explicit PeakPyramid(const juce::AudioBuffer<float>& source);
+
+    /**
+     * Builds the pyramid from audio read one block at a time, so audio kept in
+     * a compact format never has to be converted to float in full.
+     *
+     * @param numChannels  The number of channels to summarise.
+     * @param numSamples   The number of samples in each channel.
+     * @param readSamples  Reads a block of a channel as float.
+     */
+    PeakPyramid(int numChannels, int numSamples, const SampleReader& readSamples);
+
+    /**
+     * Returns the number of samples in the audio the pyramid was built from.
+     */
+    int getNumSourceSamples() const { return numSourceSamples; }
+
+    /**
+     * Returns the min/max sample values found between two source positions.
+     *
+     * @param startSample  The first source sample of the span.
+     * @param endSample    The source sample one past the end of the span.
+     * @return             The range of values in the span, or an empty range if the span is empty.
+     */
+    juce::Range<float> getPeakRange(double startSample, double endSample) const;
+
+    /**
+     * Returns a copy without the levels finer than a given resolution, to save
+     * memory. Spans shorter than the finest level left are drawn from it, so
+     * close zooms just look blockier.
+     *
+     * @param samplesPerBucket  The finest resolution to keep.
+     * @return                  The copy, or this pyramid if it has nothing finer.
+     */
+    Ptr withoutLevelsFinerThan(int samplesPerBucket) const;
+
+    /**
+     * Returns the source samples per bucket on the finest level held.
+     */
+    int getFinestSamplesPerBucket() const { return levels.empty() ? baseSamplesPerBucket : levels.front().samplesPerBucket; }
+
+    /**
+     * Returns the memory the levels take up.
+     */
+    juce::int64 getSizeInBytes() const;
+
+private:
+    struct Level
+    {
+        int samplesPerBucket = baseSamplesPerBucket;
+        std::vector<float> minimums;
+        std::vector<float> maximums;
+    };
+
+    std::vector<Level> levels;      // levels[0] is the finest resolution
+    int numSourceSamples = 0;
+
+    PeakPyramid() = default;
+
+    /**
+     * Adds the coarser levels above the finest one.
+     */
+    void buildCoarserLevels();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PeakPyramid)
+};
@@ -0,0 +1,219 @@
+/*
+  ==============================================================================
+
+    PitchMarks.cpp
+    Created: 18 Oct 2026 11:58:31pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "PitchMarks.h"
+
+namespace
+{
+    constexpr double analysisRate = 8000.0;     // Pitch is detected at roughly this rate
+    constexpr double hopMs = 10.0;              // Time between period estimates
+    constexpr float yinThreshold = 0.15f;       // Highest normalised difference counted as a period
+    constexpr float silenceLevel = 0.001f;      // RMS below which a frame is unvoiced (-60 dB)
+
+    /**
+     * Averages each group of samples down to one. A crude low pass, but pitch
+     * detection only needs the fundamental to survive.
+     */
+    std::vector<float> decimate(const float* samples, int numSamples, int factor)
+    {
+        std::vector<float> decimated((size_t)(numSamples / factor));
+
+        for (size_t i = 0; i < decimated.size(); ++i)
+        {
+            float sum = 0.0f;
+
+            for (int j = 0; j < factor; ++j)
+                sum += samples[i * (size_t)factor + (size_t)j];
+
+            decimated[i] = sum / (float)factor;
+        }
+
+        return decimated;
+    }
+
+    /**
+     * Estimates the period of a frame with the YIN cumulative mean normalised
+     * difference function.
+     *
+     * @param frame       The frame, which must hold window + maxLag samples.
+     * @param window      The number of samples compared at each lag.
+     * @param minLag      The shortest period to accept.
+     * @param maxLag      The longest period to accept.
+     * @param difference  Scratch for the difference function, at least maxLag + 1 long.
+     * @return            The period in samples, or 0 if the frame is unvoiced.
+     */
+    int detectPeriod(const float* frame, int window, int minLag, int maxLag, std::vector<float>& difference)
+    {
+        float energy = 0.0f;
+
+        for (int j = 0; j < window; ++j)
+            energy += frame[j] * frame[j];
+
+        if (std::sqrt(energy / (float)window) < silenceLevel)
+            return 0;
+
+        difference[0] = 1.0f;
+        float runningSum = 0.0f;
+
+        for (int lag = 1; lag <= maxLag; ++lag)
+        {
+            float sum = 0.0f;
+
+            for (int j = 0; j < window; ++j)
+            {
+                const float delta = frame[j] - frame[j + lag];
+                sum += delta * delta;
+            }
+
+            runningSum += sum;
+            difference[(size_t)lag] = runningSum > 0.0f ? sum * (float)lag / runningSum : 1.0f;
+        }
+
+        for (int lag = minLag; lag <= maxLag; ++lag)
+        {
+            if (difference[(size_t)lag] < yinThreshold)
+            {
+                // Follow the dip down to its minimum
+                while (lag < maxLag && difference[(size_t)lag + 1] < difference[(size_t)lag])
+                    ++lag;
+
+                return lag;
+            }
+        }
+
+        return 0;
+    }
+
+    /** Returns the position of the largest magnitude sample in [start, end). */
+    int findPeak(const float* samples, int start, int end)
+    {
+        int peak = start;
+
+        for (int i = start + 1; i < end; ++i)
+            if (std::abs(samples[i]) > std::abs(samples[peak]))
+                peak = i;
+
+        return peak;
+    }
+}
+
+//==============================================================================
+std::unique_ptr<PitchMarks> PitchMarks::analyse(const float* samples, int numSamples, double sampleRate)
+{
+    auto result = std::make_unique<PitchMarks>();
+
+    const int factor = juce::jmax(1, (int)(sampleRate / analysisRate));
+    const double decimatedRate = sampleRate / factor;
+    const int minLag = juce::jmax(2, (int)(decimatedRate / maxFrequency));
+    const int maxLag = (int)std::ceil(decimatedRate / minFrequency);
+    const int window = maxLag;
+    const int hop = juce::jmax(1, juce::roundToInt(decimatedRate * hopMs * 0.001));
+
+    const auto decimated = decimate(samples, numSamples, factor);
+    const int numFrames = ((int)decimated.size() - window - maxLag) / hop + 1;
+
+    if (numFrames <= 0)
+        return result;
+
+    // The period at each hop, in full-rate samples, or 0 where unvoiced
+    std::vector<int> periods((size_t)numFrames);
+    std::vector<float> difference((size_t)maxLag + 1);
+
+    for (int frame = 0; frame < numFrames; ++frame)
+        periods[(size_t)frame] = detectPeriod(decimated.data() + (size_t)frame * (size_t)hop, window, minLag, maxLag, difference) * factor;
+
+    // Walk the full-rate audio, placing a mark on the strongest peak of each period
+    const int hopSamples = hop * factor;
+    const int minPeriod = minLag * factor;
+    const int unvoicedSpacing = juce::jmax(1, juce::roundToInt(sampleRate * unvoicedSpacingMs * 0.001));
+    auto& marks = result->marks;
+    int position = 0;
+    int numVoiced = 0;
+    bool lastVoiced = false;
+
+    marks.reserve((size_t)(numSamples / unvoicedSpacing) + 1);
+
+    for (;;)
+    {
+        const int period = periods[(size_t)juce::jmin(position / hopSamples, numFrames - 1)];
+        int mark;
+
+        if (period > 0)
+        {
+            // The next peak is about a period after the last mark; allow for the pitch drifting
+            int searchStart = position, searchEnd = position + period;
+
+            if (lastVoiced)
+            {
+                searchStart = position + period * 3 / 4;
+                searchEnd = position + period * 5 / 4;
+            }
+            else if (!marks.empty())
+            {
+                searchStart = position + minPeriod;
+            }
+
+            searchEnd = juce::jmin(searchEnd, numSamples);
+
+            if (searchStart >= searchEnd)
+                break;
+
+            mark = findPeak(samples, searchStart, searchEnd);
+            ++numVoiced;
+        }
+        else
+        {
+            mark = marks.empty() ? 0 : position + unvoicedSpacing;
+        }
+
+        if (mark >= numSamples)
+            break;
+
+        marks.push_back(mark);
+        position = mark;
+        lastVoiced = period > 0;
+    }
+
+    result->voicedFraction = marks.empty() ? 0.0f : (float)numVoiced / (float)marks.size();
+    return result;
+}
+
+int PitchMarks::findNearest(double position) const noexcept
+{
+    if (marks.empty())
+        return -1;
+
+    const auto next = std::lower_bound(marks.begin(), marks.end(), position,
+                                       [](int mark, double value) { return mark < value; });
+
+    if (next == marks.end())
+        return size() - 1;
+
+    if (next != marks.begin() && position - *(next - 1) < *next - position)
+        return (int)(next - marks.begin()) - 1;
+
+    return (int)(next - marks.begin());
+}
+
+int PitchMarks::getPeriod(int index) const noexcept
+{
+    const int last = size() - 1;
+
+    if (last <= 0)
+        return 1;
+
+    if (index <= 0)
+        return marks[1] - marks[0];
+
+    if (index >= last)
+        return marks[(size_t)last] - marks[(size_t)last - 1];
+
+    return (marks[(size_t)index + 1] - marks[(size_t)index - 1]) / 2;
+}
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    PitchMarks.h
+    Created: 18 Oct 2026 11:58:31pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * The pitch marks of a source: one position per pitch period, for
+ * pitch-synchronous (PSOLA) grains.
+ *
+ * analyse() estimates the pitch period every few milliseconds with the YIN
+ * difference function on a decimated copy of the audio, then walks the
+ * full-rate audio placing one mark on the strongest peak of each period.
+ * Unvoiced and silent stretches get evenly spaced marks, so every part of the
+ * source can be played. The marks are stored as a sorted array of sample
+ * positions, four bytes per period, and never change after analysis.
+ *
+ * Analysis is slow and allocates, so it runs once per source on a background
+ * thread. The lookups are binary searches that are safe on the audio thread.
+ */
+class PitchMarks
+{
+public:
+    static constexpr double minFrequency = 60.0;        // Lowest pitch detected
+    static constexpr double maxFrequency = 800.0;       // Highest pitch detected
+    static constexpr double unvoicedSpacingMs = 5.0;    // Mark spacing where no pitch is found
+
+    /**
+     * Finds the pitch marks of mono audio. Never call this from the audio thread.
+     *
+     * @param samples     The audio, mixed to mono.
+     * @param numSamples  The number of samples.
+     * @param sampleRate  The sample rate of the audio.
+     * @return            The marks, which are empty if the audio is too short to analyse.
+     */
+    static std::unique_ptr<PitchMarks> analyse(const float* samples, int numSamples, double sampleRate);
+
+    int size() const noexcept       { return (int)marks.size(); }
+    bool isEmpty() const noexcept   { return marks.empty(); }
+
+    /** Returns the sample position of a mark. */
+    int getMark(int index) const noexcept { return marks[(size_t)index]; }
+
+    /**
+     * Returns the index of the mark nearest a source position, or -1 if there are
+     * no marks. A binary search; safe on the audio thread.
+     */
+    int findNearest(double position) const noexcept;
+
+    /**
+     * Returns the local pitch period at a mark, in samples: the mean distance to
+     * its neighbours.
+     */
+    int getPeriod(int index) const noexcept;
+
+    /** Returns the fraction of marks that fall in voiced audio. */
+    float getVoicedFraction() const noexcept { return voicedFraction; }
+
+    /** Returns the memory the index takes up. */
+    size_t getSizeInBytes() const noexcept { return marks.size() * sizeof(int); }
+
+private:
+    std::vector<int> marks;     // Sorted sample positions, one per period
+    float voicedFraction = 0.0f;
+};
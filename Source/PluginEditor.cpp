@@ -14,10 +14,10 @@
 #include "PluginProcessor.h"
 
 Hw5AudioProcessorEditor::Hw5AudioProcessorEditor (Hw5AudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), waveformDisplay (p)
 {
     // Set the editor's size
-    setSize (400, 300);
+    setSize (500, 820);
 
     // Initialize sliders
     grainSizeSlider.setSliderStyle(juce::Slider::LinearHorizontal);
@@ -38,6 +38,21 @@ Hw5AudioProcessorEditor::Hw5AudioProcessorEditor (Hw5AudioProcessor& p)
     grainSpacingSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 80, 20);
     addAndMakeVisible(&grainSpacingSlider);
 
+    liveDelayMinSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    liveDelayMinSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 80, 20);
+    addAndMakeVisible(&liveDelayMinSlider);
+
+    liveDelayMaxSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    liveDelayMaxSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 80, 20);
+    addAndMakeVisible(&liveDelayMaxSlider);
+
+    for (auto* slider : { &filterCutoffSlider, &filterResonanceSlider, &filterSpreadSlider, &memoryBudgetSlider, &convolutionMixSlider })
+    {
+        slider->setSliderStyle(juce::Slider::LinearHorizontal);
+        slider->setTextBoxStyle(juce::Slider::TextBoxRight, false, 80, 20);
+        addAndMakeVisible(slider);
+    }
+
     // Initialize labels
     grainSizeLabel.setText("Grain Size:", juce::dontSendNotification);
     grainSizeLabel.attachToComponent(&grainSizeSlider, true);
@@ -51,11 +66,98 @@ Hw5AudioProcessorEditor::Hw5AudioProcessorEditor (Hw5AudioProcessor& p)
     grainSpacingLabel.attachToComponent(&grainSpacingSlider, true);
     addAndMakeVisible(&grainSpacingLabel);
 
+    liveDelayMinLabel.setText("Delay Min (ms):", juce::dontSendNotification);
+    liveDelayMinLabel.attachToComponent(&liveDelayMinSlider, true);
+    addAndMakeVisible(&liveDelayMinLabel);
+
+    liveDelayMaxLabel.setText("Delay Max (ms):", juce::dontSendNotification);
+    liveDelayMaxLabel.attachToComponent(&liveDelayMaxSlider, true);
+    addAndMakeVisible(&liveDelayMaxLabel);
+
+    filterCutoffLabel.setText("Cutoff (Hz):", juce::dontSendNotification);
+    filterCutoffLabel.attachToComponent(&filterCutoffSlider, true);
+    addAndMakeVisible(&filterCutoffLabel);
+
+    filterResonanceLabel.setText("Resonance:", juce::dontSendNotification);
+    filterResonanceLabel.attachToComponent(&filterResonanceSlider, true);
+    addAndMakeVisible(&filterResonanceLabel);
+
+    filterSpreadLabel.setText("Spread (oct):", juce::dontSendNotification);
+    filterSpreadLabel.attachToComponent(&filterSpreadSlider, true);
+    addAndMakeVisible(&filterSpreadLabel);
+
+    memoryBudgetLabel.setText("Budget (MB):", juce::dontSendNotification);
+    memoryBudgetLabel.attachToComponent(&memoryBudgetSlider, true);
+    addAndMakeVisible(&memoryBudgetLabel);
+
+    convolutionMixLabel.setText("IR Mix:", juce::dontSendNotification);
+    convolutionMixLabel.attachToComponent(&convolutionMixSlider, true);
+    addAndMakeVisible(&convolutionMixLabel);
+
+    // Grain rendering choices
+    grainWindowBox.addItemList({ "Hann", "Tukey", "Triangle", "Rectangular" }, 1);
+    addAndMakeVisible(&grainWindowBox);
+
+    grainInterpolationBox.addItemList({ "None", "Linear", "Cubic" }, 1);
+    addAndMakeVisible(&grainInterpolationBox);
+
+    addAndMakeVisible(&grainReverseButton);
+    addAndMakeVisible(&grainCacheButton);
+    addAndMakeVisible(&psolaButton);
+
+    // Memory residency of sources and the grain cache
+    addAndMakeVisible(&lockMemoryButton);
+    addAndMakeVisible(&hugePagesButton);
+
+    // Per-grain filter
+    filterModeBox.addItemList({ "Filter Off", "Low Pass", "Band Pass", "High Pass" }, 1);
+    addAndMakeVisible(&filterModeBox);
+
+    // Source storage, applied when the next file loads
+    sampleFormatBox.addItemList({ "Float", "16-bit", "Half Float" }, 1);
+    addAndMakeVisible(&sampleFormatBox);
+
+    // Live-input toggles
+    addAndMakeVisible(&liveInputButton);
+    addAndMakeVisible(&freezeButton);
+
     // Load file button
     loadFileButton.setButtonText("Load Audio File");
     loadFileButton.onClick = [this]() { loadFileButtonClicked(); };
     addAndMakeVisible(&loadFileButton);
 
+    panicButton.onClick = [this]() { audioProcessor.panic(); };
+    addAndMakeVisible(&panicButton);
+
+    bakeButton.onClick = [this]() { audioProcessor.bakeCloud(); };
+    addAndMakeVisible(&bakeButton);
+
+    traceButton.setClickingTogglesState(true);
+    traceButton.setToggleState(audioProcessor.isTracing(), juce::dontSendNotification);
+    traceButton.onClick = [this]() { traceButtonClicked(); };
+    addAndMakeVisible(&traceButton);
+
+    recordButton.setClickingTogglesState(true);
+    recordButton.setToggleState(audioProcessor.isRecording(), juce::dontSendNotification);
+    recordButton.onClick = [this]() { recordButtonClicked(); };
+    addAndMakeVisible(&recordButton);
+    addAndMakeVisible(&resampleButton);
+
+    // Convolution reverb after the grain engine
+    addAndMakeVisible(&convolutionButton);
+    loadImpulseButton.onClick = [this]() { loadImpulseResponse(); };
+    addAndMakeVisible(&loadImpulseButton);
+
+    // Waveform and grain-cloud display
+    addAndMakeVisible(&waveformDisplay);
+
+    // Engine status
+    engineStatusLabel.setJustificationType(juce::Justification::centredRight);
+    addAndMakeVisible(&engineStatusLabel);
+    memoryStatusLabel.setJustificationType(juce::Justification::centredRight);
+    addAndMakeVisible(&memoryStatusLabel);
+    startTimerHz(4);
+
     // Attach sliders to the AudioProcessorValueTreeState
     grainSizeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.getAPVTS(), "GRAIN_SIZE", grainSizeSlider);
@@ -63,6 +165,44 @@ Hw5AudioProcessorEditor::Hw5AudioProcessorEditor (Hw5AudioProcessor& p)
         audioProcessor.getAPVTS(), "GRAIN_OVERLAP", grainOverlapSlider);
     grainSpacingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.getAPVTS(), "GRAIN_SPACING", grainSpacingSlider);
+    liveDelayMinAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "LIVE_DELAY_MIN", liveDelayMinSlider);
+    liveDelayMaxAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "LIVE_DELAY_MAX", liveDelayMaxSlider);
+    liveInputAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getAPVTS(), "LIVE_INPUT", liveInputButton);
+    freezeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getAPVTS(), "FREEZE", freezeButton);
+    grainWindowAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "GRAIN_WINDOW", grainWindowBox);
+    grainInterpolationAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "GRAIN_INTERPOLATION", grainInterpolationBox);
+    grainReverseAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getAPVTS(), "GRAIN_REVERSE", grainReverseButton);
+    grainCacheAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getAPVTS(), "GRAIN_CACHE", grainCacheButton);
+    lockMemoryAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getAPVTS(), "LOCK_MEMORY", lockMemoryButton);
+    hugePagesAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getAPVTS(), "HUGE_PAGES", hugePagesButton);
+    filterModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "FILTER_MODE", filterModeBox);
+    sampleFormatAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "SAMPLE_FORMAT", sampleFormatBox);
+    psolaAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getAPVTS(), "PSOLA", psolaButton);
+    filterCutoffAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "FILTER_CUTOFF", filterCutoffSlider);
+    filterResonanceAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "FILTER_RESONANCE", filterResonanceSlider);
+    filterSpreadAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "FILTER_SPREAD", filterSpreadSlider);
+    memoryBudgetAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "MEMORY_BUDGET", memoryBudgetSlider);
+    convolutionAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getAPVTS(), "CONVOLUTION", convolutionButton);
+    convolutionMixAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "CONVOLUTION_MIX", convolutionMixSlider);
 
     // Enable drag and drop
     setWantsKeyboardFocus(true);
@@ -97,22 +237,69 @@ void Hw5AudioProcessorEditor::resized()
     yPosition += sliderHeight + 10;
 
     grainSpacingSlider.setBounds(labelWidth, yPosition, getWidth() - labelWidth - 20, sliderHeight);
+    yPosition += sliderHeight + 10;
+
+    grainWindowBox.setBounds(labelWidth, yPosition, 120, sliderHeight);
+    grainInterpolationBox.setBounds(labelWidth + 130, yPosition, 120, sliderHeight);
+    grainReverseButton.setBounds(labelWidth + 260, yPosition, 100, sliderHeight);
+    yPosition += sliderHeight + 10;
+
+    filterModeBox.setBounds(labelWidth, yPosition, 120, sliderHeight);
+    sampleFormatBox.setBounds(labelWidth + 130, yPosition, 120, sliderHeight);
+    psolaButton.setBounds(labelWidth + 260, yPosition, 100, sliderHeight);
+    yPosition += sliderHeight + 10;
+
+    filterCutoffSlider.setBounds(labelWidth, yPosition, getWidth() - labelWidth - 20, sliderHeight);
+    yPosition += sliderHeight + 10;
+
+    filterResonanceSlider.setBounds(labelWidth, yPosition, getWidth() - labelWidth - 20, sliderHeight);
+    yPosition += sliderHeight + 10;
+
+    filterSpreadSlider.setBounds(labelWidth, yPosition, getWidth() - labelWidth - 20, sliderHeight);
+    yPosition += sliderHeight + 10;
+
+    liveInputButton.setBounds(labelWidth, yPosition, 120, sliderHeight);
+    freezeButton.setBounds(labelWidth + 130, yPosition, 120, sliderHeight);
+    grainCacheButton.setBounds(labelWidth + 260, yPosition, 120, sliderHeight);
+    yPosition += sliderHeight + 10;
+
+    lockMemoryButton.setBounds(labelWidth, yPosition, 120, sliderHeight);
+    hugePagesButton.setBounds(labelWidth + 130, yPosition, 120, sliderHeight);
+    resampleButton.setBounds(labelWidth + 260, yPosition, 120, sliderHeight);
+    yPosition += sliderHeight + 10;
+
+    memoryBudgetSlider.setBounds(labelWidth, yPosition, getWidth() - labelWidth - 20, sliderHeight);
+    yPosition += sliderHeight + 10;
+
+    // The mix slider shares its row with the stage's toggle and IR chooser
+    convolutionButton.setBounds(10, yPosition, 110, sliderHeight);
+    loadImpulseButton.setBounds(125, yPosition, 70, sliderHeight);
+    convolutionMixSlider.setBounds(labelWidth + 160, yPosition, getWidth() - labelWidth - 180, sliderHeight);
+    yPosition += sliderHeight + 10;
+
+    liveDelayMinSlider.setBounds(labelWidth, yPosition, getWidth() - labelWidth - 20, sliderHeight);
+    yPosition += sliderHeight + 10;
+
+    liveDelayMaxSlider.setBounds(labelWidth, yPosition, getWidth() - labelWidth - 20, sliderHeight);
     yPosition += sliderHeight + 20;
 
     loadFileButton.setBounds((getWidth() - 150) / 2, yPosition, 150, 30);
+    panicButton.setBounds(getWidth() - 90, yPosition, 80, 30);
+    bakeButton.setBounds(getWidth() - 165, yPosition, 70, 30);
+    traceButton.setBounds(10, yPosition, 80, 30);
+    recordButton.setBounds(95, yPosition, 75, 30);
+    yPosition += 30 + 10;
+
+    waveformDisplay.setBounds(10, yPosition, getWidth() - 20, getHeight() - yPosition - 80);
+
+    memoryStatusLabel.setBounds(10, getHeight() - 70, getWidth() - 20, 20);
+    engineStatusLabel.setBounds(10, getHeight() - 50, getWidth() - 20, 20);
 }
 
 bool Hw5AudioProcessorEditor::isInterestedInFileDrag (const juce::StringArray& files)
 {
-    // Initialize a static AudioFormatManager
-    static juce::AudioFormatManager formatManager;
-    static bool formatsRegistered = false;
-
-    if (!formatsRegistered)
-    {
-        formatManager.registerBasicFormats();
-        formatsRegistered = true;
-    }
+    // The pool's format manager is the one that will load the file
+    auto& formatManager = audioProcessor.getFormatManager();
 
     // We are interested if any of the files are audio files
     for (auto& file : files)
@@ -163,8 +350,110 @@ void Hw5AudioProcessorEditor::loadAudioFile()
         });
 }
 
+void Hw5AudioProcessorEditor::loadImpulseResponse()
+{
+    fileChooser = std::make_unique<juce::FileChooser>("Select an impulse response...", juce::File(), "*.wav;*.aiff;*.flac");
+
+    fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+        [this](const juce::FileChooser&)
+        {
+            auto impulseFile = fileChooser->getResult();
+
+            if (impulseFile.existsAsFile())
+                audioProcessor.loadImpulseResponse(impulseFile);
+
+            fileChooser.reset();
+        });
+}
+
+void Hw5AudioProcessorEditor::timerCallback()
+{
+    const auto governor = audioProcessor.getGovernorState();
+    const auto cache = audioProcessor.getGrainCacheStats();
+    const auto storage = audioProcessor.getSourceStorageSummary();
+    const auto residency = audioProcessor.getMemoryResidencyReport();
+    const auto& recorder = audioProcessor.getOutputRecorder();
+    const auto impulse = audioProcessor.getImpulseResponseSummary();
+
+    juce::String recording;
+
+    if (recorder.isRecording())
+    {
+        recording << "  |  Rec " << juce::String((double)recorder.getNumRecorded() / recorder.getSampleRate(), 1) << " s";
+
+        if (recorder.getNumDropped() > 0)
+            recording << " (" << juce::String(recorder.getNumDropped()) << " dropped)";
+    }
+
+    engineStatusLabel.setText("CPU " + juce::String(juce::roundToInt(governor.load * 100.0f)) + "%"
+                              + "  |  Level " + juce::String(governor.level)
+                              + "  |  Grains " + juce::String(governor.activeGrains)
+                              + "  |  Dropped " + juce::String(governor.droppedSpawns)
+                              + "  |  Faded " + juce::String(governor.fadedGrains)
+                              + "  |  Pool " + juce::File::descriptionOfSizeInBytes(audioProcessor.getSamplePoolBytes())
+                              + "  |  Cache " + juce::String(cache.hits) + "/" + juce::String(cache.misses)
+                              + (storage.isNotEmpty() ? "  |  Source " + storage : juce::String())
+                              + (residency.lockedBytes > 0 || residency.numLockFailures > 0 ? "  |  " + residency.toString() : juce::String())
+                              + (impulse.isNotEmpty() ? "  |  IR " + impulse : juce::String())
+                              + (audioProcessor.isBakingCloud() ? "  |  Baking" : audioProcessor.isPlayingBakedCloud() ? "  |  Baked loop" : "")
+                              + recording,
+                              juce::dontSendNotification);
+
+    // Explains why locking fell back, e.g. a low RLIMIT_MEMLOCK
+    engineStatusLabel.setTooltip(residency.lastProblem);
+
+    const auto instanceMemory = audioProcessor.getInstanceMemoryUsage();
+    const auto processMemory = audioProcessor.getProcessMemoryUsage();
+    const auto budget = audioProcessor.getProcessMemoryBudget();
+
+    memoryStatusLabel.setText("Memory " + juce::File::descriptionOfSizeInBytes(instanceMemory.getTotal())
+                              + "  |  Process " + juce::File::descriptionOfSizeInBytes(processMemory.getTotal())
+                              + (budget > 0 ? " of " + juce::File::descriptionOfSizeInBytes(budget) : juce::String()),
+                              juce::dontSendNotification);
+
+    // The breakdown is too long for the label
+    memoryStatusLabel.setTooltip("This instance: " + instanceMemory.toString()
+                                 + "\nProcess: " + processMemory.toString());
+}
+
 void Hw5AudioProcessorEditor::loadFileButtonClicked()
 {
     DBG("Load File Button Clicked.");
     loadAudioFile();
 }
+
+void Hw5AudioProcessorEditor::traceButtonClicked()
+{
+    if (!traceButton.getToggleState())
+    {
+        audioProcessor.stopTrace();
+        return;
+    }
+
+    const auto traceFile = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                               .getChildFile("hw5 trace.json")
+                               .getNonexistentSibling();
+
+    if (audioProcessor.startTrace(traceFile))
+        DBG("Tracing to " << traceFile.getFullPathName());
+    else
+        traceButton.setToggleState(false, juce::dontSendNotification);
+}
+
+void Hw5AudioProcessorEditor::recordButtonClicked()
+{
+    if (!recordButton.getToggleState())
+    {
+        audioProcessor.stopRecording();
+        return;
+    }
+
+    const auto recordingFile = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                                   .getChildFile("hw5 recording.wav")
+                                   .getNonexistentSibling();
+
+    if (audioProcessor.startRecording(recordingFile, resampleButton.getToggleState()))
+        DBG("Recording to " << recordingFile.getFullPathName());
+    else
+        recordButton.setToggleState(false, juce::dontSendNotification);
+}
@@ -10,12 +10,14 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "WaveformDisplay.h"
 
 //==============================================================================
 /**
 */
 class Hw5AudioProcessorEditor  : public juce::AudioProcessorEditor,
-                                 public juce::FileDragAndDropTarget
+                                 public juce::FileDragAndDropTarget,
+                                 private juce::Timer
 {
 public:
     /**
@@ -68,22 +70,86 @@ private:
     juce::Slider grainSizeSlider;
     juce::Slider grainOverlapSlider;
     juce::Slider grainSpacingSlider;
+    juce::Slider liveDelayMinSlider;
+    juce::Slider liveDelayMaxSlider;
+    juce::Slider filterCutoffSlider;
+    juce::Slider filterResonanceSlider;
+    juce::Slider filterSpreadSlider;
+    juce::Slider memoryBudgetSlider;    // Process-wide budget; 0 turns it off
+    juce::Slider convolutionMixSlider;
 
     juce::Label grainSizeLabel;
     juce::Label grainOverlapLabel;
     juce::Label grainSpacingLabel;
+    juce::Label liveDelayMinLabel;
+    juce::Label liveDelayMaxLabel;
+    juce::Label filterCutoffLabel;
+    juce::Label filterResonanceLabel;
+    juce::Label filterSpreadLabel;
+    juce::Label memoryBudgetLabel;
+    juce::Label convolutionMixLabel;
+
+    juce::ToggleButton liveInputButton { "Live Input" };
+    juce::ToggleButton freezeButton { "Freeze" };
+
+    juce::ComboBox grainWindowBox;
+    juce::ComboBox grainInterpolationBox;
+    juce::ToggleButton grainReverseButton { "Reverse" };
+    juce::ToggleButton grainCacheButton { "Grain Cache" };
+    juce::ToggleButton lockMemoryButton { "Lock Memory" };  // Applies from the next load or prepare
+    juce::ToggleButton hugePagesButton { "Huge Pages" };
+    juce::ComboBox filterModeBox;
+    juce::ComboBox sampleFormatBox;     // Storage format for files loaded from now on
+    juce::ToggleButton psolaButton { "PSOLA" };    // Pitch-synchronous grains once the file is analysed
 
     juce::TextButton loadFileButton;
+    juce::TextButton panicButton { "Panic" };
+    juce::TextButton bakeButton { "Bake" };     // Loops the current cloud until a parameter moves
+    juce::TextButton traceButton { "Trace" };    // Records a Perfetto trace while toggled on
+    juce::TextButton recordButton { "Record" };  // Records the output while toggled on
+    juce::ToggleButton resampleButton { "Resample" };   // Granulate the recording once it stops
+    juce::ToggleButton convolutionButton { "Convolution" };
+    juce::TextButton loadImpulseButton { "Load IR" };   // Chooses the convolution stage's impulse response
+
+    WaveformDisplay waveformDisplay;
+
+    juce::Label engineStatusLabel;      // CPU governor, sample pool and grain cache state
+    juce::Label memoryStatusLabel;      // Instance and process memory against the budget
+    juce::TooltipWindow tooltipWindow { this };     // Shows why memory locking fell back
 
     // Attachment classes for parameter control
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> grainSizeAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> grainOverlapAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> grainSpacingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> liveDelayMinAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> liveDelayMaxAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> liveInputAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> freezeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> grainWindowAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> grainInterpolationAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> grainReverseAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> grainCacheAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> lockMemoryAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> hugePagesAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> filterModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> sampleFormatAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> psolaAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> filterCutoffAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> filterResonanceAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> filterSpreadAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> memoryBudgetAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> convolutionAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> convolutionMixAttachment;
 
     /**
      * Opens a file chooser dialog to load an audio file.
      */
     void loadAudioFile();
+
+    /**
+     * Opens a file chooser dialog to load an impulse response for the convolution stage.
+     */
+    void loadImpulseResponse();
     
     std::unique_ptr<juce::FileChooser> fileChooser;
 
@@ -93,5 +159,20 @@ private:
      */
     void loadFileButtonClicked();
 
+    /**
+     * Starts or stops a trace recording in the user's documents folder.
+     */
+    void traceButtonClicked();
+
+    /**
+     * Starts or stops recording the output to the user's documents folder.
+     */
+    void recordButtonClicked();
+
+    /**
+     * Refreshes the engine and memory status labels.
+     */
+    void timerCallback() override;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Hw5AudioProcessorEditor)
 };
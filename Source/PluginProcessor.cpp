@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "RealtimeAudit.h"
 
 //==============================================================================
 Hw5AudioProcessor::Hw5AudioProcessor()
@@ -16,6 +17,8 @@ Hw5AudioProcessor::Hw5AudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                      #else
+                       .withInput  ("Sidechain",  juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
@@ -23,6 +26,8 @@ Hw5AudioProcessor::Hw5AudioProcessor()
             apvts(*this, nullptr, "Parameters", createParameters())
 #endif
 {
+    memoryAccounting->addClient(this);
+    startTimerHz(4);
 }
 juce::AudioProcessorValueTreeState::ParameterLayout Hw5AudioProcessor::createParameters()
 {
@@ -32,12 +37,47 @@ juce::AudioProcessorValueTreeState::ParameterLayout Hw5AudioProcessor::createPar
     params.push_back(std::make_unique<juce::AudioParameterInt>("GRAIN_OVERLAP", "Grain Overlap", 0, 2048, 256));
     params.push_back(std::make_unique<juce::AudioParameterInt>("GRAIN_SPACING", "Grain Spacing", 0, 2048, 0));
 
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("GRAIN_WINDOW", "Grain Window",
+                                                                  juce::StringArray { "Hann", "Tukey", "Triangle", "Rectangular" }, 0));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("GRAIN_INTERPOLATION", "Grain Interpolation",
+                                                                  juce::StringArray { "None", "Linear", "Cubic" }, 1));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("GRAIN_REVERSE", "Grain Reverse", false));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("GRAIN_CACHE", "Grain Cache", false));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("PSOLA", "PSOLA", false));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("SAMPLE_FORMAT", "Sample Format",
+                                                                  juce::StringArray { "Float", "16-bit", "Half Float" }, 0));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("LOCK_MEMORY", "Lock Memory", false));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("HUGE_PAGES", "Huge Pages", false));
+    params.push_back(std::make_unique<juce::AudioParameterInt>("MEMORY_BUDGET", "Memory Budget (MB)", 0, 65536, 0));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("CONVOLUTION", "Convolution", false));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("CONVOLUTION_MIX", "Convolution Mix", 0.0f, 1.0f, 0.3f));
+
+    juce::NormalisableRange<float> cutoffRange(20.0f, 20000.0f);
+    cutoffRange.setSkewForCentre(1000.0f);
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("FILTER_MODE", "Grain Filter",
+                                                                  juce::StringArray { "Off", "Low Pass", "Band Pass", "High Pass" }, 0));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("FILTER_CUTOFF", "Filter Cutoff (Hz)", cutoffRange, 2000.0f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("FILTER_RESONANCE", "Filter Resonance", 0.5f, 10.0f, 0.707f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("FILTER_SPREAD", "Filter Spread (oct)", 0.0f, 4.0f, 0.0f));
+
+    const float maxLiveDelayMs = static_cast<float>(GranSynth::maxLiveDelaySeconds * 1000.0);
+    params.push_back(std::make_unique<juce::AudioParameterBool>("LIVE_INPUT", "Live Input", false));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("FREEZE", "Freeze", false));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("LIVE_DELAY_MIN", "Live Delay Min (ms)", 0.0f, maxLiveDelayMs, 0.0f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("LIVE_DELAY_MAX", "Live Delay Max (ms)", 0.0f, maxLiveDelayMs, 500.0f));
+
+    const int defaultCpuBudget = juce::roundToInt(CpuGovernor::Settings().targetLoad * 100.0f);
+    params.push_back(std::make_unique<juce::AudioParameterInt>("CPU_BUDGET", "CPU Budget (%)", 10, 100, defaultCpuBudget));
+
     return { params.begin(), params.end() };
 }
 
 
 Hw5AudioProcessor::~Hw5AudioProcessor()
 {
+    // A bake reads the parameters, which go before the engine does
+    granSynth.cancelBake();
+    memoryAccounting->removeClient(this);
 }
 
 //==============================================================================
@@ -75,7 +115,8 @@ bool Hw5AudioProcessor::isMidiEffect() const
 
 double Hw5AudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    const bool convolving = apvts.getRawParameterValue("CONVOLUTION")->load() >= 0.5f;
+    return granSynth.getTailLengthSeconds() + (convolving ? convolutionStage.getImpulseResponseSeconds() : 0.0);
 }
 
 int Hw5AudioProcessor::getNumPrograms()
@@ -105,10 +146,19 @@ void Hw5AudioProcessor::changeProgramName (int index, const juce::String& newNam
 //==============================================================================
 void Hw5AudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    granSynth.prepareToPlay(sampleRate, samplesPerBlock);
+    updateMemoryResidency();
+    granSynth.prepareToPlay(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
+
+    // A session saved with the grain cache on has it from the first block
+    if (apvts.getRawParameterValue("GRAIN_CACHE")->load() >= 0.5f)
+        granSynth.prepareGrainCache();
+
+    outputRecorder.prepare(sampleRate, getTotalNumOutputChannels());
+    convolutionStage.prepare(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
     // Set initial grain parameters
     updateGrainParameters();
 
+    memoryAccounting->enforceBudget();
 }
 
 void Hw5AudioProcessor::releaseResources()
@@ -135,6 +185,14 @@ bool Hw5AudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) cons
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+   #else
+    // The sidechain feeds live-input granulation and may be mono, stereo or switched off
+    const auto sidechain = layouts.getMainInputChannelSet();
+
+    if (sidechain != juce::AudioChannelSet::disabled()
+     && sidechain != juce::AudioChannelSet::mono()
+     && sidechain != juce::AudioChannelSet::stereo())
+        return false;
    #endif
 
     return true;
@@ -143,28 +201,340 @@ bool Hw5AudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) cons
 #endif
 
 void Hw5AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    const RealtimeAudit::ScopedRealtimeSection realtimeSection;
+    processSamples(buffer, midiMessages);
+}
+
+void Hw5AudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    const RealtimeAudit::ScopedRealtimeSection realtimeSection;
+    processSamples(buffer, midiMessages);
+}
+
+bool Hw5AudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void Hw5AudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
 {
 //    juce::ScopedNoDenormals noDenormals;
     
     // Update grain parameters in case they have changed
     updateGrainParameters();
 
+    // Offline renders have no deadline, so never thin them out
+    granSynth.getGovernor().setEnabled(!isNonRealtime());
+
+    // Capture the input before the synth overwrites the buffer with its output
+    granSynth.captureInput(getBusBuffer(buffer, true, 0));
+
     granSynth.processBlock(buffer, midiMessages);
-    granSynth.processBlock(buffer, midiMessages);
+    convolutionStage.process(buffer);
+
+    outputRecorder.push(buffer);
 }
 
 void Hw5AudioProcessor::updateGrainParameters()
+{
+    applyGrainParameters(granSynth);
+
+    bool convolution = apvts.getRawParameterValue("CONVOLUTION")->load() >= 0.5f;
+    float convolutionMix = apvts.getRawParameterValue("CONVOLUTION_MIX")->load();
+
+    convolutionStage.setParameters(convolution, convolutionMix);
+}
+
+void Hw5AudioProcessor::applyGrainParameters(GranSynth& synth) const
 {
     int grainSize = apvts.getRawParameterValue("GRAIN_SIZE")->load();
     int grainOverlap = apvts.getRawParameterValue("GRAIN_OVERLAP")->load();
     int grainSpacing = apvts.getRawParameterValue("GRAIN_SPACING")->load();
 
-    granSynth.setGrainParameters(grainSize, grainOverlap, grainSpacing);
+    synth.setGrainParameters(grainSize, grainOverlap, grainSpacing);
+
+    auto window = static_cast<WindowShape>(static_cast<int>(apvts.getRawParameterValue("GRAIN_WINDOW")->load()));
+    auto interpolation = static_cast<Interpolation>(static_cast<int>(apvts.getRawParameterValue("GRAIN_INTERPOLATION")->load()));
+    bool reverse = apvts.getRawParameterValue("GRAIN_REVERSE")->load() >= 0.5f;
+
+    synth.setGrainRendering(window, interpolation, reverse);
+    synth.setGrainCacheEnabled(apvts.getRawParameterValue("GRAIN_CACHE")->load() >= 0.5f);
+    synth.setPitchSynchronous(apvts.getRawParameterValue("PSOLA")->load() >= 0.5f);
+
+    auto filterMode = static_cast<GrainFilterMode>(static_cast<int>(apvts.getRawParameterValue("FILTER_MODE")->load()));
+    float filterCutoff = apvts.getRawParameterValue("FILTER_CUTOFF")->load();
+    float filterResonance = apvts.getRawParameterValue("FILTER_RESONANCE")->load();
+    float filterSpread = apvts.getRawParameterValue("FILTER_SPREAD")->load();
+
+    synth.setGrainFilter(filterMode, filterCutoff, filterResonance, filterSpread);
+
+    bool liveInput = apvts.getRawParameterValue("LIVE_INPUT")->load() >= 0.5f;
+    bool freeze = apvts.getRawParameterValue("FREEZE")->load() >= 0.5f;
+    float liveDelayMin = apvts.getRawParameterValue("LIVE_DELAY_MIN")->load();
+    float liveDelayMax = apvts.getRawParameterValue("LIVE_DELAY_MAX")->load();
+
+    synth.setLiveInputParameters(liveInput, freeze, liveDelayMin, liveDelayMax);
+}
+
+void Hw5AudioProcessor::timerCallback()
+{
+    // The cache's slots and fill thread are only set up once it is first turned on
+    if (apvts.getRawParameterValue("GRAIN_CACHE")->load() >= 0.5f)
+        granSynth.prepareGrainCache();
+
+    const int cpuBudget = static_cast<int>(apvts.getRawParameterValue("CPU_BUDGET")->load());
+
+    if (cpuBudget == sentCpuBudget)
+        return;
+
+    // The governor backs off at the same fraction of the budget as by default
+    CpuGovernor::Settings settings;
+    const float defaultTargetLoad = settings.targetLoad;
+    settings.targetLoad = cpuBudget / 100.0f;
+    settings.recoveryLoad *= settings.targetLoad / defaultTargetLoad;
+
+    // If the queue is full, the next tick tries again
+    if (granSynth.setGovernorSettings(settings))
+        sentCpuBudget = cpuBudget;
 }
 
 void Hw5AudioProcessor::loadAudioFile(const juce::File& audioFile)
 {
-    granSynth.loadAudioFile(audioFile);
+    // The format applies to each file as it is loaded, so sources can differ
+    const auto storage = static_cast<SampleStorage>(static_cast<int>(apvts.getRawParameterValue("SAMPLE_FORMAT")->load()));
+    updateMemoryResidency();
+    auto source = granSynth.loadAudioFile(audioFile, storage);
+
+    if (source == nullptr)
+        return;
+
+    showSource(source);
+    loadedFile = audioFile;
+    memoryAccounting->enforceBudget();
+}
+
+bool Hw5AudioProcessor::bakeCloud()
+{
+    // Live input never repeats, so there is nothing static to bake
+    if (apvts.getRawParameterValue("LIVE_INPUT")->load() >= 0.5f)
+        return false;
+
+    return granSynth.bakeCloud(bakeSeconds, [this](GranSynth& synth) { applyGrainParameters(synth); });
+}
+
+bool Hw5AudioProcessor::startRecording(const juce::File& file, bool useAsSource)
+{
+    return outputRecorder.start(file, useAsSource);
+}
+
+void Hw5AudioProcessor::stopRecording()
+{
+    auto source = outputRecorder.stop();
+
+    if (source == nullptr)
+        return;
+
+    // Recordings don't come from the pool, so their pitch marks are asked for here
+    granSynth.getSamplePool().analysePitchMarks(source);
+
+    if (granSynth.swapSource(source))
+    {
+        showSource(source);
+        loadedFile = juce::File();
+    }
+    else
+        DBG("Engine command queue is full; the recording was not sent to the engine.");
+}
+
+void Hw5AudioProcessor::showSource(const SourceBuffer::Ptr& source)
+{
+    {
+        const juce::ScopedLock lock(peakPyramidLock);
+        loadedSource = source;
+    }
+
+    // Summarise the new source for the waveform display without holding up the caller.
+    // The source may still be decoding, so wait for it here rather than on the caller.
+    if (backgroundPool == nullptr)
+        backgroundPool = std::make_unique<juce::ThreadPool>(1);
+
+    backgroundPool->addJob([this, source]
+    {
+        if (!source->waitUntilLoaded())
+            return;
+
+        // Compact sources are read a block at a time rather than copied to float in full
+        PeakPyramid::Ptr pyramid = new PeakPyramid(source->getNumChannels(), source->getNumSamples(),
+                                                   [&source](int channel, int startSample, float* destination, int numSamples)
+                                                   {
+                                                       source->readSamples(channel, startSample, destination, numSamples);
+                                                   });
+
+        const juce::ScopedLock lock(peakPyramidLock);
+        peakPyramid = pyramid;
+    });
+}
+
+juce::String Hw5AudioProcessor::getImpulseResponseSummary() const
+{
+    const auto& file = convolutionStage.getImpulseResponseFile();
+
+    if (file == juce::File())
+        return {};
+
+    const double seconds = convolutionStage.getImpulseResponseSeconds();
+
+    // The length is only known once the convolver has switched to the new IR
+    return file.getFileNameWithoutExtension() + (seconds > 0.0 ? " " + juce::String(seconds, 2) + " s" : juce::String(" (loading)"));
+}
+
+PeakPyramid::Ptr Hw5AudioProcessor::getPeakPyramid() const
+{
+    const juce::ScopedLock lock(peakPyramidLock);
+    return peakPyramid;
+}
+
+bool Hw5AudioProcessor::isSourceAnalysed() const
+{
+    const juce::ScopedLock lock(peakPyramidLock);
+    return loadedSource != nullptr && loadedSource->getPitchMarks() != nullptr;
+}
+
+MemoryAccounting::Usage Hw5AudioProcessor::getMemoryUsage(bool includePooled) const
+{
+    using Category = MemoryAccounting::Category;
+
+    auto usage = granSynth.getMemoryUsage(includePooled);
+    usage[Category::buffers] += outputRecorder.getSizeInBytes() + convolutionStage.getSizeInBytes();
+
+    const auto pyramid = getPeakPyramid();
+
+    if (pyramid != nullptr)
+        usage[Category::analysis] += pyramid->getSizeInBytes();
+
+    return usage;
+}
+
+juce::int64 Hw5AudioProcessor::evict(MemoryAccounting::Eviction eviction)
+{
+    switch (eviction)
+    {
+        case MemoryAccounting::Eviction::grainCaches:
+            return granSynth.evictGrainCache();
+
+        case MemoryAccounting::Eviction::peakLevels:
+        {
+            // The display only needs the fine levels when zoomed right in; it falls back to the audio
+            constexpr int finestKeptSamplesPerBucket = 1024;
+
+            const juce::ScopedLock lock(peakPyramidLock);
+
+            if (peakPyramid == nullptr)
+                return 0;
+
+            PeakPyramid::Ptr coarser = peakPyramid->withoutLevelsFinerThan(finestKeptSamplesPerBucket);
+            const juce::int64 freed = peakPyramid->getSizeInBytes() - coarser->getSizeInBytes();
+            peakPyramid = coarser;
+            return freed;
+        }
+
+        case MemoryAccounting::Eviction::rateConvertedSources:
+            return reloadAtFileRate();
+
+        case MemoryAccounting::Eviction::numEvictions:
+            break;
+    }
+
+    return 0;
+}
+
+juce::int64 Hw5AudioProcessor::getMemoryBudget() const
+{
+    const auto megabytes = (juce::int64)apvts.getRawParameterValue("MEMORY_BUDGET")->load();
+    return megabytes * 1024 * 1024;
+}
+
+juce::int64 Hw5AudioProcessor::reloadAtFileRate()
+{
+    SourceBuffer::Ptr source;
+
+    {
+        const juce::ScopedLock lock(peakPyramidLock);
+        source = loadedSource;
+    }
+
+    if (source == nullptr || loadedFile == juce::File())
+        return 0;
+
+    auto& pool = granSynth.getSamplePool();
+    const double fileSampleRate = pool.getFileSampleRate(source.get());
+
+    if (fileSampleRate <= 0.0 || fileSampleRate >= source->getSampleRate())
+        return 0;
+
+    const auto storage = source->getStorage();
+    auto reloaded = granSynth.loadAudioFile(loadedFile, storage, false);
+
+    if (reloaded == nullptr)
+        return 0;
+
+    showSource(reloaded);
+
+    // The old copy is only freed once no instance is left using it, and the engine
+    // lets go of it at its next block, so only count it if the pool has dropped it.
+    // Otherwise the next budget check sees the memory once it has really gone.
+    const SourceBuffer* oldSource = source.get();
+    const juce::int64 freed = source->getSizeInBytes() - reloaded->getSizeInBytes();
+    source = nullptr;
+    pool.releaseUnused();
+
+    return pool.contains(oldSource) ? 0 : freed;
+}
+
+void Hw5AudioProcessor::updateMemoryResidency()
+{
+    ResidentMemory::Options options;
+    options.lockInMemory = apvts.getRawParameterValue("LOCK_MEMORY")->load() > 0.5f;
+    options.useHugePages = apvts.getRawParameterValue("HUGE_PAGES")->load() > 0.5f;
+
+    granSynth.setMemoryResidency(options);
+}
+
+juce::String Hw5AudioProcessor::getSourceStorageSummary() const
+{
+    SourceBuffer::Ptr source;
+
+    {
+        const juce::ScopedLock lock(peakPyramidLock);
+        source = loadedSource;
+    }
+
+    if (source == nullptr)
+        return {};
+
+    juce::String summary = juce::String(SampleStorageConversion::getName(source->getStorage())) + " "
+                         + juce::File::descriptionOfSizeInBytes(source->getSizeInBytes());
+
+    if (source->getStorage() != SampleStorage::float32)
+    {
+        const auto error = source->getStorageError();
+        summary << ", SNR " << juce::String(error.getSignalToErrorDb(), 1) << " dB"
+                << ", peak error " << juce::String(error.getPeakErrorDb(), 1) << " dBFS";
+    }
+
+    const auto& residency = source->getResidency();
+
+    if (residency.locked)
+        summary << ", locked";
+    else if (residency.prefaulted)
+        summary << ", prefaulted";
+
+    if (residency.hugePages)
+        summary << ", huge pages";
+
+    return summary;
 }
 
 //==============================================================================
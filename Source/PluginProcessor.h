@@ -10,11 +10,17 @@
 
 #include <JuceHeader.h>
 #include "GranSynth.h"
+#include "PeakPyramid.h"
+#include "OutputRecorder.h"
+#include "MemoryAccounting.h"
+#include "ConvolutionStage.h"
 
 //==============================================================================
 /**
 */
-class Hw5AudioProcessor  : public juce::AudioProcessor
+class Hw5AudioProcessor  : public juce::AudioProcessor,
+                           private MemoryAccounting::Client,
+                           private juce::Timer
 {
 public:
     //==============================================================================
@@ -31,8 +37,22 @@ public:
     
     void loadAudioFile(const juce::File& audioFile);
 
+    /**
+     * Starts loading an impulse response for the convolution stage in the
+     * background. Called from the message thread.
+     */
+    void loadImpulseResponse(const juce::File& file) { convolutionStage.loadImpulseResponse(file); }
+
+    /**
+     * Names the impulse response in use and gives its length, or returns an
+     * empty string if none has been chosen. Message thread only.
+     */
+    juce::String getImpulseResponseSummary() const;
+
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -59,6 +79,135 @@ public:
     
     juce::AudioProcessorValueTreeState& getAPVTS() { return apvts; }
 
+    /**
+     * Returns the peak pyramid of the most recently loaded source, or nullptr if
+     * none has been built yet. Message thread only.
+     */
+    PeakPyramid::Ptr getPeakPyramid() const;
+
+    /**
+     * Returns true once the pitch marks of the most recently loaded source have
+     * been found, which happens after its peak pyramid is built. Message thread
+     * only.
+     */
+    bool isSourceAnalysed() const;
+
+    /**
+     * Describes how the most recently loaded source is stored: its format, size
+     * and, for compact formats, the error measured against float storage. Empty
+     * if nothing has been loaded. Message thread only.
+     */
+    juce::String getSourceStorageSummary() const;
+
+    /**
+     * Returns the process-wide totals of locked and huge-page memory, and the
+     * last reason locking fell back. Safe to call from any thread.
+     */
+    ResidentMemory::Report getMemoryResidencyReport() const { return ResidentMemory::getReport(); }
+
+    /**
+     * Returns the queue of grain spawn events coming from the audio thread.
+     * Only the editor may pop from it.
+     */
+    GrainActivityFifo& getGrainActivity() { return granSynth.getGrainActivity(); }
+
+    /**
+     * Returns a snapshot of the CPU-budget governor for monitoring. Safe to call
+     * from any thread.
+     */
+    CpuGovernor::State getGovernorState() const { return granSynth.getGovernor().getState(); }
+
+    /**
+     * Reseeds grain placement so that renders are reproducible. Call before playback.
+     */
+    void setRandomSeed(juce::int64 seed) { granSynth.setRandomSeed(seed); }
+
+    /**
+     * Renders the current cloud into a loop in the background, which plays instead
+     * of live grains until a parameter moves. Called from the message thread.
+     *
+     * @return  False if there is nothing to bake: no file, or live input is on.
+     */
+    bool bakeCloud();
+
+    bool isBakingCloud() const { return granSynth.isBaking(); }
+    bool isPlayingBakedCloud() const { return granSynth.isPlayingBakedCloud(); }
+
+    /**
+     * Stops every playing grain at the start of the next block. Called from the message thread.
+     */
+    void panic() { granSynth.panic(); }
+
+    /**
+     * Returns the number of bytes of decoded audio shared by all instances in the process.
+     */
+    juce::int64 getSamplePoolBytes() const { return granSynth.getSamplePool().getTotalBytes(); }
+
+    /**
+     * Returns the audio format manager shared by all instances in the process.
+     */
+    juce::AudioFormatManager& getFormatManager() { return granSynth.getSamplePool().getFormatManager(); }
+
+    /**
+     * Returns the rendered grain cache's hit, miss and fill counters.
+     */
+    RenderedGrainCache::Stats getGrainCacheStats() const { return granSynth.getGrainCacheStats(); }
+
+    /**
+     * Starts recording audio-thread activity to a Chrome trace-event JSON file,
+     * which can be opened in Perfetto. Called from the message thread.
+     *
+     * @param file  The file to write.
+     * @return      False if the file could not be opened.
+     */
+    bool startTrace(const juce::File& file) { return granSynth.getTracer().start(file); }
+
+    /**
+     * Stops recording audio-thread activity and closes the trace file.
+     */
+    void stopTrace() { granSynth.getTracer().stop(); }
+
+    bool isTracing() { return granSynth.getTracer().isRecording(); }
+
+    /**
+     * Starts recording the plugin's output to a WAV file. Called from the message thread.
+     *
+     * @param file         The file to write.
+     * @param useAsSource  Granulate the recording once it stops.
+     * @return             False if the file could not be opened.
+     */
+    bool startRecording(const juce::File& file, bool useAsSource);
+
+    /**
+     * Stops recording and, if asked when it started, swaps the recording in as
+     * the engine's source. Called from the message thread.
+     */
+    void stopRecording();
+
+    bool isRecording() const { return outputRecorder.isRecording(); }
+
+    /**
+     * Returns the output recorder, for monitoring its progress.
+     */
+    const OutputRecorder& getOutputRecorder() const { return outputRecorder; }
+
+    /**
+     * Returns the memory this instance holds, by category, counting its source
+     * even when other instances share it. Message thread only.
+     */
+    MemoryAccounting::Usage getInstanceMemoryUsage() const { return getMemoryUsage(true); }
+
+    /**
+     * Returns the memory held by every instance in the process, counting shared
+     * sources once. Message thread only.
+     */
+    MemoryAccounting::Usage getProcessMemoryUsage() const { return memoryAccounting->getProcessUsage(); }
+
+    /**
+     * Returns the process-wide memory budget in force, or 0 for none. Message thread only.
+     */
+    juce::int64 getProcessMemoryBudget() const { return memoryAccounting->getBudget(); }
+
 
 private:
     //==============================================================================
@@ -66,6 +215,64 @@ private:
     juce::AudioProcessorValueTreeState apvts;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
     void updateGrainParameters();
+
+    /**
+     * Passes the grain parameters to an engine: the live one, or one baking a cloud.
+     * Reads only the parameters' atomics, so it is safe on any thread.
+     */
+    void applyGrainParameters(GranSynth& synth) const;
+
+    static constexpr double bakeSeconds = 4.0;      // Length of a baked cloud loop
+
+    /**
+     * Passes the memory locking and huge page parameters to the engine. They take
+     * effect for the next source loaded and the next time the cache is prepared.
+     */
+    void updateMemoryResidency();
+
+    /**
+     * Sends the CPU budget parameter to the engine's governor when it changes.
+     * The settings go through the engine's command queue, which only the message
+     * thread may push to, so this polls rather than running in processBlock.
+     */
+    void timerCallback() override;
+
+    int sentCpuBudget = -1;                         // Percent last sent to the governor; message thread only
+
+    /**
+     * Makes a newly loaded or recorded source the one reported to the editor,
+     * and builds its waveform summary in the background.
+     */
+    void showSource(const SourceBuffer::Ptr& source);
+
+    /**
+     * Shared implementation of the float and double processBlock overloads.
+     */
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+
+    // MemoryAccounting::Client
+    MemoryAccounting::Usage getMemoryUsage(bool includePooled) const override;
+    juce::int64 evict(MemoryAccounting::Eviction eviction) override;
+    juce::int64 getMemoryBudget() const override;
+    void finishEvictions() override { granSynth.finishGrainCacheEviction(); }
+
+    /**
+     * Reloads the current file at its own sample rate if the pool converted it up
+     * to the engine rate, which grains can correct for as they read.
+     *
+     * @return  The bytes saved, roughly.
+     */
+    juce::int64 reloadAtFileRate();
+
+    PeakPyramid::Ptr peakPyramid;               // Waveform summary of the current source
+    SourceBuffer::Ptr loadedSource;             // The most recently loaded source, for reporting
+    juce::File loadedFile;                      // The file loadedSource came from, if any; message thread only
+    juce::CriticalSection peakPyramidLock;      // Guards peakPyramid and loadedSource; never taken by the audio thread
+    std::unique_ptr<juce::ThreadPool> backgroundPool;   // Runs analysis jobs off the message and audio threads; started by the first load
+    OutputRecorder outputRecorder;              // Records the output to disk, and optionally back into a source
+    ConvolutionStage convolutionStage;          // Optional reverb after the grain engine
+    juce::SharedResourcePointer<MemoryAccounting> memoryAccounting;     // Process-wide memory totals and budget
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Hw5AudioProcessor)
 };
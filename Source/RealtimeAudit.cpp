@@ -0,0 +1,389 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.cpp
+    Created: 18 Oct 2026 8:41:05pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "RealtimeAudit.h"
+
+#if HW5_RT_AUDIT
+
+#if JUCE_LINUX && defined(__GLIBC__)
+ #define HW5_RT_AUDIT_HOOK_LIBC 1
+ #include <dlfcn.h>
+ #include <pthread.h>
+
+ extern "C"
+ {
+     void* __libc_malloc(size_t);
+     void* __libc_calloc(size_t, size_t);
+     void* __libc_realloc(void*, size_t);
+     void __libc_free(void*);
+ }
+#else
+ #define HW5_RT_AUDIT_HOOK_LIBC 0
+#endif
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <execinfo.h>
+#endif
+
+namespace
+{
+    struct Record
+    {
+        RealtimeAudit::ViolationType type;
+        size_t size;
+        int numFrames;
+        void* frames[RealtimeAudit::maxFrames];
+    };
+
+    // Plain arrays and atomics are constant-initialised, so the hooks can use
+    // them even while other static constructors are still running
+    Record records[RealtimeAudit::maxRecorded];
+    std::atomic<int> numViolations { 0 };
+
+    // Initial-exec TLS never allocates on first access, which would recurse into the hooks
+   #if JUCE_LINUX
+    [[gnu::tls_model("initial-exec")]] thread_local int realtimeDepth = 0;
+    [[gnu::tls_model("initial-exec")]] thread_local bool insideHook = false;
+   #else
+    thread_local int realtimeDepth = 0;
+    thread_local bool insideHook = false;
+   #endif
+
+    void* untrackedMalloc(size_t size)
+    {
+       #if HW5_RT_AUDIT_HOOK_LIBC
+        return __libc_malloc(size);
+       #else
+        return std::malloc(size);
+       #endif
+    }
+
+    void untrackedFree(void* pointer)
+    {
+       #if HW5_RT_AUDIT_HOOK_LIBC
+        __libc_free(pointer);
+       #else
+        std::free(pointer);
+       #endif
+    }
+
+    int captureStack(void** frames)
+    {
+       #if JUCE_LINUX || JUCE_MAC
+        return backtrace(frames, RealtimeAudit::maxFrames);
+       #else
+        juce::ignoreUnused(frames);
+        return 0;
+       #endif
+    }
+
+    const char* getTypeName(RealtimeAudit::ViolationType type)
+    {
+        switch (type)
+        {
+            case RealtimeAudit::ViolationType::operatorNew:     return "operator new";
+            case RealtimeAudit::ViolationType::operatorDelete:  return "operator delete";
+            case RealtimeAudit::ViolationType::malloc:          return "malloc";
+            case RealtimeAudit::ViolationType::free:            return "free";
+            case RealtimeAudit::ViolationType::mutexLock:       return "mutex lock";
+        }
+
+        return "unknown";
+    }
+
+   #if HW5_RT_AUDIT_HOOK_LIBC
+    using MutexLockFunction = int (*)(pthread_mutex_t*);
+    std::atomic<MutexLockFunction> nextMutexLock { nullptr };
+
+    MutexLockFunction getNextMutexLock()
+    {
+        auto function = nextMutexLock.load();
+
+        if (function == nullptr)
+        {
+            function = reinterpret_cast<MutexLockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+            nextMutexLock.store(function);
+        }
+
+        return function;
+    }
+   #endif
+
+    /** Does anything that allocates on first use before a real-time section can. */
+    struct Warmup
+    {
+        Warmup()
+        {
+            // The first backtrace() loads the unwinder, which allocates
+            void* frames[RealtimeAudit::maxFrames];
+            captureStack(frames);
+
+           #if HW5_RT_AUDIT_HOOK_LIBC
+            getNextMutexLock();
+           #endif
+        }
+    };
+
+    const Warmup warmup;
+}
+
+//==============================================================================
+RealtimeAudit::ScopedRealtimeSection::ScopedRealtimeSection() noexcept
+{
+    ++realtimeDepth;
+}
+
+RealtimeAudit::ScopedRealtimeSection::~ScopedRealtimeSection()
+{
+    --realtimeDepth;
+}
+
+void RealtimeAudit::noteCall(ViolationType type, size_t size) noexcept
+{
+    if (realtimeDepth == 0 || insideHook)
+        return;
+
+    insideHook = true;
+
+    const int index = numViolations.fetch_add(1);
+
+    if (index < maxRecorded)
+    {
+        Record& record = records[index];
+        record.type = type;
+        record.size = size;
+        record.numFrames = captureStack(record.frames);
+    }
+
+    insideHook = false;
+}
+
+int RealtimeAudit::getNumViolations()
+{
+    return numViolations.load();
+}
+
+void RealtimeAudit::reset()
+{
+    numViolations = 0;
+}
+
+juce::String RealtimeAudit::getReport()
+{
+    const int total = numViolations.load();
+    juce::String report;
+
+    report << total << " real-time violation(s)" << juce::newLine;
+
+    for (int i = 0; i < juce::jmin(total, maxRecorded); ++i)
+    {
+        const Record& record = records[i];
+
+        report << "#" << (i + 1) << ": " << getTypeName(record.type);
+
+        if (record.size > 0)
+            report << " of " << (juce::int64)record.size << " bytes";
+
+        report << juce::newLine;
+
+       #if JUCE_LINUX || JUCE_MAC
+        if (char** symbols = backtrace_symbols(record.frames, record.numFrames))
+        {
+            // Skip the audit's own frames, which may or may not have been inlined
+            int frame = 0;
+
+            while (frame < record.numFrames && (juce::String(symbols[frame]).contains("RealtimeAudit")
+                                                || juce::String(symbols[frame]).contains("captureStack")))
+                ++frame;
+
+            for (; frame < record.numFrames; ++frame)
+                report << "    " << symbols[frame] << juce::newLine;
+
+            ::free(symbols);
+        }
+       #else
+        report << "    (no stack trace on this platform)" << juce::newLine;
+       #endif
+    }
+
+    if (total > maxRecorded)
+        report << "... and " << (total - maxRecorded) << " more" << juce::newLine;
+
+    return report;
+}
+
+//==============================================================================
+// Global allocation hooks. Only the basic forms are replaced; the aligned forms
+// go through aligned_alloc or posix_memalign, which the libc hooks do not see.
+void* operator new(std::size_t size)
+{
+    RealtimeAudit::noteCall(RealtimeAudit::ViolationType::operatorNew, size);
+
+    if (void* pointer = untrackedMalloc(size > 0 ? size : 1))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    RealtimeAudit::noteCall(RealtimeAudit::ViolationType::operatorNew, size);
+    return untrackedMalloc(size > 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        RealtimeAudit::noteCall(RealtimeAudit::ViolationType::operatorDelete, 0);
+
+    untrackedFree(pointer);
+}
+
+void operator delete[](void* pointer) noexcept                          { operator delete(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept               { operator delete(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept             { operator delete(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept     { operator delete(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept   { operator delete(pointer); }
+
+#if HW5_RT_AUDIT_HOOK_LIBC
+extern "C"
+{
+    void* malloc(size_t size) noexcept
+    {
+        RealtimeAudit::noteCall(RealtimeAudit::ViolationType::malloc, size);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        RealtimeAudit::noteCall(RealtimeAudit::ViolationType::malloc, count * size);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size) noexcept
+    {
+        RealtimeAudit::noteCall(RealtimeAudit::ViolationType::malloc, size);
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer) noexcept
+    {
+        if (pointer != nullptr)
+            RealtimeAudit::noteCall(RealtimeAudit::ViolationType::free, 0);
+
+        __libc_free(pointer);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+    {
+        RealtimeAudit::noteCall(RealtimeAudit::ViolationType::mutexLock, 0);
+        return getNextMutexLock()(mutex);
+    }
+}
+#endif
+
+#else
+
+void RealtimeAudit::noteCall(ViolationType, size_t) noexcept {}
+int RealtimeAudit::getNumViolations()                       { return 0; }
+void RealtimeAudit::reset()                                 {}
+juce::String RealtimeAudit::getReport()                     { return "Real-time audit is disabled in this build"; }
+
+#endif
+
+//==============================================================================
+namespace
+{
+    template <typename SampleType>
+    void renderSweepBlocks(juce::AudioProcessor& processor, double sampleRate, int blockSize, int numBlocks)
+    {
+        juce::AudioBuffer<SampleType> buffer(juce::jmax(processor.getTotalNumInputChannels(),
+                                                        processor.getTotalNumOutputChannels()), blockSize);
+        juce::MidiBuffer midiMessages;
+
+        // A new note every 100 ms, starting mid-block so events land inside blocks
+        const int noteInterval = juce::jmax(1, (int)(sampleRate * 0.1));
+        int nextNote = blockSize / 2;
+        int noteNumber = 0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            const int blockStart = block * blockSize;
+
+            buffer.clear();
+            midiMessages.clear();
+
+            while (nextNote < blockStart + blockSize)
+            {
+                midiMessages.addEvent(juce::MidiMessage::noteOn(1, 48 + noteNumber++ % 24, 0.8f), nextNote - blockStart);
+                nextNote += noteInterval;
+            }
+
+            processor.processBlock(buffer, midiMessages);
+        }
+    }
+}
+
+int RealtimeAudit::sweepBlockSizes(juce::AudioProcessor& processor, double sampleRate, double secondsPerSize)
+{
+    static constexpr int blockSizes[] = { 1, 2, 3, 7, 16, 32, 64, 100, 128, 256, 441, 512,
+                                          1000, 1024, 2048, 4096, 5000, 8192 };
+
+    int totalViolations = 0;
+
+    for (const bool doublePrecision : { false, true })
+    {
+        if (doublePrecision && !processor.supportsDoublePrecisionProcessing())
+            continue;
+
+        processor.setProcessingPrecision(doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                         : juce::AudioProcessor::singlePrecision);
+
+        for (const int blockSize : blockSizes)
+        {
+            const int numBlocks = juce::jmax(4, (int)std::ceil(secondsPerSize * sampleRate / blockSize));
+
+            processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+            processor.prepareToPlay(sampleRate, blockSize);
+            reset();
+
+            if (doublePrecision)
+                renderSweepBlocks<double>(processor, sampleRate, blockSize, numBlocks);
+            else
+                renderSweepBlocks<float>(processor, sampleRate, blockSize, numBlocks);
+
+            const int violations = getNumViolations();
+
+            // Logged in release builds too, as the audit console app usually is one
+            if (violations > 0)
+            {
+                juce::Logger::writeToLog("Block size " + juce::String(blockSize)
+                                         + (doublePrecision ? " (double): " : " (float): ") + getReport());
+                jassertfalse;
+            }
+
+            totalViolations += violations;
+            processor.releaseResources();
+        }
+    }
+
+    processor.setProcessingPrecision(juce::AudioProcessor::singlePrecision);
+    return totalViolations;
+}
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.h
+    Created: 18 Oct 2026 8:41:05pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Set HW5_RT_AUDIT=1 in the Projucer's preprocessor definitions for a debug
+ * or test build to catch allocations and locks on the audio thread. It is off
+ * by default, and release builds must leave it off. The RealtimeAudit console
+ * app (RealtimeAudit/RealtimeAudit.jucer) is built with it on, and runs
+ * sweepBlockSizes() over a file.
+ */
+#ifndef HW5_RT_AUDIT
+ #define HW5_RT_AUDIT 0
+#endif
+
+/**
+ * Detects work the audio thread must never do: allocating, freeing and taking
+ * locks.
+ *
+ * When HW5_RT_AUDIT is enabled, the global operator new and delete are replaced.
+ * On Linux with glibc, malloc, calloc, realloc, free and pthread_mutex_lock are
+ * hooked as well. Hooks only report calls made on a thread that is inside a
+ * ScopedRealtimeSection, which the processor opens around processBlock, so
+ * other threads and the host are unaffected.
+ *
+ * Each violation is counted. The first maxRecorded are kept with a stack trace
+ * captured into preallocated storage, so recording one never allocates itself.
+ * Call getReport() afterwards, off the audio thread, to symbolise them.
+ *
+ * When HW5_RT_AUDIT is disabled, the section is empty and nothing is hooked.
+ */
+class RealtimeAudit
+{
+public:
+    static constexpr int maxRecorded = 64;  // Violations kept with a stack trace
+    static constexpr int maxFrames = 32;    // Stack frames kept per violation
+
+    enum class ViolationType
+    {
+        operatorNew = 0,
+        operatorDelete,
+        malloc,
+        free,
+        mutexLock
+    };
+
+    /**
+     * Marks the current thread as real-time for the lifetime of the object.
+     * Sections may nest.
+     */
+    class ScopedRealtimeSection
+    {
+    public:
+       #if HW5_RT_AUDIT
+        ScopedRealtimeSection() noexcept;
+        ~ScopedRealtimeSection();
+       #else
+        ScopedRealtimeSection() noexcept {}
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeSection)
+    };
+
+    /**
+     * Returns true if this build has the hooks installed.
+     */
+    static constexpr bool isEnabled() { return HW5_RT_AUDIT != 0; }
+
+    /**
+     * Returns the number of violations since the last reset.
+     */
+    static int getNumViolations();
+
+    /**
+     * Forgets every violation seen so far.
+     */
+    static void reset();
+
+    /**
+     * Describes the recorded violations with symbolised stack traces. Allocates,
+     * so never call it from the audio thread.
+     */
+    static juce::String getReport();
+
+    /**
+     * Renders through the processor at block sizes from 1 to 8192 samples, in
+     * single and (where supported) double precision, playing notes throughout,
+     * and counts the violations at each size. Call from the message thread with
+     * a source loaded and the processor not attached to a device. Resources are
+     * released again afterwards.
+     *
+     * @param processor       The processor to exercise.
+     * @param sampleRate      The sample rate to prepare at.
+     * @param secondsPerSize  How much audio to render at each block size.
+     * @return                The total number of violations. Each size with any
+     *                        is logged with its report, and asserts in debug builds.
+     */
+    static int sweepBlockSizes(juce::AudioProcessor& processor, double sampleRate, double secondsPerSize = 1.0);
+
+    /**
+     * Called by the hooks. Records a violation if the calling thread is inside a
+     * ScopedRealtimeSection.
+     */
+    static void noteCall(ViolationType type, size_t size) noexcept;
+
+private:
+    RealtimeAudit() = delete;
+};
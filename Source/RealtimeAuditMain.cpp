@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    RealtimeAuditMain.cpp
+    Created: 18 Oct 2026 8:41:05pm
+    Author:  David Matthew Welch
+
+    Entry point of the RealtimeAudit console app (RealtimeAudit/RealtimeAudit.jucer),
+    which is built with HW5_RT_AUDIT=1. Loads a file into the processor, sweeps
+    it through every block size and exits with 1 if the audio thread allocated,
+    freed or locked at any of them.
+
+  ==============================================================================
+*/
+
+// The processor and editor are compiled here rather than as files of their own,
+// so they see the same plugin definitions (name, MIDI, buses) as in the plugin
+#include "../JuceLibraryCode/JucePluginDefines.h"
+#include <JuceHeader.h>
+#include <iostream>
+#include "PluginProcessor.cpp"
+#include "PluginEditor.cpp"
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: RealtimeAudit <audio file> [seconds per block size]" << std::endl;
+        return 1;
+    }
+
+    if (!RealtimeAudit::isEnabled())
+    {
+        std::cerr << "This build doesn't define HW5_RT_AUDIT=1, so nothing would be caught" << std::endl;
+        return 1;
+    }
+
+    // The processor's parameters and background jobs need a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    constexpr double sampleRate = 48000.0;
+    constexpr int preparedBlockSize = 512;
+    constexpr double loadTimeoutMs = 60000.0;
+
+    const juce::File audioFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[1]);
+    const double secondsPerSize = argc > 2 ? juce::jmax(0.1, juce::String(argv[2]).getDoubleValue()) : 1.0;
+
+    Hw5AudioProcessor processor;
+
+    // Prepared first, so the file is converted to the rate the sweep runs at
+    processor.setRateAndBufferSizeDetails(sampleRate, preparedBlockSize);
+    processor.prepareToPlay(sampleRate, preparedBlockSize);
+    processor.loadAudioFile(audioFile);
+
+    // The waveform summary is built once the whole file has been decoded
+    const double loadStart = juce::Time::getMillisecondCounterHiRes();
+
+    while (processor.getPeakPyramid() == nullptr)
+    {
+        if (juce::Time::getMillisecondCounterHiRes() - loadStart > loadTimeoutMs)
+        {
+            std::cerr << "Can't load " << audioFile.getFullPathName().toRawUTF8() << std::endl;
+            return 1;
+        }
+
+        juce::Thread::sleep(10);
+    }
+
+    processor.releaseResources();
+
+    const int violations = RealtimeAudit::sweepBlockSizes(processor, sampleRate, secondsPerSize);
+
+    std::cout << violations << " real-time violations across the block size sweep" << std::endl;
+    return violations == 0 ? 0 : 1;
+}
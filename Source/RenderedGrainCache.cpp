@@ -0,0 +1,304 @@
+/*
+  ==============================================================================
+
+    RenderedGrainCache.cpp
+    Created: 18 Oct 2026 5:02:19pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "RenderedGrainCache.h"
+#include "Grain.h"
+
+/**
+ * One cached grain. The fill thread only rewrites a slot after marking it as
+ * filling and seeing that no handle holds it; the audio thread only takes a
+ * handle after registering as a user and seeing that the slot is still ready.
+ * Whichever side comes second backs off, so neither ever waits.
+ */
+struct RenderedGrainCache::Slot
+{
+    enum State
+    {
+        empty = 0,
+        filling,
+        ready
+    };
+
+    std::atomic<int> state { empty };
+    std::atomic<int> users { 0 };               // Handles currently playing this slot
+    std::atomic<juce::uint64> keyHash { 0 };    // Lets lookups skip slots without touching users
+    std::atomic<juce::uint32> lastUsed { 0 };
+
+    Key key;                            // Only written while filling
+    int length = 0;
+    int numChannels = 0;
+    juce::AudioBuffer<float> audio;
+};
+
+//==============================================================================
+bool RenderedGrainCache::Key::operator==(const Key& other) const
+{
+    return generation == other.generation && startSample == other.startSample && grainSize == other.grainSize
+        && pitchCents == other.pitchCents && window == other.window && interpolation == other.interpolation
+        && numChannels == other.numChannels && reverse == other.reverse;
+}
+
+juce::uint64 RenderedGrainCache::Key::hash() const
+{
+    // FNV-1a over the fields
+    juce::uint64 result = 14695981039346656037ull;
+
+    const auto mix = [&result](juce::uint64 value)
+    {
+        result ^= value;
+        result *= 1099511628211ull;
+    };
+
+    mix(generation);
+    mix((juce::uint32)startSample);
+    mix((juce::uint32)grainSize);
+    mix((juce::uint32)pitchCents);
+    mix(((juce::uint64)window << 24) | ((juce::uint64)interpolation << 16) | ((juce::uint64)numChannels << 8) | (reverse ? 1u : 0u));
+
+    return result;
+}
+
+//==============================================================================
+RenderedGrainCache::Handle::Handle(Handle&& other) noexcept
+    : slot(other.slot)
+{
+    other.slot = nullptr;
+}
+
+RenderedGrainCache::Handle& RenderedGrainCache::Handle::operator=(Handle&& other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        slot = other.slot;
+        other.slot = nullptr;
+    }
+
+    return *this;
+}
+
+RenderedGrainCache::Handle::~Handle()
+{
+    reset();
+}
+
+void RenderedGrainCache::Handle::reset()
+{
+    if (slot != nullptr)
+        slot->users.fetch_sub(1);
+
+    slot = nullptr;
+}
+
+int RenderedGrainCache::Handle::getLength() const
+{
+    return slot != nullptr ? slot->length : 0;
+}
+
+int RenderedGrainCache::Handle::getNumChannels() const
+{
+    return slot != nullptr ? slot->numChannels : 0;
+}
+
+const float* RenderedGrainCache::Handle::getChannel(int channel) const
+{
+    return slot->audio.getReadPointer(juce::jmin(channel, slot->numChannels - 1));
+}
+
+//==============================================================================
+RenderedGrainCache::RenderedGrainCache()
+    : juce::Thread("Grain cache")
+{
+}
+
+RenderedGrainCache::~RenderedGrainCache()
+{
+    release();
+}
+
+void RenderedGrainCache::prepare(const ResidentMemory::Options& residency)
+{
+    release();
+
+    // Every slot's audio lives in one block, so it can be locked in one go
+    slotMemory.allocate((size_t)numSlots * 2 * maxGrainLength * sizeof(float), residency);
+    slots.reset(new Slot[numSlots]);
+
+    for (int i = 0; i < numSlots; ++i)
+    {
+        float* slotAudio = static_cast<float*>(slotMemory.getData()) + (size_t)i * 2 * maxGrainLength;
+        float* channels[] = { slotAudio, slotAudio + maxGrainLength };
+        slots[(size_t)i].audio.setDataToReferTo(channels, 2, maxGrainLength);
+    }
+
+    startThread(juce::Thread::Priority::low);
+}
+
+void RenderedGrainCache::release()
+{
+    stopThread(1000);
+
+    requestFifo.reset();
+
+    for (auto& pending : requests)
+        pending.source = nullptr;
+
+    slots.reset();
+    slotMemory.free();
+    hits = 0;
+    misses = 0;
+    fills = 0;
+}
+
+RenderedGrainCache::Handle RenderedGrainCache::find(const Key& key)
+{
+    if (slots == nullptr)
+        return {};
+
+    const juce::uint64 keyHash = key.hash();
+
+    for (int i = 0; i < numSlots; ++i)
+    {
+        Slot& slot = slots[(size_t)i];
+
+        if (slot.keyHash.load() != keyHash || slot.state.load() != Slot::ready)
+            continue;
+
+        slot.users.fetch_add(1);
+
+        if (slot.state.load() == Slot::ready && slot.key == key)
+        {
+            slot.lastUsed.store(useCounter.fetch_add(1) + 1);
+            hits.fetch_add(1);
+            return Handle(&slot);
+        }
+
+        slot.users.fetch_sub(1);
+    }
+
+    misses.fetch_add(1);
+    return {};
+}
+
+void RenderedGrainCache::request(const Key& key, const SourceBuffer::Ptr& source, const GrainRenderSettings& settings,
+                                 float pitchShiftFactor)
+{
+    if (slots == nullptr || source == nullptr)
+        return;
+
+    const auto scope = requestFifo.write(1);
+    Request* pending = nullptr;
+
+    if (scope.blockSize1 > 0)
+        pending = &requests[(size_t)scope.startIndex1];
+    else if (scope.blockSize2 > 0)
+        pending = &requests[(size_t)scope.startIndex2];
+    else
+        return;
+
+    // The fill thread clears each request's source after rendering it, so this
+    // never drops the last reference to a source on the audio thread
+    pending->key = key;
+    pending->source = source;
+    pending->settings = settings;
+    pending->pitchShiftFactor = pitchShiftFactor;
+}
+
+RenderedGrainCache::Stats RenderedGrainCache::getStats() const
+{
+    Stats stats;
+    stats.hits = hits.load();
+    stats.misses = misses.load();
+    stats.fills = fills.load();
+    return stats;
+}
+
+void RenderedGrainCache::run()
+{
+    while (!threadShouldExit())
+    {
+        while (requestFifo.getNumReady() > 0 && !threadShouldExit())
+        {
+            const auto scope = requestFifo.read(1);
+
+            Request& pending = requests[(size_t)(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+            fill(pending);
+            pending.source = nullptr;
+        }
+
+        wait(5);
+    }
+}
+
+void RenderedGrainCache::fill(Request& pending)
+{
+    const Key& key = pending.key;
+
+    // The same grain is often requested several times before it is first rendered
+    for (int i = 0; i < numSlots; ++i)
+        if (slots[(size_t)i].state.load() == Slot::ready && slots[(size_t)i].key == key)
+            return;
+
+    const int length = Grain::getOutputLength(key.grainSize, pending.pitchShiftFactor);
+
+    if (length > maxGrainLength || pending.source->getNumSamples() == 0 || !pending.source->isFullyLoaded())
+        return;
+
+    // Prefer empty or stale slots, otherwise evict the least recently used one
+    const juce::uint32 currentGeneration = generation.load();
+    Slot* victim = nullptr;
+
+    for (int i = 0; i < numSlots; ++i)
+    {
+        Slot& slot = slots[(size_t)i];
+
+        if (slot.users.load() != 0)
+            continue;
+
+        if (slot.state.load() == Slot::empty || slot.key.generation != currentGeneration)
+        {
+            victim = &slot;
+            break;
+        }
+
+        if (victim == nullptr || slot.lastUsed.load() < victim->lastUsed.load())
+            victim = &slot;
+    }
+
+    if (victim == nullptr)
+        return;
+
+    const int previousState = victim->state.exchange(Slot::filling);
+
+    if (victim->users.load() != 0)
+    {
+        // A grain picked it up in the meantime, so leave it be
+        victim->state.store(previousState);
+        return;
+    }
+
+    // Render with the same code a live grain would use, so hits sound identical
+    const GrainSource source = pending.source->getGrainSource();
+
+    victim->numChannels = juce::jlimit(1, 2, pending.settings.numChannels);
+    juce::AudioBuffer<float> target(victim->audio.getArrayOfWritePointers(), victim->numChannels, length);
+    target.clear();
+
+    Grain grain(key.startSample, key.grainSize, pending.pitchShiftFactor, source.numSamples, pending.settings);
+    grain.processGrain(source, target, 0, length);
+
+    victim->key = key;
+    victim->length = length;
+    victim->lastUsed.store(useCounter.load());
+    victim->keyHash.store(key.hash());
+    victim->state.store(Slot::ready);
+
+    fills.fetch_add(1);
+}
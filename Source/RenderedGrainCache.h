@@ -0,0 +1,180 @@
+/*
+  ==============================================================================
+
+    RenderedGrainCache.h
+    Created: 18 Oct 2026 5:02:19pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GrainKernels.h"
+#include "SourceBuffer.h"
+
+/**
+ * A bounded, least-recently-used cache of fully rendered grains.
+ *
+ * When patches keep spawning the same grain (same position, size, window, pitch
+ * and direction), the audio thread can mix a cached copy instead of running the
+ * render kernel again. Misses are queued and rendered on the cache's own thread,
+ * so the audio thread never renders on behalf of the cache and never waits for it.
+ *
+ * Thread ownership:
+ *  - find(), request() and invalidate() are called from the audio thread only,
+ *    and never lock or allocate.
+ *  - prepare() and release() are called from the message thread while the audio
+ *    thread is stopped.
+ *  - getStats() may be called from any thread.
+ */
+class RenderedGrainCache : private juce::Thread
+{
+    struct Slot;
+
+public:
+    static constexpr int numSlots = 64;                 // Grains held at once
+    static constexpr int maxGrainLength = 8192;         // Longest grain, in output samples, that will be cached
+    static constexpr int positionQuantum = 64;          // Start positions are snapped to this grid when caching
+    static constexpr int maxPendingRequests = 64;
+
+    /** Identifies a rendered grain. */
+    struct Key
+    {
+        juce::uint32 generation = 0;    // Bumped whenever the source changes
+        int startSample = 0;
+        int grainSize = 0;
+        int pitchCents = 0;             // Pitch ratio, quantised to hundredths of a cent
+        juce::uint8 window = 0;
+        juce::uint8 interpolation = 0;
+        juce::uint8 numChannels = 0;
+        bool reverse = false;
+
+        bool operator==(const Key& other) const;
+        juce::uint64 hash() const;
+    };
+
+    /** Counters for monitoring. */
+    struct Stats
+    {
+        int hits = 0;
+        int misses = 0;
+        int fills = 0;      // Grains rendered into the cache
+    };
+
+    /**
+     * Keeps a cached grain's audio alive while a grain plays it. Releasing the
+     * last handle to a slot makes it eligible for eviction again.
+     */
+    class Handle
+    {
+    public:
+        Handle() = default;
+        Handle(Handle&& other) noexcept;
+        Handle& operator=(Handle&& other) noexcept;
+        ~Handle();
+
+        bool isValid() const { return slot != nullptr; }
+        int getLength() const;
+        int getNumChannels() const;
+        const float* getChannel(int channel) const;
+
+    private:
+        friend class RenderedGrainCache;
+        Slot* slot = nullptr;
+
+        explicit Handle(Slot* slotToHold) : slot(slotToHold) {}
+        void reset();
+
+        JUCE_DECLARE_NON_COPYABLE (Handle)
+    };
+
+    /**
+     * Constructor for the RenderedGrainCache class.
+     */
+    RenderedGrainCache();
+
+    /**
+     * Destructor for the RenderedGrainCache class. Stops the fill thread.
+     */
+    ~RenderedGrainCache() override;
+
+    /**
+     * Allocates the slots and starts the fill thread.
+     *
+     * @param residency  Whether to prefault and lock the slots' audio, and back it with huge pages.
+     */
+    void prepare(const ResidentMemory::Options& residency = {});
+
+    /**
+     * Stops the fill thread and empties the cache.
+     */
+    void release();
+
+    /**
+     * Makes every cached grain stale, e.g. when the source changes. Stale slots are
+     * reused as they fall out of use.
+     */
+    void invalidate() { generation.fetch_add(1); }
+
+    /**
+     * Returns the generation new keys should use.
+     */
+    juce::uint32 getGeneration() const { return generation.load(); }
+
+    /**
+     * Looks up a rendered grain. A hit is returned as a valid handle.
+     */
+    Handle find(const Key& key);
+
+    /**
+     * Asks the fill thread to render a grain. Dropped silently if the queue is full.
+     *
+     * @param key               The key the grain will be stored under.
+     * @param source            The source to render from; kept alive until rendered.
+     * @param settings          The kernel settings, matching the key.
+     * @param pitchShiftFactor  The exact pitch shift factor.
+     */
+    void request(const Key& key, const SourceBuffer::Ptr& source, const GrainRenderSettings& settings,
+                 float pitchShiftFactor);
+
+    /**
+     * Returns a snapshot of the hit, miss and fill counters.
+     */
+    Stats getStats() const;
+
+    /**
+     * Returns the memory held for the slots' audio. Message thread only.
+     */
+    juce::int64 getSizeInBytes() const { return (juce::int64)slotMemory.getSize(); }
+
+private:
+    struct Request
+    {
+        Key key;
+        SourceBuffer::Ptr source;
+        GrainRenderSettings settings;
+        float pitchShiftFactor = 1.0f;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    ResidentMemory slotMemory;                      // Audio of every slot
+    std::array<Request, maxPendingRequests> requests;
+    juce::AbstractFifo requestFifo { maxPendingRequests };
+
+    std::atomic<juce::uint32> generation { 0 };
+    std::atomic<juce::uint32> useCounter { 0 };    // Stamps slots with their last use for LRU eviction
+    std::atomic<int> hits { 0 };
+    std::atomic<int> misses { 0 };
+    std::atomic<int> fills { 0 };
+
+    void run() override;
+
+    /**
+     * Renders one queued grain into the least recently used free slot.
+     */
+    void fill(Request& request);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderedGrainCache)
+};
@@ -0,0 +1,230 @@
+/*
+  ==============================================================================
+
+    ResidentMemory.cpp
+    Created: 18 Oct 2026 10:47:16pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "ResidentMemory.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/mman.h>
+ #include <sys/resource.h>
+ #include <unistd.h>
+ #include <cerrno>
+ #define HW5_CAN_LOCK_MEMORY 1
+#else
+ #define HW5_CAN_LOCK_MEMORY 0
+#endif
+
+namespace
+{
+    constexpr size_t hugePageSize = 2 * 1024 * 1024;
+
+    std::atomic<juce::int64> totalLocked { 0 };
+    std::atomic<juce::int64> totalUnlocked { 0 };
+    std::atomic<juce::int64> totalHugePages { 0 };
+    std::atomic<int> numLockFailures { 0 };
+
+    juce::SpinLock lastProblemLock;
+    juce::String lastProblem;
+
+    size_t getPageSize()
+    {
+       #if HW5_CAN_LOCK_MEMORY
+        static const size_t pageSize = (size_t)juce::jmax(4096L, sysconf(_SC_PAGESIZE));
+        return pageSize;
+       #else
+        return 4096;
+       #endif
+    }
+
+    size_t roundUp(size_t value, size_t multiple)
+    {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    juce::int64 getLockLimit()
+    {
+       #if HW5_CAN_LOCK_MEMORY
+        struct rlimit limit;
+
+        if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+            return (juce::int64)limit.rlim_cur;
+       #endif
+
+        return -1;
+    }
+
+    void noteProblem(const juce::String& problem)
+    {
+        DBG(problem);
+
+        const juce::SpinLock::ScopedLockType scopedLock(lastProblemLock);
+        lastProblem = problem;
+    }
+}
+
+//==============================================================================
+ResidentMemory::~ResidentMemory()
+{
+    free();
+}
+
+const ResidentMemory::Outcome& ResidentMemory::allocate(size_t numBytes, const Options& options)
+{
+    free();
+
+    outcome = {};
+
+    if (numBytes == 0)
+        return outcome;
+
+    const bool useHugePages = options.useHugePages && numBytes >= hugePageSize;
+    const size_t alignment = useHugePages ? hugePageSize : getPageSize();
+    allocatedSize = roundUp(numBytes, alignment);
+
+    if (!options.lockInMemory && !useHugePages)
+    {
+        // Zero pages are mapped lazily, so nothing is touched until it's written
+        data = std::calloc(allocatedSize, 1);
+    }
+    else
+    {
+       #if HW5_CAN_LOCK_MEMORY
+        if (posix_memalign(&data, alignment, allocatedSize) != 0)
+            data = nullptr;
+       #else
+        data = std::calloc(allocatedSize, 1);
+       #endif
+    }
+
+    if (data == nullptr)
+    {
+        allocatedSize = 0;
+        throw std::bad_alloc();
+    }
+
+    size = numBytes;
+
+    if (!options.lockInMemory && !useHugePages)
+        return outcome;
+
+   #if JUCE_LINUX && defined(MADV_HUGEPAGE)
+    if (useHugePages)
+    {
+        // Must come before the pages are first touched
+        if (madvise(data, allocatedSize, MADV_HUGEPAGE) == 0)
+        {
+            outcome.hugePages = true;
+            totalHugePages += (juce::int64)allocatedSize;
+        }
+        else
+        {
+            outcome.problem = "Transparent huge pages are unavailable (" + juce::String(std::strerror(errno)) + ")";
+            noteProblem(outcome.problem);
+        }
+    }
+   #else
+    if (options.useHugePages)
+        outcome.problem = "Huge pages are not supported on this platform";
+   #endif
+
+    // Writing every page faults it in now, rather than on the audio thread later
+    std::memset(data, 0, allocatedSize);
+    outcome.prefaulted = true;
+
+    if (!options.lockInMemory)
+        return outcome;
+
+   #if HW5_CAN_LOCK_MEMORY
+    if (mlock(data, allocatedSize) == 0)
+    {
+        outcome.locked = true;
+        totalLocked += (juce::int64)allocatedSize;
+        return outcome;
+    }
+
+    const int lockError = errno;
+    const juce::int64 limit = getLockLimit();
+
+    outcome.problem = "Couldn't lock " + juce::File::descriptionOfSizeInBytes((juce::int64)allocatedSize)
+                    + " (" + juce::String(std::strerror(lockError)) + ")";
+
+    if ((lockError == ENOMEM || lockError == EPERM) && limit >= 0)
+        outcome.problem << "; the lock limit is " << juce::File::descriptionOfSizeInBytes(limit)
+                        << ", raise it with ulimit -l or memlock in /etc/security/limits.conf";
+   #else
+    outcome.problem = "Locking memory is not supported on this platform";
+   #endif
+
+    lockFailed = true;
+    totalUnlocked += (juce::int64)allocatedSize;
+    numLockFailures.fetch_add(1);
+    noteProblem(outcome.problem);
+
+    return outcome;
+}
+
+void ResidentMemory::free()
+{
+    if (data == nullptr)
+        return;
+
+   #if HW5_CAN_LOCK_MEMORY
+    if (outcome.locked)
+        munlock(data, allocatedSize);
+   #endif
+
+    if (outcome.locked)
+        totalLocked -= (juce::int64)allocatedSize;
+
+    if (lockFailed)
+        totalUnlocked -= (juce::int64)allocatedSize;
+
+    if (outcome.hugePages)
+        totalHugePages -= (juce::int64)allocatedSize;
+
+    std::free(data);
+
+    data = nullptr;
+    size = 0;
+    allocatedSize = 0;
+    lockFailed = false;
+    outcome = {};
+}
+
+//==============================================================================
+ResidentMemory::Report ResidentMemory::getReport()
+{
+    Report report;
+    report.lockedBytes = totalLocked.load();
+    report.unlockedBytes = totalUnlocked.load();
+    report.hugePageBytes = totalHugePages.load();
+    report.lockLimit = getLockLimit();
+    report.numLockFailures = numLockFailures.load();
+
+    const juce::SpinLock::ScopedLockType scopedLock(lastProblemLock);
+    report.lastProblem = lastProblem;
+
+    return report;
+}
+
+juce::String ResidentMemory::Report::toString() const
+{
+    juce::String summary = "Locked " + juce::File::descriptionOfSizeInBytes(lockedBytes);
+
+    if (lockLimit >= 0)
+        summary << " of " << juce::File::descriptionOfSizeInBytes(lockLimit);
+
+    if (hugePageBytes > 0)
+        summary << ", " << juce::File::descriptionOfSizeInBytes(hugePageBytes) << " huge pages";
+
+    if (unlockedBytes > 0)
+        summary << ", " << juce::File::descriptionOfSizeInBytes(unlockedBytes) << " unlocked";
+
+    return summary;
+}
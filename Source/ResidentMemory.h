@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    ResidentMemory.h
+    Created: 18 Oct 2026 10:47:16pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * An owned block of zeroed memory that can be kept resident, so the audio
+ * thread never takes a page fault reading it.
+ *
+ * With locking enabled every page is faulted in when the block is allocated
+ * and then locked with mlock(), so the OS can't swap it out later under
+ * memory pressure. If the lock fails, usually because RLIMIT_MEMLOCK is too
+ * low, the block stays prefaulted but unlocked and the failure is counted in
+ * the process-wide report. On Linux, blocks of 2 MB or more can also be
+ * aligned to and advised onto transparent huge pages, which cuts TLB misses
+ * on the random reads grains make.
+ *
+ * Locking is supported on Linux and macOS and huge pages on Linux only; on
+ * other platforms the options fall back to a plain allocation.
+ *
+ * Allocation and release may block for as long as it takes to touch every
+ * page, so never do either on the audio thread.
+ */
+class ResidentMemory
+{
+public:
+    /** How to back a block. */
+    struct Options
+    {
+        bool lockInMemory = false;  // Prefault and mlock()
+        bool useHugePages = false;  // Align to, and advise, transparent huge pages
+
+        bool operator==(const Options& other) const { return lockInMemory == other.lockInMemory && useHugePages == other.useHugePages; }
+        bool operator!=(const Options& other) const { return !operator==(other); }
+    };
+
+    /** What allocate() achieved for a block. */
+    struct Outcome
+    {
+        bool prefaulted = false;
+        bool locked = false;
+        bool hugePages = false;     // Huge pages were advised; the kernel may still decline
+        juce::String problem;       // Why an option fell back, if one did
+    };
+
+    /** Process-wide totals across every block, for monitoring. */
+    struct Report
+    {
+        juce::int64 lockedBytes = 0;        // Currently locked
+        juce::int64 unlockedBytes = 0;      // Currently held after a lock failed
+        juce::int64 hugePageBytes = 0;      // Currently advised onto huge pages
+        juce::int64 lockLimit = -1;         // RLIMIT_MEMLOCK, or -1 if unlimited or unknown
+        int numLockFailures = 0;            // Since the process started
+        juce::String lastProblem;
+
+        /** A one-line summary for display. */
+        juce::String toString() const;
+    };
+
+    ResidentMemory() = default;
+
+    /**
+     * Destructor for the ResidentMemory class. Unlocks and frees the block.
+     */
+    ~ResidentMemory();
+
+    /**
+     * Allocates a zeroed block, freeing any block held before.
+     *
+     * @param numBytes  The size of the block.
+     * @param options   How to back it.
+     * @return          What was achieved; also available from getOutcome().
+     */
+    const Outcome& allocate(size_t numBytes, const Options& options);
+
+    /**
+     * Unlocks and frees the block.
+     */
+    void free();
+
+    void* getData() const noexcept      { return data; }
+    size_t getSize() const noexcept     { return size; }
+    const Outcome& getOutcome() const   { return outcome; }
+
+    /**
+     * Returns the process-wide totals.
+     */
+    static Report getReport();
+
+private:
+    void* data = nullptr;
+    size_t size = 0;            // As requested
+    size_t allocatedSize = 0;   // Rounded up to whole pages
+    bool lockFailed = false;    // Counted as unlocked in the report
+    Outcome outcome;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResidentMemory)
+};
@@ -0,0 +1,451 @@
+/*
+  ==============================================================================
+
+    SamplePool.cpp
+    Created: 18 Oct 2026 4:21:33pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "SamplePool.h"
+
+/**
+ * The state of one file being decoded. Workers claim chunks in order, so the
+ * decoded prefix grows steadily even though chunks finish out of order. When
+ * the source is at a different rate, chunks are decoded into a scratch buffer
+ * and converted in order as the prefix of decoded input grows.
+ */
+struct SamplePool::Load
+{
+    juce::File file;
+    SourceBuffer::Ptr source;
+    int numChannels = 0;
+    int numInputSamples = 0;
+    int numChunks = 0;
+    double speedRatio = 1.0;                        // Input samples per output sample
+
+    std::atomic<int> nextChunk { 0 };
+    std::atomic<int> workersRemaining { 0 };
+    std::atomic<bool> failed { false };             // Set when a chunk couldn't be read; the others stop
+    std::unique_ptr<std::atomic<bool>[]> chunkReady;
+    double startTime = 0.0;
+
+    juce::CriticalSection publishLock;              // Held while publishing and converting
+    int numChunksPublished = 0;
+
+    // Rate conversion, only used when speedRatio isn't 1
+    juce::AudioBuffer<float> decoded;               // Input-rate audio, padded for the interpolator
+    juce::AudioBuffer<float> converted;             // Scratch for one conversion step
+    std::unique_ptr<juce::WindowedSincInterpolator[]> interpolators;    // One per channel
+    int latency = 0;                                // Output samples the interpolator lags by
+    int inputConsumed = 0;
+    int outputProduced = 0;
+
+    bool needsConversion() const { return speedRatio != 1.0; }
+
+    /** True when chunks can be decoded straight into the source. */
+    bool decodesInPlace() const { return !needsConversion() && source->getStorage() == SampleStorage::float32; }
+
+    /**
+     * Decodes one chunk into the source, or into the decoded buffer when
+     * converting. Compact sources are decoded into the worker's scratch and
+     * stored from there.
+     */
+    bool readChunk(juce::AudioFormatReader& reader, int chunk, juce::AudioBuffer<float>& scratch)
+    {
+        const int start = chunk * decodeChunkSize;
+        const int length = juce::jmin(decodeChunkSize, numInputSamples - start);
+
+        if (needsConversion())
+            return reader.read(&decoded, start, length, start, true, true);
+
+        if (decodesInPlace())
+            return reader.read(&source->getAudioSampleBuffer(), start, length, start, true, true);
+
+        if (!reader.read(&scratch, 0, length, start, true, true))
+            return false;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            source->writeSamples(channel, start, scratch.getReadPointer(channel), length);
+
+        return true;
+    }
+
+    /**
+     * Marks a chunk as decoded and publishes however much of the source is now
+     * contiguous from the start.
+     */
+    void chunkFinished(int chunk)
+    {
+        chunkReady[(size_t)chunk].store(true);
+
+        const juce::ScopedLock scopedLock(publishLock);
+
+        while (numChunksPublished < numChunks && chunkReady[(size_t)numChunksPublished].load())
+            ++numChunksPublished;
+
+        const int inputReady = juce::jmin(numChunksPublished * decodeChunkSize, numInputSamples);
+
+        if (needsConversion())
+            convert(inputReady);
+        else
+            source->publishReadySamples(inputReady);
+    }
+
+    /**
+     * Converts as much of the decoded input as the interpolator can use without
+     * reading past it. Once all input is decoded, runs on into the zero padding
+     * to flush the interpolator's delay.
+     */
+    void convert(int inputReady)
+    {
+        const bool allInputReady = inputReady == numInputSamples;
+        const int totalOutput = source->getNumSamples() + latency;
+
+        while (outputProduced < totalOutput)
+        {
+            // Each output reads at most one input beyond the last multiple of the ratio
+            int numOutput = allInputReady ? totalOutput - outputProduced
+                                          : (int)((inputReady - inputConsumed - 2) / speedRatio);
+
+            if (numOutput <= 0)
+                break;
+
+            numOutput = juce::jmin(numOutput, converted.getNumSamples());
+            int numUsed = 0;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                numUsed = interpolators[channel].process(speedRatio, decoded.getReadPointer(channel, inputConsumed),
+                                                                 converted.getWritePointer(channel), numOutput);
+
+            // Skip the interpolator's delay so the converted audio lines up with the original
+            const int first = juce::jmax(outputProduced, latency);
+            const int end = juce::jmin(outputProduced + numOutput, totalOutput);
+
+            for (int channel = 0; channel < numChannels && end > first; ++channel)
+                source->writeSamples(channel, first - latency, converted.getReadPointer(channel, first - outputProduced),
+                                     end - first);
+
+            outputProduced += numOutput;
+            inputConsumed += numUsed;
+        }
+
+        source->publishReadySamples(juce::jlimit(0, source->getNumSamples(), outputProduced - latency));
+    }
+};
+
+//==============================================================================
+SamplePool::SamplePool()
+{
+}
+
+SamplePool::~SamplePool()
+{
+    shuttingDown = true;
+
+    if (decodePool != nullptr)
+        decodePool->removeAllJobs(true, 10000);
+}
+
+juce::AudioFormatManager& SamplePool::getFormatManager()
+{
+    const juce::ScopedLock scopedLock(lock);
+
+    if (formatManager == nullptr)
+    {
+        formatManager = std::make_unique<juce::AudioFormatManager>();
+        formatManager->registerBasicFormats();
+    }
+
+    return *formatManager;
+}
+
+juce::ThreadPool& SamplePool::getDecodePool()
+{
+    const juce::ScopedLock scopedLock(lock);
+
+    if (decodePool == nullptr)
+        decodePool = std::make_unique<juce::ThreadPool>(juce::jmax(2, juce::SystemStats::getNumCpus() - 1));
+
+    return *decodePool;
+}
+
+SourceBuffer::Ptr SamplePool::getOrLoad(const juce::File& audioFile, double targetSampleRate, SampleStorage storage,
+                                        const ResidentMemory::Options& residency)
+{
+    if (!audioFile.existsAsFile())
+        return nullptr;
+
+    const FileIdentity identity { audioFile.getFullPathName(), audioFile.getSize(),
+                                  audioFile.getLastModificationTime().toMilliseconds() };
+
+    const juce::ScopedLock scopedLock(lock);
+
+    if (const auto* entry = findEntry(identity, targetSampleRate, storage))
+        return entry->source;
+
+    // Only opening the file happens under the lock; decoding and hashing happen on
+    // the workers. Two instances loading the same file at once share one load; the
+    // second finds it in the pool mid-decode.
+    double fileSampleRate = 0.0;
+    SourceBuffer::Ptr source = startDecoding(audioFile, targetSampleRate, storage, residency, fileSampleRate);
+
+    if (source != nullptr)
+    {
+        entries.push_back({ identity, {}, targetSampleRate, storage, source, fileSampleRate });
+        hashInBackground(audioFile, identity);
+    }
+
+    return source;
+}
+
+void SamplePool::releaseUnused()
+{
+    const juce::ScopedLock scopedLock(lock);
+
+    // The pool's own reference is the only one left
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+        [](const Entry& entry) { return entry.source->getReferenceCount() == 1; }),
+        entries.end());
+}
+
+juce::int64 SamplePool::getTotalBytes() const
+{
+    const juce::ScopedLock scopedLock(lock);
+
+    juce::int64 total = 0;
+
+    for (const auto& entry : entries)
+        total += entry.source->getSizeInBytes();
+
+    return total;
+}
+
+void SamplePool::analysePitchMarks(SourceBuffer::Ptr source)
+{
+    getDecodePool().addJob([this, source]
+    {
+        if (!shuttingDown)
+            source->analysePitchMarks();
+    });
+}
+
+juce::int64 SamplePool::getAnalysisBytes() const
+{
+    const juce::ScopedLock scopedLock(lock);
+
+    juce::int64 total = 0;
+
+    for (const auto& entry : entries)
+        if (const auto* marks = entry.source->getPitchMarks())
+            total += (juce::int64)marks->getSizeInBytes();
+
+    return total;
+}
+
+bool SamplePool::contains(const SourceBuffer* source) const
+{
+    return getFileSampleRate(source) > 0.0;
+}
+
+double SamplePool::getFileSampleRate(const SourceBuffer* source) const
+{
+    const juce::ScopedLock scopedLock(lock);
+
+    for (const auto& entry : entries)
+        if (entry.source.get() == source)
+            return entry.fileSampleRate;
+
+    return 0.0;
+}
+
+int SamplePool::getNumSources() const
+{
+    const juce::ScopedLock scopedLock(lock);
+    return (int)entries.size();
+}
+
+SamplePool::Entry* SamplePool::findEntry(const FileIdentity& identity, double sampleRate, SampleStorage storage)
+{
+    juce::String contentHash;
+
+    for (const auto& hashed : hashedFiles)
+        if (hashed.identity == identity)
+            contentHash = hashed.contentHash;
+
+    // Oldest first, so a copy of audio that's already pooled under another path
+    // stops being handed out once its hash is known, and leaves with its last user
+    for (auto& entry : entries)
+    {
+        if (entry.sampleRate != sampleRate || entry.storage != storage)
+            continue;
+
+        if (entry.identity == identity || (contentHash.isNotEmpty() && entry.contentHash == contentHash))
+            return &entry;
+    }
+
+    return nullptr;
+}
+
+void SamplePool::hashInBackground(const juce::File& audioFile, const FileIdentity& identity)
+{
+    for (const auto& hashed : hashedFiles)
+    {
+        if (hashed.identity == identity)
+        {
+            for (auto& entry : entries)
+                if (entry.identity == identity)
+                    entry.contentHash = hashed.contentHash;
+
+            return;
+        }
+    }
+
+    // Queued behind the decode jobs, so the file is usually still cached when it's read again
+    getDecodePool().addJob([this, audioFile, identity]
+    {
+        if (shuttingDown)
+            return;
+
+        const juce::String contentHash = juce::MD5(audioFile).toHexString();
+
+        const juce::ScopedLock scopedLock(lock);
+
+        hashedFiles.erase(std::remove_if(hashedFiles.begin(), hashedFiles.end(),
+            [&identity](const HashedFile& hashed) { return hashed.identity.path == identity.path; }),
+            hashedFiles.end());
+        hashedFiles.push_back({ identity, contentHash });
+
+        for (auto& entry : entries)
+            if (entry.identity == identity)
+                entry.contentHash = contentHash;
+    });
+}
+
+void SamplePool::remove(const SourceBuffer* source)
+{
+    const juce::ScopedLock scopedLock(lock);
+
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+        [source](const Entry& entry) { return entry.source.get() == source; }),
+        entries.end());
+}
+
+SourceBuffer::Ptr SamplePool::startDecoding(const juce::File& audioFile, double targetSampleRate, SampleStorage storage,
+                                            const ResidentMemory::Options& residency, double& fileSampleRate)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(getFormatManager().createReaderFor(audioFile));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->lengthInSamples > std::numeric_limits<int>::max())
+        return nullptr;
+
+    fileSampleRate = reader->sampleRate;
+
+    auto load = std::make_shared<Load>();
+    load->file = audioFile;
+    load->numChannels = (int)reader->numChannels;
+    load->numInputSamples = (int)reader->lengthInSamples;
+    load->numChunks = (load->numInputSamples + decodeChunkSize - 1) / decodeChunkSize;
+    load->chunkReady.reset(new std::atomic<bool>[(size_t)load->numChunks]);
+    load->startTime = juce::Time::getMillisecondCounterHiRes();
+
+    for (int chunk = 0; chunk < load->numChunks; ++chunk)
+        load->chunkReady[(size_t)chunk].store(false);
+
+    if (targetSampleRate <= 0.0 || reader->sampleRate == targetSampleRate)
+    {
+        load->source = new SourceBuffer(audioFile.getFileName(), load->numChannels, load->numInputSamples,
+                                        reader->sampleRate, storage, residency);
+    }
+    else
+    {
+        // Convert to the engine rate once here, so grains never resample on the audio thread
+        load->speedRatio = reader->sampleRate / targetSampleRate;
+        const int numOutputSamples = juce::jmax(1, (int)(load->numInputSamples / load->speedRatio));
+
+        load->interpolators.reset(new juce::WindowedSincInterpolator[(size_t)load->numChannels]);
+        load->latency = juce::roundToInt(juce::WindowedSincInterpolator::getBaseLatency() / load->speedRatio);
+        const int padding = (int)std::ceil(juce::WindowedSincInterpolator::getBaseLatency()) + 64;
+
+        load->decoded.setSize(load->numChannels, load->numInputSamples + padding);
+        load->decoded.clear(load->numInputSamples, padding);
+        load->converted.setSize(load->numChannels, decodeChunkSize);
+
+        load->source = new SourceBuffer(audioFile.getFileName(), load->numChannels, numOutputSamples,
+                                        targetSampleRate, storage, residency);
+    }
+
+    load->source->beginLoading();
+
+    // Readers aren't thread-safe, so each worker opens its own. Only formats that
+    // can seek cheaply and exactly are split between workers.
+    const juce::String formatName = reader->getFormatName();
+    const bool randomAccess = formatName == "WAV file" || formatName == "AIFF file" || formatName == "FLAC file";
+    const int numWorkers = randomAccess ? juce::jmin(load->numChunks, getDecodePool().getNumThreads()) : 1;
+
+    load->workersRemaining = numWorkers;
+
+    auto firstReader = std::make_shared<std::unique_ptr<juce::AudioFormatReader>>(std::move(reader));
+
+    for (int worker = 0; worker < numWorkers; ++worker)
+    {
+        decodePool->addJob([this, load, firstReader, worker]
+        {
+            std::unique_ptr<juce::AudioFormatReader> workerReader;
+
+            if (worker == 0)
+                workerReader = std::move(*firstReader);
+            else
+                workerReader.reset(formatManager->createReaderFor(load->file));
+
+            runDecodeWorker(load, std::move(workerReader));
+        });
+    }
+
+    return load->source;
+}
+
+void SamplePool::runDecodeWorker(const std::shared_ptr<Load>& load, std::unique_ptr<juce::AudioFormatReader> reader)
+{
+    if (reader != nullptr)
+    {
+        juce::AudioBuffer<float> scratch;
+
+        if (!load->needsConversion() && !load->decodesInPlace())
+            scratch.setSize(load->numChannels, decodeChunkSize);
+
+        for (int chunk = load->nextChunk.fetch_add(1); chunk < load->numChunks && !shuttingDown && !load->failed;
+             chunk = load->nextChunk.fetch_add(1))
+        {
+            if (!load->readChunk(*reader, chunk, scratch))
+            {
+                DBG("Failed to decode " << load->file.getFileName() << " at sample " << chunk * decodeChunkSize);
+                load->failed = true;
+                break;
+            }
+
+            load->chunkFinished(chunk);
+        }
+    }
+
+    if (load->workersRemaining.fetch_sub(1) == 1)
+    {
+        // A broken source leaves the pool, so loading the file again retries it
+        // rather than handing out a source that will never finish
+        if (load->failed)
+        {
+            load->source->failLoading();
+            remove(load->source.get());
+            return;
+        }
+
+        DBG("Decoded " << load->file.getFileName() << " in "
+            << juce::String(juce::Time::getMillisecondCounterHiRes() - load->startTime, 1) << " ms");
+        load->source->finishLoading();
+
+        // This worker is free now, so it finds the pitch marks while it's here
+        if (!shuttingDown)
+            load->source->analysePitchMarks();
+    }
+}
@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    SamplePool.h
+    Created: 18 Oct 2026 4:21:33pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SourceBuffer.h"
+
+/**
+ * A process-wide pool of decoded sources, shared by every plugin instance.
+ *
+ * Sources are keyed by the file's path, size and modification time, the sample
+ * rate they were converted to and their storage format, so loading the same
+ * audio into many instances decodes it once and holds it in memory once. Each
+ * file is also hashed in the background once it has decoded, so later loads of
+ * the same audio under another path share the existing source too. Sources are
+ * immutable once in the pool and are only ever read by the instances that
+ * share them.
+ *
+ * Files are decoded progressively. A new source is returned as soon as its
+ * reader is open, and its decoded prefix grows as chunks of the file arrive.
+ * Formats that allow random access (WAV, AIFF, FLAC) are read in chunks on
+ * several workers at once; others are read chunk by chunk on a single worker.
+ *
+ * Once a file has finished decoding, the worker that finished it goes on to
+ * analyse the source's pitch marks, so PSOLA grains can use them. If part of a
+ * file can't be decoded, the source is marked as failed and leaves the pool, so
+ * loading the file again retries it.
+ *
+ * Nothing is set up until it's needed: the format manager and the decode
+ * workers are created by the first load, so instances that never load a file
+ * cost nothing here.
+ *
+ * Access it through juce::SharedResourcePointer<SamplePool>. All methods are
+ * thread-safe but may block, so never call them from the audio thread.
+ */
+class SamplePool
+{
+public:
+    static constexpr int decodeChunkSize = 1 << 15;     // Source samples decoded per job step
+
+    /**
+     * Constructor for the SamplePool class.
+     */
+    SamplePool();
+
+    /**
+     * Destructor for the SamplePool class. Abandons any loads still in progress.
+     */
+    ~SamplePool();
+
+    /**
+     * Returns the pooled source for a file at the given sample rate, decoding
+     * and converting it if no instance holds it yet. A newly loaded source is
+     * returned while it is still being decoded; see SourceBuffer::getNumReadySamples().
+     *
+     * @param audioFile         The audio file to load.
+     * @param targetSampleRate  The sample rate to convert the audio to, or 0 to keep the file's own.
+     * @param storage           How to hold the samples in memory.
+     * @param residency         Whether to prefault and lock a newly loaded source. A source
+     *                          already in the pool keeps the residency it was loaded with.
+     * @return                  The shared source, or nullptr if the file could not be read.
+     */
+    SourceBuffer::Ptr getOrLoad(const juce::File& audioFile, double targetSampleRate,
+                                SampleStorage storage = SampleStorage::float32,
+                                const ResidentMemory::Options& residency = {});
+
+    /**
+     * Drops any sources that no instance is using any more.
+     */
+    void releaseUnused();
+
+    /**
+     * Returns the number of bytes of audio held by the pool.
+     */
+    juce::int64 getTotalBytes() const;
+
+    /**
+     * Analyses the pitch marks of a source that didn't come from the pool, such
+     * as a recording, on the decode workers.
+     */
+    void analysePitchMarks(SourceBuffer::Ptr source);
+
+    /**
+     * Returns the number of bytes of pitch marks analysed for the pool's sources.
+     */
+    juce::int64 getAnalysisBytes() const;
+
+    /**
+     * Returns true if the source is one of the pool's.
+     */
+    bool contains(const SourceBuffer* source) const;
+
+    /**
+     * Returns the sample rate of the file a pooled source was decoded from, or 0
+     * if the source isn't in the pool.
+     */
+    double getFileSampleRate(const SourceBuffer* source) const;
+
+    /**
+     * Returns the number of distinct sources held by the pool.
+     */
+    int getNumSources() const;
+
+    /**
+     * Returns the format manager shared by all instances, registering the
+     * formats the first time it's asked for.
+     */
+    juce::AudioFormatManager& getFormatManager();
+
+private:
+    struct Load;
+
+    struct FileIdentity
+    {
+        juce::String path;
+        juce::int64 size = 0;
+        juce::int64 modificationTime = 0;
+
+        bool operator==(const FileIdentity& other) const
+        {
+            return path == other.path && size == other.size && modificationTime == other.modificationTime;
+        }
+    };
+
+    struct HashedFile
+    {
+        FileIdentity identity;
+        juce::String contentHash;
+    };
+
+    struct Entry
+    {
+        FileIdentity identity;
+        juce::String contentHash;       // Empty until the file has been hashed
+        double sampleRate = 0.0;
+        SampleStorage storage = SampleStorage::float32;
+        SourceBuffer::Ptr source;
+        double fileSampleRate = 0.0;    // Before any conversion
+    };
+
+    juce::CriticalSection lock;                 // Guards everything below, held while decoding
+    std::unique_ptr<juce::AudioFormatManager> formatManager;    // Shared by every instance; made by the first load
+    std::vector<HashedFile> hashedFiles;        // Content hashes of files as they were when hashed
+    std::vector<Entry> entries;                 // The pooled sources
+    std::atomic<bool> shuttingDown { false };   // Tells decode workers to stop early
+    std::unique_ptr<juce::ThreadPool> decodePool;   // Decodes chunks of files in parallel; started by the first load
+
+    /**
+     * Returns the decode workers, starting them the first time.
+     */
+    juce::ThreadPool& getDecodePool();
+
+    /**
+     * Returns the pooled entry for a file at a rate and storage format: one loaded
+     * from the same file, or failing that the oldest with the same contents.
+     * Called with the lock held.
+     */
+    Entry* findEntry(const FileIdentity& identity, double sampleRate, SampleStorage storage);
+
+    /**
+     * Fills in an entry's content hash, hashing the file on a decode worker
+     * unless it is already known. Called with the lock held.
+     */
+    void hashInBackground(const juce::File& audioFile, const FileIdentity& identity);
+
+    /**
+     * Removes a source from the pool, so the next load of its file starts afresh.
+     */
+    void remove(const SourceBuffer* source);
+
+    /**
+     * Creates a source for a file and starts decoding it, converting to the target
+     * sample rate and storage format, on the decode workers.
+     */
+    SourceBuffer::Ptr startDecoding(const juce::File& audioFile, double targetSampleRate, SampleStorage storage,
+                                    const ResidentMemory::Options& residency, double& fileSampleRate);
+
+    /**
+     * Decodes chunks of a load until none are left. Runs on a decode worker.
+     */
+    void runDecodeWorker(const std::shared_ptr<Load>& load, std::unique_ptr<juce::AudioFormatReader> reader);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SamplePool)
+};
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    SampleStorage.cpp
+    Created: 18 Oct 2026 10:02:37pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "SampleStorage.h"
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <emmintrin.h>
+#endif
+
+#if JUCE_INTEL && (defined(__GNUC__) || defined(__clang__))
+ #include <immintrin.h>
+ #define HW5_F16C_RUNTIME 1
+#else
+ #define HW5_F16C_RUNTIME 0
+#endif
+
+#if JUCE_USE_ARM_NEON || (JUCE_ARM && defined(__aarch64__))
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+   #if HW5_F16C_RUNTIME
+    // Compiled for F16C whatever the build's target, and only called when the CPU has it
+    __attribute__((target("avx,f16c")))
+    int halfToFloatF16C(const juce::uint16* source, float* destination, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+            _mm256_storeu_ps(destination + i, _mm256_cvtph_ps(half));
+        }
+
+        return i;
+    }
+
+    const bool cpuHasF16C = __builtin_cpu_supports("f16c");
+   #endif
+}
+
+void SampleStorageConversion::toFloat(const juce::int16* source, float* destination, int numSamples) noexcept
+{
+    int i = 0;
+
+   #if JUCE_USE_SSE_INTRINSICS
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+
+        // Sign-extend each half to 32 bits by unpacking into the high word and shifting back down
+        const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+
+        _mm_storeu_ps(destination + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(destination + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+   #elif JUCE_USE_ARM_NEON
+    const float32x4_t scale = vdupq_n_f32(1.0f / 32768.0f);
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const int16x8_t samples = vld1q_s16(source + i);
+
+        vst1q_f32(destination + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), scale));
+        vst1q_f32(destination + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))), scale));
+    }
+   #endif
+
+    for (; i < numSamples; ++i)
+        destination[i] = int16ToFloat(source[i]);
+}
+
+void SampleStorageConversion::toFloat(const juce::uint16* source, float* destination, int numSamples) noexcept
+{
+    int i = 0;
+
+   #if HW5_F16C_RUNTIME
+    if (cpuHasF16C)
+        i = halfToFloatF16C(source, destination, numSamples);
+   #elif JUCE_ARM && defined(__aarch64__)
+    for (; i + 4 <= numSamples; i += 4)
+        vst1q_f32(destination + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(source + i))));
+   #endif
+
+    for (; i < numSamples; ++i)
+        destination[i] = halfToFloat(source[i]);
+}
+
+const char* SampleStorageConversion::getName(SampleStorage storage) noexcept
+{
+    switch (storage)
+    {
+        case SampleStorage::int16:      return "16-bit";
+        case SampleStorage::float16:    return "Half float";
+        case SampleStorage::float32:
+        case SampleStorage::numStorages:
+            break;
+    }
+
+    return "Float";
+}
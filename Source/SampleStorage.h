@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    SampleStorage.h
+    Created: 18 Oct 2026 10:02:37pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/** How a source's samples are held in memory. */
+enum class SampleStorage
+{
+    float32 = 0,    // 32-bit float, exact
+    int16,          // 16-bit fixed point, half the memory; quantises 24-bit and float material
+    float16,        // IEEE half float, half the memory; keeps about 11 bits of precision at any level
+    numStorages
+};
+
+/**
+ * Conversions between float and the compact sample formats. Single samples
+ * convert inline; blocks convert with SIMD where the CPU supports it.
+ */
+namespace SampleStorageConversion
+{
+    inline float int16ToFloat(juce::int16 sample) noexcept
+    {
+        return static_cast<float>(sample) * (1.0f / 32768.0f);
+    }
+
+    inline juce::int16 floatToInt16(float sample) noexcept
+    {
+        return static_cast<juce::int16>(juce::jlimit(-32768, 32767, juce::roundToInt(sample * 32768.0f)));
+    }
+
+    /** Converts IEEE binary16 to float, including subnormals, infinities and NaN. */
+    inline float halfToFloat(juce::uint16 half) noexcept
+    {
+        constexpr juce::uint32 shiftedExponent = 0x7c00u << 13;
+        juce::uint32 bits = (juce::uint32)(half & 0x7fffu) << 13;
+        const juce::uint32 exponent = bits & shiftedExponent;
+
+        bits += (127u - 15u) << 23;
+
+        if (exponent == shiftedExponent)
+        {
+            bits += (128u - 16u) << 23;     // Infinity or NaN
+        }
+        else if (exponent == 0)
+        {
+            // Subnormal: renormalise through a float subtraction
+            bits += 1u << 23;
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            value -= 6.103515625e-05f;      // 2^-14
+            std::memcpy(&bits, &value, sizeof(value));
+        }
+
+        bits |= (juce::uint32)(half & 0x8000u) << 16;
+
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    /** Converts float to IEEE binary16, rounding to nearest even. */
+    inline juce::uint16 floatToHalf(float value) noexcept
+    {
+        juce::uint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        const juce::uint32 sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        juce::uint32 half;
+
+        if (bits >= 0x47800000u)
+        {
+            half = bits > 0x7f800000u ? 0x7e00u : 0x7c00u;     // NaN, or infinity on overflow
+        }
+        else if (bits < 0x38800000u)
+        {
+            // Subnormal or zero: let a float addition align and round the mantissa
+            constexpr juce::uint32 magicBits = 126u << 23;
+            float magic, shifted;
+            std::memcpy(&magic, &magicBits, sizeof(magic));
+            std::memcpy(&shifted, &bits, sizeof(shifted));
+            shifted += magic;
+
+            std::memcpy(&half, &shifted, sizeof(half));
+            half -= magicBits;
+        }
+        else
+        {
+            const juce::uint32 mantissaOdd = (bits >> 13) & 1u;
+            bits += ((15u - 127u) << 23) + 0xfffu + mantissaOdd;
+            half = bits >> 13;
+        }
+
+        return static_cast<juce::uint16>(half | (sign >> 16));
+    }
+
+    /**
+     * Converts a block of 16-bit samples to float.
+     */
+    void toFloat(const juce::int16* source, float* destination, int numSamples) noexcept;
+
+    /**
+     * Converts a block of half-float samples to float.
+     */
+    void toFloat(const juce::uint16* source, float* destination, int numSamples) noexcept;
+
+    /**
+     * Returns a short display name for a storage format.
+     */
+    const char* getName(SampleStorage storage) noexcept;
+}
@@ -0,0 +1,335 @@
+/*
+  ==============================================================================
+
+    SourceBuffer.h
+    Created: 18 Oct 2026 9:12:04am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GrainKernels.h"
+#include "ResidentMemory.h"
+#include "PitchMarks.h"
+
+/**
+ * A reference-counted, decoded audio source that grains read from.
+ *
+ * Once a SourceBuffer has been handed to the engine its audio is treated as
+ * immutable, so it can be shared between the audio thread and background
+ * analysis jobs (e.g. the waveform peak pyramid) without copying.
+ *
+ * A source may be handed over while it is still being decoded. Only the first
+ * getNumReadySamples() samples may then be read; the loader writes beyond them
+ * and publishes each newly decoded region by raising the count.
+ *
+ * Audio is held as 32-bit float by default, or in one of the compact
+ * SampleStorage formats to halve its memory. Compact sources are filled through
+ * writeSamples(), which also measures the error the format introduces, and are
+ * read through getGrainSource(), which the grain kernels convert on the fly.
+ *
+ * The samples live in a single ResidentMemory block, so they can be prefaulted
+ * and locked in memory, and backed by huge pages, when the source is created.
+ *
+ * Pitch marks for PSOLA grains are analysed once per source, in the background
+ * after it has loaded, and then shared by everyone using the source.
+ */
+class SourceBuffer : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<SourceBuffer>;
+
+    /**
+     * Constructor for the SourceBuffer class.
+     *
+     * @param sourceName   A display name for the source (usually the file name).
+     * @param numChannels  The number of channels to allocate.
+     * @param numSamples   The number of samples per channel to allocate.
+     * @param sampleRate   The sample rate the audio was decoded at.
+     * @param format       How the samples are held in memory.
+     * @param residency    Whether to prefault and lock the samples, and back them with huge pages.
+     */
+    SourceBuffer(const juce::String& sourceName, int numChannels, int numSamples, double sampleRate,
+                 SampleStorage format = SampleStorage::float32, const ResidentMemory::Options& residency = {})
+        : name(sourceName), storage(format), channelCount(numChannels), sampleCount(numSamples),
+          sourceSampleRate(sampleRate), numReadySamples(numSamples)
+    {
+        const size_t bytesPerSample = storage == SampleStorage::float32 ? sizeof(float) : sizeof(juce::uint16);
+        memory.allocate((size_t)numChannels * (size_t)numSamples * bytesPerSample, residency);
+
+        if (storage == SampleStorage::float32)
+        {
+            std::vector<float*> floatChannels;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                floatChannels.push_back(static_cast<float*>(memory.getData()) + (size_t)channel * (size_t)numSamples);
+
+            buffer.setDataToReferTo(floatChannels.data(), numChannels, numSamples);
+            return;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            compactChannels.push_back(static_cast<juce::uint16*>(memory.getData()) + (size_t)channel * (size_t)numSamples);
+            compactReadPointers.push_back(compactChannels.back());
+        }
+    }
+
+    /**
+     * Returns the float audio. Only valid for float32 storage; other formats are
+     * read through getGrainSource() or readSamples().
+     */
+    juce::AudioBuffer<float>& getAudioSampleBuffer()             { jassert(storage == SampleStorage::float32); return buffer; }
+    const juce::AudioBuffer<float>& getAudioSampleBuffer() const { jassert(storage == SampleStorage::float32); return buffer; }
+
+    int getNumChannels() const       { return channelCount; }
+    int getNumSamples() const        { return sampleCount; }
+    double getSampleRate() const     { return sourceSampleRate; }
+    SampleStorage getStorage() const { return storage; }
+    const juce::String& getName() const { return name; }
+
+    /** Returns the number of bytes of audio held. */
+    juce::int64 getSizeInBytes() const { return (juce::int64)memory.getSize(); }
+
+    /** Returns whether the samples were prefaulted, locked and put on huge pages. */
+    const ResidentMemory::Outcome& getResidency() const { return memory.getOutcome(); }
+
+    /**
+     * Returns a view of the samples that are ready, for the grain kernels. Safe to
+     * call from the audio thread.
+     */
+    GrainSource getGrainSource() const noexcept
+    {
+        GrainSource source;
+        source.storage = storage;
+        source.numChannels = channelCount;
+        source.numSamples = getNumReadySamples();
+
+        if (storage == SampleStorage::float32)
+            source.channels = buffer.getArrayOfReadPointers();
+        else
+            source.compactChannels = compactReadPointers.data();
+
+        return source;
+    }
+
+    /**
+     * Stores decoded float samples, converting them to the storage format and
+     * measuring the error that introduces. Called by the loader before the
+     * samples are published; different channels or regions may be written from
+     * different threads at once.
+     *
+     * @param channel      The channel to write.
+     * @param startSample  The first sample to write.
+     * @param samples      The float samples.
+     * @param numSamples   The number of samples to write.
+     */
+    void writeSamples(int channel, int startSample, const float* samples, int numSamples)
+    {
+        jassert(startSample >= 0 && startSample + numSamples <= sampleCount);
+
+        if (storage == SampleStorage::float32)
+        {
+            buffer.copyFrom(channel, startSample, samples, numSamples);
+            return;
+        }
+
+        juce::uint16* destination = compactChannels[(size_t)channel] + startSample;
+        double signalPower = 0.0, errorPower = 0.0;
+        float peakError = 0.0f;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float stored;
+
+            if (storage == SampleStorage::int16)
+            {
+                const juce::int16 sample = SampleStorageConversion::floatToInt16(samples[i]);
+                destination[i] = (juce::uint16)sample;
+                stored = SampleStorageConversion::int16ToFloat(sample);
+            }
+            else
+            {
+                destination[i] = SampleStorageConversion::floatToHalf(samples[i]);
+                stored = SampleStorageConversion::halfToFloat(destination[i]);
+            }
+
+            const float error = stored - samples[i];
+            signalPower += (double)samples[i] * samples[i];
+            errorPower += (double)error * error;
+            peakError = juce::jmax(peakError, std::abs(error));
+        }
+
+        const juce::SpinLock::ScopedLockType scopedLock(errorLock);
+        storageError.signalPower += signalPower;
+        storageError.errorPower += errorPower;
+        storageError.peakError = juce::jmax(storageError.peakError, peakError);
+        storageError.numSamples += numSamples;
+    }
+
+    /**
+     * Copies part of a channel out as float, whatever the storage format.
+     *
+     * @param channel      The channel to read.
+     * @param startSample  The first sample to read.
+     * @param destination  Where to write the samples.
+     * @param numSamples   The number of samples to read.
+     */
+    void readSamples(int channel, int startSample, float* destination, int numSamples) const
+    {
+        jassert(startSample >= 0 && startSample + numSamples <= sampleCount);
+
+        if (storage == SampleStorage::float32)
+            juce::FloatVectorOperations::copy(destination, buffer.getReadPointer(channel, startSample), numSamples);
+        else if (storage == SampleStorage::int16)
+            SampleStorageConversion::toFloat(reinterpret_cast<const juce::int16*>(compactChannels[(size_t)channel] + startSample), destination, numSamples);
+        else
+            SampleStorageConversion::toFloat(compactChannels[(size_t)channel] + startSample, destination, numSamples);
+    }
+
+    /**
+     * Returns the source's pitch marks, or nullptr until they have been analysed.
+     * Safe to call from the audio thread; the marks live as long as the source.
+     */
+    const PitchMarks* getPitchMarks() const noexcept { return publishedPitchMarks.load(std::memory_order_acquire); }
+
+    /**
+     * Analyses the pitch marks of the fully loaded audio, unless they have been
+     * already. Blocks for the length of the analysis, so call it on a background
+     * thread.
+     */
+    void analysePitchMarks()
+    {
+        if (!isFullyLoaded() || pitchAnalysisClaimed.exchange(true))
+            return;
+
+        std::vector<float> mono((size_t)sampleCount);
+        std::vector<float> channelSamples((size_t)sampleCount);
+
+        for (int channel = 0; channel < channelCount; ++channel)
+        {
+            readSamples(channel, 0, channelSamples.data(), sampleCount);
+            juce::FloatVectorOperations::addWithMultiply(mono.data(), channelSamples.data(), 1.0f / (float)channelCount, sampleCount);
+        }
+
+        pitchMarks = PitchMarks::analyse(mono.data(), sampleCount, sourceSampleRate);
+        publishedPitchMarks.store(pitchMarks.get(), std::memory_order_release);
+    }
+
+    /** How far the stored audio is from the float audio it was written from. */
+    struct StorageError
+    {
+        double signalPower = 0.0;   // Sum of squared input samples
+        double errorPower = 0.0;    // Sum of squared differences from the input
+        float peakError = 0.0f;     // Largest difference from any input sample
+        juce::int64 numSamples = 0;
+
+        /** Signal-to-error ratio in dB; infinite for exact storage. */
+        double getSignalToErrorDb() const
+        {
+            return errorPower > 0.0 ? 10.0 * std::log10(signalPower / errorPower)
+                                    : std::numeric_limits<double>::infinity();
+        }
+
+        /** RMS error relative to full scale, in dB. */
+        double getRmsErrorDb() const
+        {
+            return numSamples > 0 ? juce::Decibels::gainToDecibels(std::sqrt(errorPower / (double)numSamples), -200.0)
+                                  : -200.0;
+        }
+
+        /** Peak error relative to full scale, in dB. */
+        double getPeakErrorDb() const { return juce::Decibels::gainToDecibels((double)peakError, -200.0); }
+    };
+
+    /**
+     * Returns the error measured against float storage over every sample written
+     * so far. Always zero for float32 storage.
+     */
+    StorageError getStorageError() const
+    {
+        const juce::SpinLock::ScopedLockType scopedLock(errorLock);
+        return storageError;
+    }
+
+    /**
+     * Returns how many samples from the start have been decoded and may be read.
+     * Safe to call from any thread, including the audio thread.
+     */
+    int getNumReadySamples() const noexcept { return numReadySamples.load(std::memory_order_acquire); }
+
+    bool isFullyLoaded() const noexcept { return getNumReadySamples() == getNumSamples(); }
+
+    /**
+     * Returns true if the loader gave up before every sample was decoded. The
+     * decoded prefix stays readable, but the rest never arrives.
+     */
+    bool hasLoadFailed() const noexcept { return loadFailed.load(std::memory_order_acquire); }
+
+    /**
+     * Blocks until loading has finished, successfully or not. Never call this from
+     * the audio thread.
+     *
+     * @param timeoutMs  How long to wait, or -1 to wait forever.
+     * @return           True if every sample is ready.
+     */
+    bool waitUntilLoaded(int timeoutMs = -1) const
+    {
+        if (!isFullyLoaded())
+            loadFinished.wait((double)timeoutMs);
+
+        return isFullyLoaded();
+    }
+
+    /**
+     * Marks the audio as not yet decoded. Called by the loader before the source
+     * is shared.
+     */
+    void beginLoading() { numReadySamples.store(0); }
+
+    /**
+     * Publishes the first numSamples samples as decoded. Called by the loader
+     * after writing them.
+     */
+    void publishReadySamples(int numSamples) noexcept { numReadySamples.store(numSamples, std::memory_order_release); }
+
+    /**
+     * Wakes anyone waiting for the load to finish. Called by the loader once it
+     * has stopped, whether or not every chunk decoded.
+     */
+    void finishLoading() { loadFinished.signal(); }
+
+    /**
+     * Marks the load as failed and wakes anyone waiting for it. Called by the
+     * loader instead of finishLoading() when part of the file couldn't be decoded.
+     */
+    void failLoading()
+    {
+        loadFailed.store(true, std::memory_order_release);
+        loadFinished.signal();
+    }
+
+private:
+    juce::String name;                  // Display name of the source
+    SampleStorage storage;              // How the samples are held
+    int channelCount = 0;
+    int sampleCount = 0;
+    ResidentMemory memory;              // The decoded audio, channel after channel
+    juce::AudioBuffer<float> buffer;    // Refers to memory, for float32 storage
+    std::vector<juce::uint16*> compactChannels;     // Start of each channel in memory, for other formats
+    std::vector<const void*> compactReadPointers;   // The same, as GrainSource takes them
+    double sourceSampleRate = 44100.0;  // Sample rate of the decoded audio
+    std::atomic<int> numReadySamples;   // Decoded prefix that readers may use
+    mutable juce::WaitableEvent loadFinished { true };
+    std::atomic<bool> loadFailed { false };    // Set if decoding stopped before the end
+    mutable juce::SpinLock errorLock;   // Guards storageError while loader workers write
+    StorageError storageError;
+    std::unique_ptr<PitchMarks> pitchMarks;             // Written once by analysePitchMarks()
+    std::atomic<const PitchMarks*> publishedPitchMarks { nullptr };
+    std::atomic<bool> pitchAnalysisClaimed { false };   // Analysis has started
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SourceBuffer)
+};
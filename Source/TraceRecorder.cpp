@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.cpp
+    Created: 18 Oct 2026 8:03:17pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "TraceRecorder.h"
+
+//==============================================================================
+TraceRecorder::Scope::Scope(TraceRecorder* recorder, const char* name, juce::int64 value) noexcept
+    : owner(recorder), eventName(name), active(recorder != nullptr && recorder->isRecording())
+{
+    if (active)
+        owner->record(eventName, 'B', (double)value);
+}
+
+TraceRecorder::Scope::~Scope()
+{
+    // Always close a scope that was opened, so begin and end events stay paired
+    if (active)
+        owner->record(eventName, 'E', 0.0);
+}
+
+//==============================================================================
+TraceRecorder::TraceRecorder()
+    : juce::Thread("Trace writer")
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    stop();
+}
+
+bool TraceRecorder::start(const juce::File& file)
+{
+    stop();
+
+    file.deleteFile();
+    output = file.createOutputStream();
+
+    if (output == nullptr || !output->openedOk())
+    {
+        output.reset();
+        return false;
+    }
+
+    // Most instances are never traced, so the ring is only allocated on first use
+    if (events.empty())
+        events.resize((size_t)capacity);
+
+    // Discard anything left over from a scope that closed after the last stop()
+    fifo.read(fifo.getNumReady());
+
+    startTicks = juce::Time::getHighResolutionTicks();
+    dropped = 0;
+
+    *output << "{\"traceEvents\":[\n"
+            << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"hw5\"}},\n"
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Audio\"}}";
+
+    recording = true;
+    startThread(juce::Thread::Priority::low);
+    return true;
+}
+
+void TraceRecorder::stop()
+{
+    if (output == nullptr)
+        return;
+
+    recording = false;
+    stopThread(1000);
+    writePending();
+
+    *output << "\n],\"otherData\":{\"droppedEvents\":" << juce::String(dropped.load()) << "}}\n";
+    output->flush();
+    output.reset();
+}
+
+void TraceRecorder::recordInstant(const char* name, juce::int64 value) noexcept
+{
+    if (isRecording())
+        record(name, 'i', (double)value);
+}
+
+void TraceRecorder::recordCounter(const char* name, double value) noexcept
+{
+    if (isRecording())
+        record(name, 'C', value);
+}
+
+void TraceRecorder::record(const char* name, char phase, double value) noexcept
+{
+    const auto scope = fifo.write(1);
+    Event* event = nullptr;
+
+    if (scope.blockSize1 > 0)
+        event = &events[(size_t)scope.startIndex1];
+    else if (scope.blockSize2 > 0)
+        event = &events[(size_t)scope.startIndex2];
+
+    if (event == nullptr)
+    {
+        dropped.fetch_add(1);
+        return;
+    }
+
+    event->name = name;
+    event->phase = phase;
+    event->ticks = juce::Time::getHighResolutionTicks();
+    event->value = value;
+}
+
+void TraceRecorder::run()
+{
+    while (!threadShouldExit())
+    {
+        writePending();
+        wait(100);
+    }
+}
+
+void TraceRecorder::writePending()
+{
+    const double microsecondsPerTick = 1.0e6 / (double)juce::Time::getHighResolutionTicksPerSecond();
+    const int numReady = fifo.getNumReady();
+
+    if (numReady == 0)
+        return;
+
+    juce::String text;
+    text.preallocateBytes((size_t)numReady * 96);
+
+    const auto scope = fifo.read(numReady);
+
+    scope.forEach([&](int index)
+    {
+        const Event& event = events[(size_t)index];
+        const double timestamp = (double)(event.ticks - startTicks) * microsecondsPerTick;
+
+        text << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"" << juce::String::charToString(event.phase)
+             << "\",\"ts\":" << juce::String(timestamp, 3) << ",\"pid\":1,\"tid\":1";
+
+        if (event.phase == 'i')
+            text << ",\"s\":\"t\"";
+
+        if (event.phase != 'E')
+            text << ",\"args\":{\"value\":" << juce::String(event.value) << "}";
+
+        text << "}";
+    });
+
+    // The header ends with metadata events, so every event follows a comma
+    *output << text;
+    output->flush();
+}
@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.h
+    Created: 18 Oct 2026 8:03:17pm
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ * Records timestamped audio-thread events into a preallocated ring and writes
+ * them to a Chrome trace-event JSON file, which Perfetto and chrome://tracing
+ * can open.
+ *
+ * Recording is opt-in. While stopped, each trace point costs one relaxed atomic
+ * load. While recording, the audio thread only copies a small event into the
+ * ring; a background thread formats and writes the file. If the writer falls
+ * behind, new events are dropped and counted rather than blocking.
+ *
+ * Event names must be string literals, as only the pointer is stored.
+ *
+ * Thread ownership: record...() and Scope are for the audio thread only;
+ * start() and stop() are for the message thread.
+ */
+class TraceRecorder : private juce::Thread
+{
+public:
+    static constexpr int capacity = 1 << 16;    // Events held before the writer must catch up
+
+    /**
+     * Marks the duration of a scope with a begin and an end event. A null
+     * recorder records nothing.
+     */
+    class Scope
+    {
+    public:
+        Scope(TraceRecorder* recorder, const char* name, juce::int64 value = 0) noexcept;
+        Scope(TraceRecorder& recorder, const char* name, juce::int64 value = 0) noexcept
+            : Scope(&recorder, name, value) {}
+        ~Scope();
+
+    private:
+        TraceRecorder* owner;
+        const char* eventName;
+        bool active;
+
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+
+    /**
+     * Constructor for the TraceRecorder class.
+     */
+    TraceRecorder();
+
+    /**
+     * Destructor for the TraceRecorder class. Stops any recording in progress.
+     */
+    ~TraceRecorder() override;
+
+    /**
+     * Starts recording to a file, replacing it if it exists.
+     *
+     * @param file  The JSON file to write.
+     * @return      False if the file could not be opened.
+     */
+    bool start(const juce::File& file);
+
+    /**
+     * Stops recording, writes out everything still in the ring and closes the file.
+     */
+    void stop();
+
+    bool isRecording() const noexcept { return recording.load(std::memory_order_relaxed); }
+
+    /**
+     * Returns the memory held for the event ring, which is none until the first start().
+     */
+    juce::int64 getSizeInBytes() const { return (juce::int64)(events.size() * sizeof(Event)); }
+
+    /**
+     * Records a point in time, e.g. a source swap.
+     */
+    void recordInstant(const char* name, juce::int64 value = 0) noexcept;
+
+    /**
+     * Records the value of a counter, e.g. the governor's load.
+     */
+    void recordCounter(const char* name, double value) noexcept;
+
+    /**
+     * Returns the number of events dropped because the ring was full.
+     */
+    int getNumDropped() const noexcept { return dropped.load(); }
+
+private:
+    struct Event
+    {
+        const char* name = nullptr;
+        char phase = 'i';           // 'B'egin, 'E'nd, 'i'nstant or 'C'ounter
+        juce::int64 ticks = 0;
+        double value = 0.0;
+    };
+
+    std::atomic<bool> recording { false };
+    std::atomic<int> dropped { 0 };
+    juce::AbstractFifo fifo { capacity };
+    std::vector<Event> events;      // Allocated by the first start()
+
+    std::unique_ptr<juce::FileOutputStream> output;
+    juce::int64 startTicks = 0;
+
+    void record(const char* name, char phase, double value) noexcept;
+    void run() override;
+    void writePending();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TraceRecorder)
+};
@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+    WaveformDisplay.cpp
+    Created: 18 Oct 2026 9:51:22am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#include "WaveformDisplay.h"
+
+WaveformDisplay::WaveformDisplay(Hw5AudioProcessor& processor)
+    : audioProcessor(processor)
+{
+    setOpaque(true);
+    visibleGrains.reserve(maxVisibleGrains);
+    startTimerHz(refreshRateHz);
+}
+
+WaveformDisplay::~WaveformDisplay()
+{
+    stopTimer();
+}
+
+void WaveformDisplay::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    if (pyramid == nullptr)
+    {
+        g.setColour(juce::Colours::grey);
+        g.setFont(14.0f);
+        g.drawFittedText("No audio file loaded", getLocalBounds(), juce::Justification::centred, 1);
+        return;
+    }
+
+    g.drawImageAt(waveformImage, 0, 0);
+
+    // Overlay recent grains, fading them out as they age
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    const float height = (float)getHeight();
+
+    for (const auto& grain : visibleGrains)
+    {
+        const float age = (float)((now - grain.spawnTimeMs) / grainFadeTimeMs);
+        const float startX = sampleToX(grain.event.startSample);
+        const float endX = sampleToX(grain.event.startSample + grain.event.length);
+
+        if (age >= 1.0f || endX < 0.0f || startX > (float)getWidth())
+            continue;
+
+        g.setColour(juce::Colours::orange.withAlpha(0.5f * (1.0f - age)));
+        g.fillRect(startX, 0.0f, juce::jmax(1.0f, endX - startX), height);
+    }
+}
+
+void WaveformDisplay::resized()
+{
+    renderWaveform();
+}
+
+void WaveformDisplay::mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel)
+{
+    if (pyramid == nullptr || visibleRange.isEmpty())
+        return;
+
+    const double anchor = xToSample(event.position.x);
+    const double zoom = std::pow(2.0, -wheel.deltaY * 4.0);
+    const double totalSamples = pyramid->getNumSourceSamples();
+
+    // Don't zoom in further than one sample per pixel, or out past the whole
+    // source, even when the source has fewer samples than there are pixels
+    const double minLength = juce::jmin((double)juce::jmax(1, getWidth()), totalSamples);
+    const double newLength = juce::jlimit(minLength, totalSamples, visibleRange.getLength() * zoom);
+    const double anchorProportion = (anchor - visibleRange.getStart()) / visibleRange.getLength();
+    const double newStart = juce::jlimit(0.0, totalSamples - newLength, anchor - anchorProportion * newLength);
+
+    visibleRange = { newStart, newStart + newLength };
+    renderWaveform();
+    repaint();
+}
+
+void WaveformDisplay::mouseDoubleClick(const juce::MouseEvent&)
+{
+    if (pyramid == nullptr)
+        return;
+
+    visibleRange = { 0.0, (double)pyramid->getNumSourceSamples() };
+    renderWaveform();
+    repaint();
+}
+
+void WaveformDisplay::timerCallback()
+{
+    auto latestPyramid = audioProcessor.getPeakPyramid();
+
+    bool needsRepaint = !visibleGrains.empty();
+
+    if (latestPyramid != pyramid)
+    {
+        pyramid = latestPyramid;
+        visibleRange = { 0.0, pyramid != nullptr ? (double)pyramid->getNumSourceSamples() : 0.0 };
+        visibleGrains.clear();
+        renderWaveform();
+        needsRepaint = true;
+    }
+
+    const double now = juce::Time::getMillisecondCounterHiRes();
+
+    // Drop grains that have faded out, then take whatever the audio thread has spawned since
+    visibleGrains.erase(std::remove_if(visibleGrains.begin(), visibleGrains.end(),
+        [now](const VisibleGrain& grain) { return now - grain.spawnTimeMs >= grainFadeTimeMs; }),
+        visibleGrains.end());
+
+    audioProcessor.getGrainActivity().popAll([this, now](const GrainActivityFifo::GrainEvent& event)
+    {
+        if (visibleGrains.size() >= maxVisibleGrains)
+            visibleGrains.erase(visibleGrains.begin());
+
+        visibleGrains.push_back({ event, now });
+    });
+
+    if (needsRepaint || !visibleGrains.empty())
+        repaint();
+}
+
+void WaveformDisplay::renderWaveform()
+{
+    const int width = getWidth();
+    const int height = getHeight();
+
+    if (pyramid == nullptr || width <= 0 || height <= 0)
+    {
+        waveformImage = {};
+        return;
+    }
+
+    waveformImage = juce::Image(juce::Image::ARGB, width, height, true);
+    juce::Graphics g(waveformImage);
+    g.setColour(juce::Colours::lightblue);
+
+    const float halfHeight = (float)height * 0.5f;
+
+    for (int x = 0; x < width; ++x)
+    {
+        const auto peaks = pyramid->getPeakRange(xToSample((float)x), xToSample((float)(x + 1)));
+        const float top = halfHeight - juce::jlimit(-1.0f, 1.0f, peaks.getEnd()) * halfHeight;
+        const float bottom = halfHeight - juce::jlimit(-1.0f, 1.0f, peaks.getStart()) * halfHeight;
+        g.drawVerticalLine(x, top, juce::jmax(top + 1.0f, bottom));
+    }
+}
+
+float WaveformDisplay::sampleToX(double sample) const
+{
+    if (visibleRange.isEmpty())
+        return 0.0f;
+
+    return (float)((sample - visibleRange.getStart()) / visibleRange.getLength() * getWidth());
+}
+
+double WaveformDisplay::xToSample(float x) const
+{
+    if (getWidth() <= 0)
+        return visibleRange.getStart();
+
+    return visibleRange.getStart() + visibleRange.getLength() * x / getWidth();
+}
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    WaveformDisplay.h
+    Created: 18 Oct 2026 9:51:22am
+    Author:  David Matthew Welch
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+/**
+ * Draws the loaded source's waveform from its peak pyramid, with the grains
+ * spawned by the audio thread overlaid on top.
+ *
+ * The display never touches the engine's audio data: the waveform comes from the
+ * processor's PeakPyramid and grain positions arrive through the lock-free
+ * GrainActivityFifo, which is drained on a 60 Hz timer.
+ */
+class WaveformDisplay : public juce::Component,
+                        private juce::Timer
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param processor  The processor whose source and grains are displayed.
+     */
+    explicit WaveformDisplay(Hw5AudioProcessor& processor);
+
+    /**
+     * Destructor.
+     */
+    ~WaveformDisplay() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+    /**
+     * Zooms the view in or out around the mouse position.
+     */
+    void mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails&) override;
+
+    /**
+     * Resets the view to show the whole source.
+     */
+    void mouseDoubleClick(const juce::MouseEvent&) override;
+
+private:
+    struct VisibleGrain
+    {
+        GrainActivityFifo::GrainEvent event;
+        double spawnTimeMs = 0.0;
+    };
+
+    static constexpr int refreshRateHz = 60;
+    static constexpr double grainFadeTimeMs = 400.0;
+    static constexpr size_t maxVisibleGrains = 512;
+
+    Hw5AudioProcessor& audioProcessor;
+
+    PeakPyramid::Ptr pyramid;                   // The pyramid currently being displayed
+    juce::Range<double> visibleRange;           // Source samples currently in view
+    juce::Image waveformImage;                  // Cached rendering of the waveform at the current zoom
+    std::vector<VisibleGrain> visibleGrains;    // Recently spawned grains, oldest first
+
+    void timerCallback() override;
+
+    /**
+     * Redraws the cached waveform image from the pyramid.
+     */
+    void renderWaveform();
+
+    float sampleToX(double sample) const;
+    double xToSample(float x) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformDisplay)
+};